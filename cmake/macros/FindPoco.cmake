@@ -50,6 +50,7 @@ IF ( UNIX )
     
     set (LIB_DATA "PocoData")
     set (LIB_DATA_MYSQL "PocoDataMysql")
+    set (LIB_DATA_SQLITE "PocoDataSQLite")
     set (LIB_FOUNDATION "PocoFoundation")
     set (LIB_NET "PocoNet")
     set (LIB_XML "PocoXML")
@@ -94,6 +95,20 @@ FIND_LIBRARY(LIB_DATA_DEBUG
 #    ${POCO_LIBRARIES_DIR}
 #)
 
+FIND_LIBRARY(LIB_DATA_SQLITE_RELEASE
+  NAMES
+    PocoDataSQLite${POCO_LIBRARIES_EXT} ${LIB_DATA_SQLITE} 
+  PATHS
+    ${POCO_LIBRARIES_DIR}
+)
+
+FIND_LIBRARY(LIB_DATA_SQLITE_DEBUG
+  NAMES
+    PocoDataSQLite${POCO_LIBRARIES_EXT}d ${LIB_DATA_SQLITE}  
+  PATHS
+    ${POCO_LIBRARIES_DIR}
+)
+
 FIND_LIBRARY(LIB_MONGODB_RELEASE
   NAMES
     PocoMongoDB${POCO_LIBRARIES_EXT} ${LIB_MONGODB} 
@@ -154,6 +169,7 @@ IF ( UNIX )
     set( POCO_LIBRARIES
         ${LIB_DATA_RELEASE} 
         #${LIB_DATA_MYSQL_RELEASE} 
+        ${LIB_DATA_SQLITE_RELEASE}
 		${LIB_MONGODB_RELEASE}
         ${LIB_FOUNDATION_RELEASE} 
         ${LIB_NET_RELEASE}
@@ -162,13 +178,14 @@ IF ( UNIX )
 else ()
     if( CMAKE_CONFIGURATION_TYPES OR CMAKE_BUILD_TYPE )
       set( POCO_LIBRARIES
-        optimized ${LIB_DATA_RELEASE} optimized ${LIB_MONGODB_RELEASE} optimized ${LIB_FOUNDATION_RELEASE} optimized ${LIB_NET_RELEASE} optimized ${LIB_XML_RELEASE}
-        debug ${LIB_DATA_DEBUG} debug ${LIB_MONGODB_DEBUG} debug ${LIB_FOUNDATION_DEBUG} debug ${LIB_NET_DEBUG} debug ${LIB_XML_DEBUG}
+        optimized ${LIB_DATA_RELEASE} optimized ${LIB_DATA_SQLITE_RELEASE} optimized ${LIB_MONGODB_RELEASE} optimized ${LIB_FOUNDATION_RELEASE} optimized ${LIB_NET_RELEASE} optimized ${LIB_XML_RELEASE}
+        debug ${LIB_DATA_DEBUG} debug ${LIB_DATA_SQLITE_DEBUG} debug ${LIB_MONGODB_DEBUG} debug ${LIB_FOUNDATION_DEBUG} debug ${LIB_NET_DEBUG} debug ${LIB_XML_DEBUG}
       )
     else()
       set( POCO_LIBRARIES
         ${LIB_DATA_RELEASE} 
         #${LIB_DATA_MYSQL_RELEASE} 
+        ${LIB_DATA_SQLITE_RELEASE}
 		${LIB_MONGODB_RELEASE}
         ${LIB_FOUNDATION_RELEASE} 
         ${LIB_NET_RELEASE}
@@ -179,6 +196,7 @@ endif()
 
 MARK_AS_ADVANCED(LIB_DATA_RELEASE)
 MARK_AS_ADVANCED(LIB_DATA_MYSQL_RELEASE)
+MARK_AS_ADVANCED(LIB_DATA_SQLITE_RELEASE)
 MARK_AS_ADVANCED(LIB_MONGODB_RELEASE)
 MARK_AS_ADVANCED(LIB_FOUNDATION_RELEASE)
 MARK_AS_ADVANCED(LIB_NET_RELEASE)    
@@ -186,6 +204,7 @@ MARK_AS_ADVANCED(LIB_XML_RELEASE)
 
 MARK_AS_ADVANCED(LIB_DATA_DEBUG)
 MARK_AS_ADVANCED(LIB_DATA_MYSQL_DEBUG)
+MARK_AS_ADVANCED(LIB_DATA_SQLITE_DEBUG)
 MARK_AS_ADVANCED(LIB_MONGODB_DEBUG)
 MARK_AS_ADVANCED(LIB_FOUNDATION_DEBUG)
 MARK_AS_ADVANCED(LIB_NET_DEBUG)    
@@ -0,0 +1,10 @@
+-- Auth database schema for the SQLite backend
+-- Run automatically on startup, existing tables are kept
+
+CREATE TABLE IF NOT EXISTS account (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    username TEXT NOT NULL UNIQUE,
+    password TEXT NOT NULL,
+    sid TEXT NOT NULL DEFAULT '',
+    online INTEGER NOT NULL DEFAULT 0
+);
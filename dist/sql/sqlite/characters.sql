@@ -0,0 +1,26 @@
+-- Characters database schema for the SQLite backend
+-- Run automatically on startup, existing tables are kept
+
+CREATE TABLE IF NOT EXISTS characters (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    account INTEGER NOT NULL,
+    name TEXT NOT NULL UNIQUE,
+    model INTEGER NOT NULL DEFAULT 0,
+    guid INTEGER NOT NULL DEFAULT 0,
+    x REAL NOT NULL DEFAULT 0,
+    y REAL NOT NULL DEFAULT 0,
+    maxhp INTEGER NOT NULL DEFAULT 100,
+    hp INTEGER NOT NULL DEFAULT 100,
+    maxmp INTEGER NOT NULL DEFAULT 100,
+    mp INTEGER NOT NULL DEFAULT 100,
+    lvl INTEGER NOT NULL DEFAULT 1
+);
+
+CREATE INDEX IF NOT EXISTS characters_account ON characters (account);
+
+CREATE TABLE IF NOT EXISTS inventory (
+    pid INTEGER NOT NULL,
+    slot INTEGER NOT NULL,
+    item_id INTEGER NOT NULL,
+    PRIMARY KEY (pid, slot)
+);
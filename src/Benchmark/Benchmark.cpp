@@ -0,0 +1,244 @@
+/**
+ * Runs the world headless, without database nor sockets, on a population
+ * given by a seed, and reports how long its ticks take. Builds are compared
+ * by running them with the same arguments:
+ *
+ *  Benchmark --seed 1 --players 1000 --creatures 4000 --pattern random --ticks 1000
+ *
+ * Ticks are measured once the whole population has been spawned, after the
+ * warmup ticks, and always advance the world by the same diff
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "Poco/File.h"
+#include "Poco/Timestamp.h"
+
+#include "AuthDatabase.h"
+#include "CharactersDatabase.h"
+#include "GridLoader.h"
+#include "Log.h"
+#include "ObjectManager.h"
+#include "Server.h"
+#include "ServerConfig.h"
+#include "Spawner.h"
+
+Server* sServer = NULL;
+
+AuthDatabaseConnection AuthDatabase;
+CharactersDatabaseConnection CharactersDatabase;
+
+// Every allocation, on any thread, is counted
+static std::atomic<Poco::UInt64> Allocations(0);
+static std::atomic<Poco::UInt64> AllocatedBytes(0);
+
+void* operator new(std::size_t size)
+{
+    Allocations.fetch_add(1, std::memory_order_relaxed);
+    AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (void* memory = malloc(size ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) throw()
+{
+    free(memory);
+}
+
+void operator delete[](void* memory) throw()
+{
+    free(memory);
+}
+
+struct Options
+{
+    Poco::UInt32 seed;
+    Poco::UInt32 players;
+    Poco::UInt32 creatures;
+    Spawner::Pattern pattern;
+    Poco::UInt32 spawnRate;
+    Poco::UInt32 ticks;
+    Poco::UInt32 warmup;
+    Poco::UInt32 diff;
+};
+
+struct TickSample
+{
+    Poco::Timestamp::TimeDiff total;
+    Poco::Timestamp::TimeDiff simulate;
+    Poco::Timestamp::TimeDiff flush;
+    Poco::Timestamp::TimeDiff swap;
+    Poco::Timestamp::TimeDiff collect;
+    Poco::UInt64 allocations;
+    Poco::UInt64 allocatedBytes;
+    Poco::UInt32 packets;
+};
+
+static bool parseOptions(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (i + 1 >= argc)
+            return false;
+
+        std::string name(argv[i]);
+        const char* value = argv[++i];
+
+        if (name == "--pattern")
+        {
+            if (!Spawner::findPattern(value, options.pattern))
+                return false;
+            continue;
+        }
+
+        Poco::UInt32 number = (Poco::UInt32)strtoul(value, NULL, 10);
+        if (name == "--seed")
+            options.seed = number;
+        else if (name == "--players")
+            options.players = number;
+        else if (name == "--creatures")
+            options.creatures = number;
+        else if (name == "--spawn-rate" && number)
+            options.spawnRate = number;
+        else if (name == "--ticks" && number)
+            options.ticks = number;
+        else if (name == "--warmup")
+            options.warmup = number;
+        else if (name == "--diff")
+            options.diff = number;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+template <typename T>
+static T percentile(std::vector<T> values, float percent)
+{
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)(percent / 100.0f * (values.size() - 1) + 0.5f);
+    return values[index];
+}
+
+/**
+ * Prints the average, p50, p99 and max of a tick phase, in miliseconds
+ *
+ * @param name Phase name
+ * @param samples Ticks measured
+ * @param member Phase time on each tick
+ */
+static void printPhase(const char* name, const std::vector<TickSample>& samples, Poco::Timestamp::TimeDiff TickSample::*member)
+{
+    std::vector<Poco::Timestamp::TimeDiff> values;
+    Poco::Timestamp::TimeDiff total = 0;
+    for (std::vector<TickSample>::const_iterator itr = samples.begin(); itr != samples.end(); ++itr)
+    {
+        values.push_back((*itr).*member);
+        total += (*itr).*member;
+    }
+
+    printf("%-10s avg %8.3f  p50 %8.3f  p99 %8.3f  max %8.3f ms\n", name,
+        total / (double)values.size() / 1000.0,
+        percentile(values, 50) / 1000.0,
+        percentile(values, 99) / 1000.0,
+        *std::max_element(values.begin(), values.end()) / 1000.0);
+}
+
+int main(int argc, char* argv[])
+{
+    Options options = {1, 1000, 4000, Spawner::PATTERN_RANDOM, 50, 1000, 10, 50};
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "Usage: %s [--seed N] [--players N] [--creatures N] [--pattern line|random|cluster]\n"
+            "       [--spawn-rate N] [--ticks N] [--warmup N] [--diff ms]\n", argv[0]);
+        return 1;
+    }
+
+    // Only the lines of the world itself are of interest
+    sLog.setLogLevel(Message::PRIO_WARNING);
+
+    // Grid threads and ranges come from the configuration, if there is one
+    if (Poco::File("Config.xml").exists())
+        sConfig.readConfiguration();
+
+    // Builds the packets the grids send, there are no clients to send them to
+    sServer = new Server();
+    sGridLoader.instance();
+
+    Spawner spawner(options.players, options.creatures, options.pattern, options.seed, options.spawnRate);
+    Poco::UInt32 spawnTicks = 0;
+    while (!spawner.isDone())
+    {
+        spawner.spawn();
+        sGridLoader.update(options.diff);
+        sObjectManager.collect();
+        ++spawnTicks;
+    }
+
+    std::vector<TickSample> samples;
+    samples.reserve(options.ticks);
+
+    for (Poco::UInt32 tick = 0; tick < options.warmup + options.ticks; ++tick)
+    {
+        TickSample sample;
+        Poco::UInt64 allocations = Allocations.load(std::memory_order_relaxed);
+        Poco::UInt64 allocatedBytes = AllocatedBytes.load(std::memory_order_relaxed);
+
+        Poco::Timestamp start;
+        sGridLoader.update(options.diff);
+
+        Poco::Timestamp collect;
+        sObjectManager.collect();
+        sample.collect = collect.elapsed();
+        sample.total = start.elapsed();
+
+        const GridLoader::UpdateStats& stats = sGridLoader.getUpdateStats();
+        sample.simulate = stats.simulate;
+        sample.flush = stats.flush;
+        sample.swap = stats.swap;
+        sample.packets = stats.packets;
+        sample.allocations = Allocations.load(std::memory_order_relaxed) - allocations;
+        sample.allocatedBytes = AllocatedBytes.load(std::memory_order_relaxed) - allocatedBytes;
+
+        if (tick >= options.warmup)
+            samples.push_back(sample);
+    }
+
+    Poco::UInt64 allocations = 0;
+    Poco::UInt64 allocatedBytes = 0;
+    Poco::UInt64 packets = 0;
+    for (std::vector<TickSample>::iterator itr = samples.begin(); itr != samples.end(); ++itr)
+    {
+        allocations += itr->allocations;
+        allocatedBytes += itr->allocatedBytes;
+        packets += itr->packets;
+    }
+
+    printf("seed %u, %u players, %u creatures, spawned in %u ticks, %u ticks of %u ms measured\n",
+        options.seed, options.players, options.creatures, spawnTicks, options.ticks, options.diff);
+    printf("grids %u\n", sGridLoader.getUpdateStats().grids);
+    printPhase("tick", samples, &TickSample::total);
+    printPhase("simulate", samples, &TickSample::simulate);
+    printPhase("flush", samples, &TickSample::flush);
+    printPhase("swap", samples, &TickSample::swap);
+    printPhase("collect", samples, &TickSample::collect);
+    printf("allocations %.1f per tick, %.1f KB per tick\n", allocations / (double)samples.size(), allocatedBytes / (double)samples.size() / 1024.0);
+    printf("packets %.1f per tick, %llu total\n", packets / (double)samples.size(), (unsigned long long)packets);
+
+    return 0;
+}
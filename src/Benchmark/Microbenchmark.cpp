@@ -0,0 +1,526 @@
+/**
+ * Times the hot paths of the server one by one, and prints one JSON object
+ * per line, so the output of two builds can be diffed as it is:
+ *
+ *  Microbenchmark --filter packet --min-time 500 > before.json
+ *
+ * Each case is run in batches large enough for the clock resolution not to
+ * matter, until it has been running for the minimum time
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Poco/File.h"
+#include "Poco/Runnable.h"
+#include "Poco/Thread.h"
+#include "Poco/Timespan.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Net/ServerSocket.h"
+#include "Poco/Net/SocketAddress.h"
+
+#include "AuthDatabase.h"
+#include "CharactersDatabase.h"
+#include "Client.h"
+#include "Grid.h"
+#include "GridLoader.h"
+#include "Log.h"
+#include "MotionMaster.h"
+#include "Object.h"
+#include "ObjectManager.h"
+#include "Packet.h"
+#include "Position.h"
+#include "Sector.h"
+#include "Server.h"
+#include "ServerConfig.h"
+#include "Trace.h"
+
+using Poco::Net::ServerSocket;
+using Poco::Net::SocketAddress;
+
+//@ Any opcode will do, packets sent here are never read
+#define MICROBENCHMARK_OPCODE 0x5201
+//@ Where objects are placed, far enough from the grid borders for every
+//@ near sector to be on the same grid
+#define MICROBENCHMARK_POSITION Vector2D(1250, 1250)
+//@ Where moving objects are placed, on a grid of their own
+#define MICROBENCHMARK_MOVERS_POSITION Vector2D(750, 750)
+
+Server* sServer = NULL;
+
+AuthDatabaseConnection AuthDatabase;
+CharactersDatabaseConnection CharactersDatabase;
+
+static Poco::UInt32 MinTime = 200;
+static std::string Filter;
+
+// Results are added here so the compiler can not drop the work producing them
+static volatile Poco::UInt64 Sink = 0;
+
+/**
+ * Runs a case and prints its result
+ *
+ * @param name Case name, stable between commits
+ * @param run Runs the case a given number of times
+ */
+template <typename Run>
+static void measure(const std::string& name, Run run)
+{
+    if (!Filter.empty() && name.find(Filter) == std::string::npos)
+        return;
+
+    // Grows the batch until it takes at least a milisecond
+    Poco::UInt64 batch = 1;
+    for (;;)
+    {
+        Poco::Timestamp start;
+        run(batch);
+        if (start.elapsed() >= 1000 || batch >= (1 << 30))
+            break;
+
+        batch <<= 1;
+    }
+
+    Poco::UInt64 iterations = 0;
+    Poco::Timestamp::TimeDiff elapsed = 0;
+    Poco::Timestamp start;
+    while (elapsed < (Poco::Timestamp::TimeDiff)MinTime * 1000)
+    {
+        run(batch);
+        iterations += batch;
+        elapsed = start.elapsed();
+    }
+
+    printf("{\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f}\n",
+        name.c_str(), (unsigned long long)iterations, elapsed * 1000.0 / iterations);
+    fflush(stdout);
+}
+
+static Object* createCreature(Vector2D position)
+{
+    Object* creature = sObjectManager.create(HIGH_GUID_CREATURE);
+    creature->Relocate(position);
+    return creature;
+}
+
+static void measurePacket()
+{
+    std::string name("Microbenchmark16");
+
+    measure("packet.uint32x64", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            Packet packet(MICROBENCHMARK_OPCODE, 64 * sizeof(Poco::UInt32));
+            for (Poco::UInt32 j = 0; j < 64; ++j)
+                packet << j;
+
+            Sink += packet.rawdata[0];
+        }
+    });
+
+    measure("packet.floatx64", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            Packet packet(MICROBENCHMARK_OPCODE, 64 * sizeof(float));
+            for (Poco::UInt32 j = 0; j < 64; ++j)
+                packet << (float)j;
+
+            Sink += packet.rawdata[0];
+        }
+    });
+
+    measure("packet.stringx8", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            Packet packet(MICROBENCHMARK_OPCODE, 8 * (sizeof(Poco::UInt16) + name.length()));
+            for (Poco::UInt32 j = 0; j < 8; ++j)
+                packet << name;
+
+            Sink += packet.rawdata[0];
+        }
+    });
+}
+
+static void measureSpawnPacket(Object* idle, Object* moving)
+{
+    measure("server.build_spawn_packet.idle", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            Packet* packet = sServer->buildSpawnPacket(idle);
+            Sink += packet->len;
+            delete packet;
+        }
+    });
+
+    measure("server.build_spawn_packet.moving", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            Packet* packet = sServer->buildSpawnPacket(moving);
+            Sink += packet->len;
+            delete packet;
+        }
+    });
+}
+
+/**
+ * Adds and removes an object to a sector with a given population, joining
+ * every near sector, and crosses it back and forth to a neighbour, joining
+ * and leaving only the sectors on each side
+ */
+static void measureSector(Grid& grid, Poco::UInt32 population)
+{
+    Object* object = createCreature(MICROBENCHMARK_POSITION);
+    Sector* sector = grid.getOrLoadSector(object->GetPosition().sector);
+    Sector* neighbour = grid.getOrLoadSector(sector->hashCode() + (1 << 8));
+
+    std::vector<Object*> others;
+    for (Poco::UInt32 i = 0; i < population; ++i)
+    {
+        others.push_back(createCreature(MICROBENCHMARK_POSITION));
+        sector->add(others.back());
+    }
+
+    std::string suffix = "." + std::to_string((unsigned long long)population);
+
+    measure("sector.add_remove" + suffix, [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            sector->add(object);
+            sector->remove(object);
+        }
+
+        // Events are freed as they would be on the next two ticks
+        grid.swapBuffers();
+        grid.swapBuffers();
+    });
+
+    Poco::UInt8 forwardX = 1, forwardY = 0;
+    Poco::UInt8 backX = 0xFF, backY = 0;
+    sector->add(object);
+
+    measure("sector.cross" + suffix, [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            neighbour->add(object, &forwardX, &forwardY);
+            sector->remove_i(object, &forwardX, &forwardY);
+            sector->add(object, &backX, &backY);
+            neighbour->remove_i(object, &backX, &backY);
+        }
+
+        grid.swapBuffers();
+        grid.swapBuffers();
+    });
+
+    sector->remove(object);
+    for (std::vector<Object*>::iterator itr = others.begin(); itr != others.end(); ++itr)
+        sector->remove(*itr);
+
+    grid.swapBuffers();
+    grid.swapBuffers();
+}
+
+static void measurePosition()
+{
+    std::mt19937 random(1);
+    std::vector<Vector2D> positions;
+    for (Poco::UInt32 i = 0; i < 1024; ++i)
+        positions.push_back(Vector2D(MAP_MIN_X + int(random() % (MAP_MAX_X - MAP_MIN_X)), MAP_MIN_Z + int(random() % (MAP_MAX_Z - MAP_MIN_Z))));
+
+    Poco::UInt32 next = 0;
+    measure("vector2d.process", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            Vector2D& position = positions[next++ & 1023];
+            position.Process();
+            Sink += position.sector;
+        }
+    });
+}
+
+static void measureMotionMaster(const std::vector<Object*>& movers)
+{
+    Poco::UInt32 next = 0;
+    measure("motionmaster.evaluate", [&](Poco::UInt64 count) -> void
+    {
+        Vector2D position;
+        bool crossed;
+
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            Sink += movers[next++ % movers.size()]->motionMaster.evaluate(position, crossed);
+            Sink += (Poco::UInt64)position.x;
+        }
+    });
+}
+
+static void measureTrace()
+{
+    measure("trace.scope", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            TRACE_SCOPE("Microbenchmark");
+            Sink += i;
+        }
+    });
+
+    // Disabled, a scope is left with checking the flag
+    sTrace.setBufferSize(0);
+    measure("trace.scope.disabled", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            TRACE_SCOPE("Microbenchmark");
+            Sink += i;
+        }
+    });
+    sTrace.setBufferSize(65536);
+}
+
+static inline void insertObject(TypeObjectsMap& map, Poco::UInt64 guid, Object* object)
+{
+    map.insert(rde::make_pair(guid, object));
+}
+
+template <typename Map>
+static inline void insertObject(Map& map, Poco::UInt64 guid, Object* object)
+{
+    map.insert(std::make_pair(guid, object));
+}
+
+/**
+ * Times a sector objects map, as it is used, against other containers
+ *
+ * @param name Container name
+ * @param population Objects already on the map
+ */
+template <typename Map>
+static void measureObjectsMap(const std::string& name, Poco::UInt32 population)
+{
+    std::vector<Poco::UInt64> guids;
+    for (Poco::UInt32 i = 1; i <= population; ++i)
+        guids.push_back(MAKE_GUID(HIGH_GUID_CREATURE, i));
+
+    Map map;
+    for (std::vector<Poco::UInt64>::iterator itr = guids.begin(); itr != guids.end(); ++itr)
+        insertObject(map, *itr, NULL);
+
+    Poco::UInt64 absent = MAKE_GUID(HIGH_GUID_CREATURE, population + 1);
+    std::string prefix = "objects_map." + name + "." + std::to_string((unsigned long long)population);
+
+    measure(prefix + ".insert_erase", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            insertObject(map, absent, NULL);
+            map.erase(absent);
+        }
+    });
+
+    Poco::UInt32 next = 0;
+    measure(prefix + ".find", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            Sink += map.find(guids[next]) != map.end();
+            if (++next == population)
+                next = 0;
+        }
+    });
+
+    // One operation is a whole pass, as done on each sector update
+    measure(prefix + ".iterate", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+            for (typename Map::iterator itr = map.begin(); itr != map.end(); ++itr)
+                Sink += itr->first;
+    });
+}
+
+/**
+ * Reads everything sent to a client, for its socket never to fill up
+ */
+class SocketDrain : public Poco::Runnable
+{
+public:
+    SocketDrain(StreamSocket& socket):
+        _socket(socket), _running(true)
+    {
+        _socket.setReceiveTimeout(Poco::Timespan(0, 100000));
+    }
+
+    void run()
+    {
+        char buffer[65536];
+        while (_running)
+        {
+            try
+            {
+                if (_socket.receiveBytes(buffer, sizeof(buffer)) <= 0)
+                    break;
+            }
+            catch (Poco::TimeoutException&)
+            {
+            }
+        }
+    }
+
+    void stop()
+    {
+        _running = false;
+    }
+
+private:
+    StreamSocket& _socket;
+    volatile bool _running;
+};
+
+/**
+ * Sends packets to a client connected through loopback, first as it is
+ * before its handshake and then with its security set up. Packets are
+ * freed when sent, so each one is built again; packet.client times only
+ * building them
+ */
+static void measureClient()
+{
+    ServerSocket listener(SocketAddress("127.0.0.1", 0));
+    StreamSocket peer;
+    peer.connect(listener.address());
+    StreamSocket socket = listener.acceptConnection();
+
+    // The client would be disconnected on a reactor time out
+    SocketReactor reactor(Poco::Timespan(3600, 0));
+    Poco::Thread reactorThread;
+    reactorThread.start(reactor);
+
+    SocketDrain drain(peer);
+    Poco::Thread drainThread;
+    drainThread.start(drain);
+
+    Client* client = new Client(socket, reactor);
+
+    measure("packet.client", [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            Packet* packet = new Packet(MICROBENCHMARK_OPCODE, 16 * sizeof(Poco::UInt32));
+            for (Poco::UInt32 j = 0; j < 16; ++j)
+                *packet << j;
+
+            Sink += packet->len;
+            delete packet;
+        }
+    });
+
+    bool encrypt = false;
+    bool hmac = false;
+    auto send = [&](Poco::UInt64 count) -> void
+    {
+        for (Poco::UInt64 i = 0; i < count; ++i)
+        {
+            Packet* packet = new Packet(MICROBENCHMARK_OPCODE, 16 * sizeof(Poco::UInt32));
+            for (Poco::UInt32 j = 0; j < 16; ++j)
+                *packet << j;
+
+            client->sendPacket(packet, encrypt, hmac);
+        }
+    };
+
+    measure("client.send.plain", send);
+
+    client->SetupSecurity();
+    hmac = true;
+    measure("client.send.hmac", send);
+
+    encrypt = true;
+    measure("client.send.aes_hmac", send);
+
+    // Wakes the reactor up, for it to see it has been stopped
+    reactor.stop();
+    send(1);
+    reactorThread.join();
+
+    drain.stop();
+    drainThread.join();
+
+    delete client;
+}
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string name(argv[i]);
+        if (i + 1 < argc && name == "--filter")
+            Filter = argv[++i];
+        else if (i + 1 < argc && name == "--min-time")
+            MinTime = std::max((Poco::UInt32)strtoul(argv[++i], NULL, 10), 1u);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--filter substring] [--min-time ms]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    sLog.setLogLevel(Message::PRIO_WARNING);
+
+    // Ranges come from the configuration, if there is one
+    if (Poco::File("Config.xml").exists())
+        sConfig.readConfiguration();
+
+    sServer = new Server();
+    sGridLoader.instance();
+
+    Vector2D position = MICROBENCHMARK_POSITION;
+    position.Process();
+    Grid grid(position.gridX, position.gridY);
+
+    Vector2D moversPosition = MICROBENCHMARK_MOVERS_POSITION;
+    moversPosition.Process();
+    Grid moversGrid(moversPosition.gridX, moversPosition.gridY);
+
+    Object* idle = createCreature(MICROBENCHMARK_POSITION);
+    std::vector<Object*> movers;
+    for (Poco::UInt32 i = 0; i < 1024; ++i)
+    {
+        Object* mover = createCreature(MICROBENCHMARK_MOVERS_POSITION);
+        moversGrid.addObject(mover);
+        MotionMaster::StartAngleMovement(mover, i * 0.01f, SPEED_WALK);
+        movers.push_back(mover);
+    }
+
+    measurePacket();
+    measureSpawnPacket(idle, movers.front());
+
+    measureSector(grid, 0);
+    measureSector(grid, 64);
+
+    measurePosition();
+    measureMotionMaster(movers);
+    measureTrace();
+
+    measureObjectsMap<TypeObjectsMap>("rde_hash_map", 64);
+    measureObjectsMap<std::unordered_map<Poco::UInt64, Object*> >("unordered_map", 64);
+    measureObjectsMap<std::map<Poco::UInt64, Object*> >("map", 64);
+    measureObjectsMap<TypeObjectsMap>("rde_hash_map", 1024);
+    measureObjectsMap<std::unordered_map<Poco::UInt64, Object*> >("unordered_map", 1024);
+    measureObjectsMap<std::map<Poco::UInt64, Object*> >("map", 1024);
+
+    measureClient();
+
+    return 0;
+}
@@ -2,15 +2,20 @@
 
 #include "AuthDatabase.h"
 #include "CharactersDatabase.h"
+#include "CharacterStore.h"
 #include "Grid.h"
 #include "Log.h"
 #include "ObjectManager.h"
+#include "OnlineStatusBuffer.h"
 #include "Packet.h"
 #include "Player.h"
 #include "Position.h"
 #include "Server.h"
+#include "StatementJob.h"
 #include "Tools.h"
 
+#include <vector>
+
 // Packet reading steps
 enum PACKET_READING_STEPS
 {
@@ -34,9 +39,13 @@ Client::Client(StreamSocket& socket, SocketReactor& reactor):
     _player(NULL),
     _logicFlags(0),
     _logged(false), _inWorld(false), _id(0),
+    _detached(false),
 	_writeBufferOut(BUFFER_SIZE, true)
 {
-    sLog.out(Message::PRIO_INFORMATION, "Connection from " + socket.peerAddress().toString());
+    LOG_OUT(LOG_NET, Message::PRIO_INFORMATION, "Connection from %s", socket.peerAddress().toString().c_str());
+
+    // Database callbacks find us through the server
+    _connection = sServer->registerClient(this);
 
     // Set reactor handlers
     _reactor.addEventHandler(_socket, NObserver<Client, ReadableNotification>(*this, &Client::onReadable));
@@ -52,67 +61,88 @@ Client::Client(StreamSocket& socket, SocketReactor& reactor):
  */
 Client::~Client()
 {
-    sLog.out(Message::PRIO_DEBUG, "Disconnect flags: %d", _logicFlags & ~DISCONNECT_READY);
+    LOG_OUT(LOG_NET, Message::PRIO_DEBUG, "Disconnect flags: %d", _logicFlags & ~DISCONNECT_READY);
 
+    sServer->unregisterClient(_connection);
     _player = NULL;
     if (_packetStep != Poco::UInt8(STEP_NEW_PACKET))
         delete _packet;
 
+    detach();
+}
+
+/**
+ * Disconnects the client. Broadcast workers may still be flushing the
+ * previous tick packets to it, so it is only deleted on the next tick
+ * boundary, as objects are
+ */
+void Client::destroy()
+{
+    detach();
+    sServer->destroyClient(this);
+}
+
+/**
+ * Stops the reactor from calling us and closes the socket, packets sent
+ * from then on are dropped
+ */
+void Client::detach()
+{
+    {
+        Poco::ScopedWriteRWLock lock(_writeLock);
+        if (_detached)
+            return;
+
+        _detached = true;
+    }
+
     _reactor.removeEventHandler(_socket, NObserver<Client, ReadableNotification>(*this, &Client::onReadable));
 	_reactor.removeEventHandler(_socket, NObserver<Client, ShutdownNotification>(*this, &Client::onShutdown));
 	_reactor.removeEventHandler(_socket, NObserver<Client, TimeoutNotification>(*this, &Client::onTimeout));
+    _reactor.removeEventHandler(_socket, NObserver<Client, WritableNotification>(*this, &Client::onWritable));
     
     _socket.close();
 }
 
 /**
  * Called when a client connects and enters the world. The player (entity) is
- * created at this step
+ * created at this step, once the character has been loaded
  *
- * @param GUID User unique online ID
- * @param characterID Which of the users in the character list is selected
- * @return Player created entity
+ * @param record Selected character state, from the character store
+ * @return Player created entity, NULL if the character is already played
  */
-SharedPtr<Player> Client::onEnterToWorld(Poco::UInt32 characterID)
+Player* Client::onEnterToWorld(const CharacterRecord& record)
 {
-    Characters* character = FindCharacter(characterID);
-    if (!character)
+    Characters character;
+    if (!FindCharacter(record.id, character))
         return NULL;
 
-    _characterId = characterID;
+    _characterId = record.id;
 
-    _player = sObjectManager.createPlayer(character->name, this);
-    if (_player.isNull())
+    _player = sObjectManager.createPlayer(character.name, this);
+    if (!_player)
         return NULL;
 
-    PreparedStatement* stmt = CharactersDatabase.getPreparedStatement(QUERY_CHARACTERS_SELECT_INFORMATION);
-    stmt->bindUInt32(0, characterID);
+    _player->Relocate(Vector2D(record.x, record.y));
+    _player->SetMaxHP(record.maxhp);
+    _player->SetHP(record.hp);
+    _player->SetMaxMP(record.maxmp);
+    _player->SetMP(record.mp);
+    _player->SetLVL(record.lvl);
 
-    RecordSet rs = stmt->execute();
-    if (rs.moveFirst())
-    {
-        //  0     1    2       3       4      5      6
-        // c.x, c.y, c.maxhp, c.hp, c.maxmp, c.mp, c.lvl        
-
-        _player->Relocate(Vector2D(rs[0].convert<float>(), rs[1].convert<float>()));
-        _player->SetMaxHP(rs[2].convert<Poco::UInt32>());
-        _player->SetHP(rs[3].convert<Poco::UInt32>());
-        _player->SetMaxMP(rs[4].convert<Poco::UInt32>());
-        _player->SetMP(rs[5].convert<Poco::UInt32>());
-        _player->SetLVL(rs[6].convert<Poco::UInt32>());
-        
-        stmt = CharactersDatabase.getPreparedStatement(QUERY_CHARACTERS_UPDATE_GUID);
-        stmt->bindUInt32(0, _player->GetLowGUID());
-        stmt->bindUInt32(1, characterID);
-        stmt->execute();
-    }
-    else
+    // From now on its changes are saved, unless another session is still
+    // playing the character
+    if (!sCharacterStore.attach(record.id, _player))
     {
+        LOG_OUT(LOG_SERVER, Message::PRIO_WARNING, "Character %u is already being played", record.id);
         sObjectManager.removeObject(_player->GetGUID());
         _player = NULL;
+        return NULL;
     }
+    
+    CharactersDatabase.enqueue(new StatementJob<CharactersUpdateGUID>(_player->GetLowGUID(), record.id));
 
-    sLog.out(Message::PRIO_DEBUG, "Player created at (%.2f, %.2f)", _player->GetPosition().x, _player->GetPosition().z);
+    LOG_OUT(LOG_SERVER, Message::PRIO_DEBUG, "Player created at (%.2f, %.2f)", _player->GetPosition().x, _player->GetPosition().z);
 
     return _player;
 }
@@ -135,9 +165,9 @@ void Client::onReadable(const AutoPtr<ReadableNotification>& nf)
 
         // If flags must be sent, do it now, otherwise delete ourselves
         if (_logicFlags & DISCONNECTED_INCORRECT_DATA)
-            sServer->SendClientDisconnected(this); // Will cause the disconnection
+            sServer->SendClientDisconnected(this, DISCONNECTED_INCORRECT_DATA); // Will cause the disconnection
         else
-            delete this;
+            destroy();
     }
     else
     {
@@ -221,7 +251,7 @@ void Client::onShutdown(const AutoPtr<ShutdownNotification>& nf)
 {
     nf->release();
     cleanupBeforeDelete();
-    delete this;
+    destroy();
 }
 
 /**
@@ -234,7 +264,7 @@ void Client::onTimeout(const AutoPtr<TimeoutNotification>& nf)
     nf->release();
     _logicFlags |= DISCONNECTED_TIME_OUT;
     cleanupBeforeDelete();
-    sServer->SendClientDisconnected(this);
+    sServer->SendClientDisconnected(this, DISCONNECTED_TIME_OUT);
 }
 
 /**
@@ -245,11 +275,16 @@ void Client::onTimeout(const AutoPtr<TimeoutNotification>& nf)
 void Client::onWritable(const AutoPtr<WritableNotification>& nf)
 {
     nf->release();
-    _reactor.removeEventHandler(_socket, NObserver<Client, WritableNotification>(*this, &Client::onWritable));
-    _socket.sendBytes(_writeBufferOut);
+
+    {
+        // The grids and broadcast workers write to the buffer meanwhile
+        Poco::ScopedWriteRWLock lock(_writeLock);
+        _reactor.removeEventHandler(_socket, NObserver<Client, WritableNotification>(*this, &Client::onWritable));
+        _socket.sendBytes(_writeBufferOut);
+    }
 
     if (_logicFlags & DISCONNECT_READY)
-        delete this;
+        destroy();
 }
 
 /**
@@ -258,18 +293,34 @@ void Client::onWritable(const AutoPtr<WritableNotification>& nf)
  */
 void Client::cleanupBeforeDelete()
 {
+    // Wait for any database callback using us, and avoid new ones
+    sServer->unregisterClient(_connection);
+
+    // A login still queued would be executed for nobody
+    if (!_logged)
+        sServer->leaveLoginQueue(_connection);
+
     if (_inWorld)
     {
-        // Stop movement if any
-        _player->motionMaster.clear();
-        _player->clearFlag(FLAGS_TYPE_MOVEMENT, FLAG_MOVING);
-        
+        // Keep its last state, it is saved and cached for a while. The
+        // store takes it between ticks, and then removes the player
+        bool released = sCharacterStore.release(_characterId);
+
+        // Its ticket can be used from now on, for a while
+        sServer->suspendSession(_id);
+
         // If we are on a Grid (it is spawned), remove us
         if (_player->IsOnGrid())
             _player->GetGrid()->removeObject(_player);
+
+        // Stop movement if any
+        _player->motionMaster.clear();
+        _player->clearFlag(FLAGS_TYPE_MOVEMENT, FLAG_MOVING);
         
-        // Delete from the server object list
-        sObjectManager.removeObject(_player->GetGUID());
+        // Delete from the server object list, it is destroyed between ticks
+        if (!released)
+            sObjectManager.removeObject(_player->GetGUID());
+        _player = NULL;
 
         // Flag it as not in world and not logged
         setInWorld(false);
@@ -277,16 +328,15 @@ void Client::cleanupBeforeDelete()
     }
         
     // Reset online status
-    PreparedStatement* stmt = AuthDatabase.getPreparedStatement(QUERY_AUTH_UPDATE_ONLINE);
-    stmt->bindInt8(0, 0);
-    stmt->bindUInt32(1, GetId());
-    stmt->execute();
+    if (GetId())
+        sOnlineStatus.setOnline(GetId(), false);
 
     _logicFlags |= DISCONNECT_READY;
 }
 
 /**
- * Adds a packet to the send list of the client
+ * Adds a packet to the send list of the client. Packets which are not deleted
+ * on send can be shared between clients, thus they are never modified
  *
  * @param packet The packet to be sent
  * @param encrypt Whether the packet must or not be encrypted
@@ -295,9 +345,26 @@ void Client::cleanupBeforeDelete()
 void Client::sendPacket(Packet* packet, bool encrypt, bool hmac)
 {
     // Log out the opcode
-	sLog.out(Message::PRIO_DEBUG, "[%d]\t[S->C] %.4X", GetId(), packet->opcode);
+	LOG_OUT(LOG_NET, Message::PRIO_DEBUG, "[%d]\t[S->C] %.4X", GetId(), packet->opcode);
+
+    // Packets are sent from the reactor, the grids and the broadcast workers
+    Poco::ScopedWriteRWLock lock(_writeLock);
+
+    // Disconnected, waiting to be deleted
+    if (_detached)
+    {
+        if (packet->DeleteOnSend)
+            delete packet;
+        return;
+    }
+
+    Poco::UInt16 len = packet->len;
+    Poco::UInt16 length = packet->getLength();
+    const Poco::UInt8* data = packet->rawdata;
 
     // Encrypt if we have to and can
+    // As the digest below, into our own buffer, the packet may be shared
+    std::vector<Poco::UInt8> encrypted;
     if (encrypt && _packetData.AESEnc)
     {
         CryptoPP::StreamTransformationFilter enc(*_packetData.AESEnc);
@@ -305,23 +372,28 @@ void Client::sendPacket(Packet* packet, bool encrypt, bool hmac)
             enc.Put(packet->rawdata[i]);
         enc.MessageEnd();
 
-        packet->len = (Poco::UInt16)(enc.MaxRetrievable() | 0xA000);
-    
-        delete [] packet->rawdata;
-        packet->rawdata = new Poco::UInt8[(Poco::UInt32)enc.MaxRetrievable()];
-        enc.Get(packet->rawdata, (size_t)enc.MaxRetrievable());
+        encrypted.resize((size_t)enc.MaxRetrievable());
+        enc.Get(&encrypted[0], encrypted.size());
+
+        len = (Poco::UInt16)(encrypted.size() | 0xA000);
+        length = (Poco::UInt16)encrypted.size();
+        data = &encrypted[0];
     }
     
     // Set HMAC Hash
+    // The same packet may be broadcasted to many clients at once, so the
+    // digest is never stored on the packet itself
+    Poco::UInt8 digest[PACKET_HMAC_SIZE];
+    memcpy(digest, packet->digest, sizeof(digest));
     if (hmac && _packetData.verifier)
-        _packetData.verifier->CalculateDigest(packet->digest, packet->rawdata, packet->getLength());
+        _packetData.verifier->CalculateDigest(digest, data, length);
 
     // Write to the buffer
-    _writeBufferOut.write((const char*)&packet->len, sizeof(packet->len));
+    _writeBufferOut.write((const char*)&len, sizeof(len));
     _writeBufferOut.write((const char*)&packet->opcode, sizeof(packet->opcode));
     _writeBufferOut.write((const char*)&packet->sec, sizeof(packet->sec));
-    _writeBufferOut.write((const char*)packet->digest, sizeof(packet->digest));
-    _writeBufferOut.write((const char*)packet->rawdata, packet->getLength());
+    _writeBufferOut.write((const char*)digest, sizeof(digest));
+    _writeBufferOut.write((const char*)data, length);
 
     // Add a write handler to the reactor
     _reactor.addEventHandler(_socket, NObserver<Client, WritableNotification>(*this, &Client::onWritable));
@@ -348,6 +420,7 @@ void Client::generateSecurityByte()
  */
 void Client::ClearCharacters()
 {
+    Poco::FastMutex::ScopedLock lock(_charactersMutex);
     _characters.clear();
 }
 
@@ -358,6 +431,7 @@ void Client::ClearCharacters()
  */
 void Client::AddCharacter(Characters character)
 {
+    Poco::FastMutex::ScopedLock lock(_charactersMutex);
     _characters.push_back(character);
 }
 
@@ -376,16 +450,22 @@ static bool findCharacterByID(Characters character, Poco::UInt32 ID)
 /**
  * Finds a character given an ID
  *
+ * The list is refilled from the world thread while the reactor reads it,
+ * so a copy is returned
+ *
  * @param ID character ID to be found
- * @return The character if found
+ * @param character Output, copy of the character
+ * @return true if found
  */
-Characters* Client::FindCharacter(Poco::UInt32 ID)
+bool Client::FindCharacter(Poco::UInt32 ID, Characters& character)
 {
+    Poco::FastMutex::ScopedLock lock(_charactersMutex);
     std::list<Characters>::iterator itr = std::find_if(_characters.begin(), _characters.end(), std::bind2nd(std::ptr_fun(findCharacterByID), ID));
     if (itr == _characters.end())
-        return NULL;
+        return false;
 
-    return &(*itr);
+    character = *itr;
+    return true;
 }
 
 /**
@@ -5,6 +5,7 @@
 #include <list>
 
 //@ Mutex and Locking
+#include "Poco/Mutex.h"
 #include "Poco/RWLock.h"
 #include "Poco/SharedPtr.h"
 #include "Poco/AutoPtr.h"
@@ -44,6 +45,8 @@ class Server;
 class Player;
 class Packet;
 
+struct CharacterRecord;
+
 enum LogicFlags
 {
     DISCONNECT_READY                    = 1,
@@ -72,8 +75,9 @@ public:
     void onTimeout(const AutoPtr<TimeoutNotification>& pNf);
     void onWritable(const AutoPtr<WritableNotification>& pNf);
     void cleanupBeforeDelete();
+    void destroy();
 
-    SharedPtr<Player> onEnterToWorld(Poco::UInt32 characterID);
+    Player* onEnterToWorld(const CharacterRecord& record);
     void sendPacket(Packet* packet, bool encrypt = false, bool hmac = true);
 
     inline Poco::UInt32 GetId()
@@ -81,6 +85,11 @@ public:
         return _id;
     }
 
+    inline Poco::UInt32 getConnectionId()
+    {
+        return _connection;
+    }
+
     inline void SetId(Poco::UInt32 id)
     {
         _id = id;
@@ -113,7 +122,7 @@ public:
 
     void ClearCharacters();
     void AddCharacter(Characters character);
-    Characters* FindCharacter(Poco::UInt32 ID);
+    bool FindCharacter(Poco::UInt32 ID, Characters& character);
 
     inline Player* GetPlayer()
     {
@@ -147,11 +156,14 @@ public:
 
 private:
     void generateSecurityByte();
+    void detach();
 
 private:
     std::list<Characters> _characters;
-    SharedPtr<Player> _player;
+    Poco::FastMutex _charactersMutex;
+    Player* _player;
 
+    Poco::UInt32 _connection;
     Poco::UInt32 _id;
     Poco::UInt32 _characterId;
     bool _logged;
@@ -160,6 +172,7 @@ private:
     Poco::UInt64 _logicFlags;    
 	std::list<Packet*> _writePackets;
     Poco::RWLock _writeLock;
+    bool _detached;
 
     struct PacketData
     {
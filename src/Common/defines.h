@@ -31,8 +31,8 @@ enum HIGH_GUID
 #include <set>
 typedef std::set<Poco::UInt64> GuidsSet;
 
-//@ Testing purpouses macros
-#define SERVER_FRAMEWORK_TEST_SUITE
+//@ Testing purpouses macros, SERVER_FRAMEWORK_TEST_SUITE is only set by
+//@ the Benchmark target
 
 //@ Login database
 class AuthDatabaseConnection;
@@ -0,0 +1,241 @@
+/**
+ * Compiles the tab separated DataStores into the binary format the server
+ * maps (see DataStoreFormat.h). The store is chosen by the source name, and
+ * its columns are given by the record schema (see DataStoreRecords.h):
+ *
+ *  DataStoreCompiler data/Items.ds data/Items.dsc
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Poco/Path.h"
+#include "Poco/StringTokenizer.h"
+
+#include "DataStoreFormat.h"
+#include "DataStoreRecords.h"
+
+template <typename S>
+bool sortById(const S& a, const S& b)
+{
+    return a.Id < b.Id;
+}
+
+static void pad(std::ofstream& out, Poco::UInt32& offset)
+{
+    while (offset % DATASTORE_ALIGNMENT)
+    {
+        out.put('\0');
+        ++offset;
+    }
+}
+
+static Poco::UInt32 align(Poco::UInt32 offset)
+{
+    return (offset + DATASTORE_ALIGNMENT - 1) / DATASTORE_ALIGNMENT * DATASTORE_ALIGNMENT;
+}
+
+/**
+ * Sorts the records and writes the compiled store, with a dense index if
+ * the ids are dense enough
+ *
+ * @param output Output file name
+ * @param records Parsed records
+ * @param strings Strings the records refer to
+ * @return true if it has been written
+ */
+template <typename S>
+bool write(const std::string& output, std::vector<S>& records, DataStoreStrings& strings)
+{
+    std::sort(records.begin(), records.end(), sortById<S>);
+
+    for (Poco::UInt32 i = 1; i < records.size(); ++i)
+    {
+        if (records[i].Id == records[i - 1].Id)
+        {
+            fprintf(stderr, "Duplicated id %u\n", records[i].Id);
+            return false;
+        }
+    }
+
+    std::vector<Poco::UInt32> dense;
+    if (!records.empty())
+    {
+        Poco::UInt64 span = (Poco::UInt64)records.back().Id - records.front().Id + 1;
+        if (span <= (Poco::UInt64)records.size() * DATASTORE_DENSE_FACTOR)
+        {
+            dense.resize((size_t)span, DATASTORE_NO_RECORD);
+            for (Poco::UInt32 i = 0; i < records.size(); ++i)
+                dense[records[i].Id - records.front().Id] = i;
+        }
+    }
+
+    // A running server may have the current file mapped, it is replaced
+    // rather than overwritten
+    std::string temporary = output + ".tmp";
+    std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        fprintf(stderr, "Can not open %s\n", temporary.c_str());
+        return false;
+    }
+
+    DataStoreHeader header = {};
+    header.magic = DATASTORE_MAGIC;
+    header.version = DATASTORE_VERSION;
+    header.recordSize = sizeof(S);
+    header.schema = DataStoreSchema<S>::getHash();
+    header.count = (Poco::UInt32)records.size();
+    header.stringsSize = (Poco::UInt32)strings.data().size();
+
+    // Sections are laid out one after the other, aligned
+    header.indexOffset = sizeof(DataStoreHeader);
+    header.recordsOffset = align(header.indexOffset + header.count * sizeof(Poco::UInt32));
+    header.stringsOffset = align(header.recordsOffset + header.count * sizeof(S));
+    if (!dense.empty())
+    {
+        header.denseOffset = align(header.stringsOffset + header.stringsSize);
+        header.denseMin = records.front().Id;
+        header.denseSize = (Poco::UInt32)dense.size();
+    }
+
+    Poco::UInt32 offset = sizeof(DataStoreHeader);
+    out.write((const char*)&header, sizeof(header));
+
+    for (typename std::vector<S>::iterator itr = records.begin(); itr != records.end(); ++itr)
+        out.write((const char*)&itr->Id, sizeof(Poco::UInt32));
+    offset += header.count * sizeof(Poco::UInt32);
+    pad(out, offset);
+
+    if (!records.empty())
+        out.write((const char*)&records[0], records.size() * sizeof(S));
+    offset += header.count * sizeof(S);
+    pad(out, offset);
+
+    out.write(&strings.data()[0], strings.data().size());
+    offset += header.stringsSize;
+
+    if (!dense.empty())
+    {
+        pad(out, offset);
+        out.write((const char*)&dense[0], dense.size() * sizeof(Poco::UInt32));
+    }
+
+    out.close();
+    if (out.fail())
+    {
+        fprintf(stderr, "Can not write %s\n", temporary.c_str());
+        remove(temporary.c_str());
+        return false;
+    }
+
+    // Windows does not replace existing files on rename
+    if (rename(temporary.c_str(), output.c_str()) != 0 && (remove(output.c_str()) != 0 || rename(temporary.c_str(), output.c_str()) != 0))
+    {
+        fprintf(stderr, "Can not replace %s\n", output.c_str());
+        remove(temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Parses a source, one record per line and one column per schema field
+ *
+ * @param input Source file
+ * @param output Output file name
+ * @return true if it has been compiled
+ */
+template <typename S>
+bool compile(std::ifstream& input, const std::string& output)
+{
+    typedef DataStoreSchema<S> Schema;
+
+    std::vector<S> records;
+    DataStoreStrings strings;
+
+    std::string line;
+    Poco::UInt32 lineNumber = 0;
+    while (std::getline(input, line))
+    {
+        ++lineNumber;
+
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+
+        if (line.empty())
+            continue;
+
+        Poco::StringTokenizer tokens(line, "\t", Poco::StringTokenizer::TOK_TRIM);
+        if (tokens.count() < (Poco::UInt32)Schema::Count)
+        {
+            fprintf(stderr, "Line %u: expected %u columns, found %u\n", lineNumber, (Poco::UInt32)Schema::Count, (Poco::UInt32)tokens.count());
+            return false;
+        }
+
+        std::vector<std::string> columns(tokens.begin(), tokens.end());
+
+        S record = S();
+        Poco::UInt32 failed = 0;
+        if (!Schema::parse(record, columns, 0, strings, failed))
+        {
+            fprintf(stderr, "Line %u: wrong value \"%s\" on column %u\n", lineNumber, columns[failed].c_str(), failed + 1);
+            return false;
+        }
+
+        records.push_back(record);
+    }
+
+    if (!write(output, records, strings))
+        return false;
+
+    printf("%u %s records written to %s\n", (Poco::UInt32)records.size(), Schema::getName(), output.c_str());
+    return true;
+}
+
+struct StoreCompiler
+{
+    const char* (*getName)();
+    bool (*compile)(std::ifstream& input, const std::string& output);
+};
+
+#define STORE_COMPILER(S) {&DataStoreSchema<S>::getName, &compile<S>}
+
+static const StoreCompiler Compilers[] =
+{
+    STORE_COMPILER(ItemStore),
+    STORE_COMPILER(CreatureStore),
+    STORE_COMPILER(SpawnStore),
+    {NULL,  NULL},
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s <source.ds> <output.dsc>\n", argv[0]);
+        return 1;
+    }
+
+    std::string source(argv[1]);
+    std::string output(argv[2]);
+    std::string name = Poco::Path(source).getBaseName();
+
+    std::ifstream input(source.c_str());
+    if (!input.is_open())
+    {
+        fprintf(stderr, "Can not open %s\n", source.c_str());
+        return 1;
+    }
+
+    for (Poco::UInt32 i = 0; Compilers[i].getName; ++i)
+        if (name == Compilers[i].getName())
+            return Compilers[i].compile(input, output) ? 0 : 1;
+
+    fprintf(stderr, "Unknown DataStore %s\n", name.c_str());
+    return 1;
+}
@@ -1,52 +1,319 @@
 #include "DataStore.h"
+#include "Log.h"
 #include "ServerConfig.h"
 
+#include <list>
+#include <vector>
+
+#include "Poco/Exception.h"
+#include "Poco/File.h"
+#include "Poco/Mutex.h"
 #include "Poco/Path.h"
-#include "Poco/FileStream.h"
-#include "Poco/StringTokenizer.h"
+#include "Poco/Runnable.h"
+#include "Poco/ThreadPool.h"
+
+// World ticks a replaced snapshot is kept, readers may use it until the
+// end of the tick after the one it was replaced in
+#define DATASTORE_GRACE_TICKS 2
 
 DataStore<ItemStore> sItemStore;
+DataStore<CreatureStore> sCreatureStore;
+DataStore<SpawnStore> sSpawnStore;
 
-template <typename S, int bufferSize>
-DataStore<S, bufferSize>::DataStore()
+namespace
 {
+    struct Retired
+    {
+        DataStoreSnapshotBase* snapshot;
+        Poco::UInt64 tick;
+    };
+
+    /**
+     * Stores by name and retired snapshots. Stores register themselves while
+     * globals are constructed, so this is created on first use
+     */
+    struct Registry
+    {
+        static Registry& instance()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        ~Registry()
+        {
+            for (std::list<Retired>::iterator itr = retired.begin(); itr != retired.end(); ++itr)
+                delete itr->snapshot;
+        }
+
+        std::vector<DataStoreBase*> stores;
+        std::list<Retired> retired;
+        Poco::UInt64 tick;
+        Poco::FastMutex mutex;
+
+    private:
+        Registry():
+            tick(0)
+        {
+        }
+    };
+
+    /**
+     * Reads a store on a pool thread, and deletes itself
+     */
+    class ReloadTask : public Poco::Runnable
+    {
+    public:
+        ReloadTask(DataStoreBase* store, std::atomic<bool>& reloading):
+            _store(store), _reloading(reloading)
+        {
+        }
+
+        void run()
+        {
+            if (_store->read())
+                sLog.out(Message::PRIO_INFORMATION, "DataStore %s reloaded", _store->getName());
+            else
+                sLog.out(Message::PRIO_ERROR, "DataStore %s could not be reloaded, the previous one is kept", _store->getName());
+
+            _reloading = false;
+            delete this;
+        }
+
+    private:
+        DataStoreBase* _store;
+        std::atomic<bool>& _reloading;
+    };
 }
 
-template <typename S, int bufferSize>
-DataStore<S, bufferSize>::~DataStore()
+template <typename S>
+DataStoreSnapshot<S>::DataStoreSnapshot():
+    _index(NULL), _records(NULL), _strings(NULL), _stringsSize(0), _count(0),
+    _dense(NULL), _denseMin(0), _denseSize(0)
 {
-    while (!_dataStore.empty())
-    {
-        TypeDataStoreMap::iterator itr = _dataStore.begin();
-        delete itr->second;
-        _dataStore.erase(itr);
-    }
 }
 
-// Read all the items
-bool DataStore<ItemStore>::read(std::string filename)
+/**
+ * Maps a compiled DataStore, checking its header and sections fit the file
+ *
+ * @param path File path
+ * @return true if it has been mapped
+ */
+template <typename S>
+bool DataStoreSnapshot<S>::map(const std::string& path)
 {
-    Poco::Path path(sConfig.getDefaultString("DataFolder", "data").append("/").append(filename));
     Poco::File store(path);
 
     if (!store.exists())
+    {
+        sLog.out(Message::PRIO_ERROR, "DataStore %s not found, compile it with DataStoreCompiler", path.c_str());
+        return false;
+    }
+
+    Poco::UInt64 size = store.getSize();
+    if (size < sizeof(DataStoreHeader))
+    {
+        sLog.out(Message::PRIO_ERROR, "DataStore %s is truncated", path.c_str());
+        return false;
+    }
+
+    try
+    {
+        _memory = Poco::SharedMemory(store, Poco::SharedMemory::AM_READ);
+    }
+    catch (Poco::Exception& ex)
+    {
+        sLog.out(Message::PRIO_ERROR, "DataStore %s can not be mapped: %s", path.c_str(), ex.displayText().c_str());
+        return false;
+    }
+
+    const char* base = _memory.begin();
+    const DataStoreHeader* header = (const DataStoreHeader*)base;
+
+    if (header->magic != DATASTORE_MAGIC || header->version != DATASTORE_VERSION ||
+        header->recordSize != sizeof(S) || header->schema != DataStoreSchema<S>::getHash())
+    {
+        sLog.out(Message::PRIO_ERROR, "DataStore %s was compiled for another version, compile it again", path.c_str());
+        return false;
+    }
+
+    // Sections are cast in place, so they must be aligned as the compiler
+    // writes them, the mapping itself being page aligned
+    Poco::UInt64 count = header->count;
+    if (header->indexOffset % DATASTORE_ALIGNMENT || header->recordsOffset % DATASTORE_ALIGNMENT ||
+        header->denseOffset % DATASTORE_ALIGNMENT ||
+        header->indexOffset + count * sizeof(Poco::UInt32) > size ||
+        header->recordsOffset + count * sizeof(S) > size ||
+        header->stringsOffset + (Poco::UInt64)header->stringsSize > size ||
+        !header->stringsSize || base[header->stringsOffset + header->stringsSize - 1] != '\0' ||
+        (header->denseOffset && header->denseOffset + (Poco::UInt64)header->denseSize * sizeof(Poco::UInt32) > size))
+    {
+        sLog.out(Message::PRIO_ERROR, "DataStore %s is corrupted", path.c_str());
+        return false;
+    }
+
+    // Lookups trust the index order and the dense slots, they are checked
+    // once here rather than on each find
+    const Poco::UInt32* index = (const Poco::UInt32*)(base + header->indexOffset);
+    bool valid = true;
+    for (Poco::UInt64 i = 1; i < count && valid; ++i)
+        valid = index[i - 1] < index[i];
+
+    if (header->denseOffset)
+    {
+        const Poco::UInt32* dense = (const Poco::UInt32*)(base + header->denseOffset);
+        for (Poco::UInt32 i = 0; i < header->denseSize && valid; ++i)
+            valid = dense[i] < count || dense[i] == DATASTORE_NO_RECORD;
+    }
+
+    if (!valid)
+    {
+        sLog.out(Message::PRIO_ERROR, "DataStore %s is corrupted", path.c_str());
+        return false;
+    }
+
+    _index = index;
+    _records = (const S*)(base + header->recordsOffset);
+    _strings = base + header->stringsOffset;
+    _stringsSize = header->stringsSize;
+    _count = header->count;
+
+    if (header->denseOffset)
+    {
+        _dense = (const Poco::UInt32*)(base + header->denseOffset);
+        _denseMin = header->denseMin;
+        _denseSize = header->denseSize;
+    }
+
+    return true;
+}
+
+DataStoreBase::DataStoreBase(const char* name):
+    _name(name), _reloading(false)
+{
+    Registry& registry = Registry::instance();
+
+    Poco::FastMutex::ScopedLock lock(registry.mutex);
+    registry.stores.push_back(this);
+}
+
+DataStoreBase::~DataStoreBase()
+{
+}
+
+/**
+ * Reloads a store on a background thread. Readers keep using the current
+ * snapshot until the new one is ready, and keep it if the reload fails
+ *
+ * @param name Store name, as given by its schema
+ * @return false if there is no such store, or it is already reloading
+ */
+bool DataStoreBase::reload(const std::string& name)
+{
+    Registry& registry = Registry::instance();
+    DataStoreBase* store = NULL;
+    {
+        Poco::FastMutex::ScopedLock lock(registry.mutex);
+        for (std::vector<DataStoreBase*>::iterator itr = registry.stores.begin(); itr != registry.stores.end(); ++itr)
+            if (name == (*itr)->getName())
+                store = *itr;
+    }
+
+    if (!store || store->_reloading.exchange(true))
+        return false;
+
+    ReloadTask* task = new ReloadTask(store, store->_reloading);
+    try
+    {
+        Poco::ThreadPool::defaultPool().start(*task);
+    }
+    catch (Poco::Exception& ex)
+    {
+        sLog.out(Message::PRIO_ERROR, "DataStore %s reload could not start: %s", name.c_str(), ex.displayText().c_str());
+        delete task;
+        store->_reloading = false;
         return false;
+    }
 
-    Poco::FileInputStream input(store.path());
+    return true;
+}
 
-    char buffer[bufferSize];
-    while (input.getline(buffer, bufferSize).good())
+/**
+ * Called on each world tick boundary, frees the snapshots no reader can
+ * be using anymore
+ */
+void DataStoreBase::update()
+{
+    Registry& registry = Registry::instance();
+    std::list<Retired> expired;
     {
-        Poco::StringTokenizer tokens(buffer, "\t");
-        
-        ItemStore* itemStore = new ItemStore();
-        itemStore->Id = atoi(tokens[0].c_str());
-        itemStore->Name = tokens[1];
-        itemStore->Level = atoi(tokens[2].c_str());
-        itemStore->Gender = atoi(tokens[3].c_str());
+        Poco::FastMutex::ScopedLock lock(registry.mutex);
+        ++registry.tick;
+
+        while (!registry.retired.empty() && registry.retired.front().tick + DATASTORE_GRACE_TICKS <= registry.tick)
+            expired.splice(expired.end(), registry.retired, registry.retired.begin());
+    }
+
+    for (std::list<Retired>::iterator itr = expired.begin(); itr != expired.end(); ++itr)
+        delete itr->snapshot;
+}
+
+/**
+ * Frees a replaced snapshot once the grace period has passed
+ *
+ * @param snapshot Snapshot no longer reachable by new readers
+ */
+void DataStoreBase::retire(DataStoreSnapshotBase* snapshot)
+{
+    Registry& registry = Registry::instance();
+
+    Poco::FastMutex::ScopedLock lock(registry.mutex);
+    Retired retired = {snapshot, registry.tick};
+    registry.retired.push_back(retired);
+}
+
+template <typename S>
+DataStore<S>::DataStore():
+    DataStoreBase(DataStoreSchema<S>::getName()),
+    _current(new DataStoreSnapshot<S>())
+{
+}
+
+template <typename S>
+DataStore<S>::~DataStore()
+{
+    delete _current.load();
+}
+
+/**
+ * Maps the compiled DataStore of the schema name into a new snapshot, and
+ * publishes it
+ *
+ * @return true if it has been mapped
+ */
+template <typename S>
+bool DataStore<S>::read()
+{
+    std::string filename = std::string(getName()) + ".dsc";
+    Poco::Path path(sConfig.getDefaultString("DataFolder", "data").append("/").append(filename));
 
-        _dataStore.insert(rde::make_pair(itemStore->Id, itemStore));
+    DataStoreSnapshot<S>* snapshot = new DataStoreSnapshot<S>();
+    if (!snapshot->map(path.toString()))
+    {
+        delete snapshot;
+        return false;
     }
 
+    retire(_current.exchange(snapshot, std::memory_order_acq_rel));
+
+    sLog.out(Message::PRIO_INFORMATION, "\t[OK] %s: %u records", filename.c_str(), snapshot->size());
     return true;
 }
+
+template class DataStoreSnapshot<ItemStore>;
+template class DataStoreSnapshot<CreatureStore>;
+template class DataStoreSnapshot<SpawnStore>;
+
+template class DataStore<ItemStore>;
+template class DataStore<CreatureStore>;
+template class DataStore<SpawnStore>;
@@ -2,36 +2,179 @@
 #define GAMESERVER_DATASTORE_H
 
 #include "Poco/Poco.h"
-#include "Poco/File.h"
-
-//@ List and Hash Map
-#include "hash_map.h"
-#include "stack_allocator.h"
+#include "Poco/SharedMemory.h"
 
+#include <algorithm>
+#include <atomic>
 #include <string>
+#include <type_traits>
+
+#include "DataStoreFormat.h"
+#include "DataStoreRecords.h"
 
-struct ItemStore
+class DataStoreSnapshotBase
 {
-    Poco::UInt32 Id;
-    std::string Name;
-    Poco::UInt8 Level;
-    Poco::UInt8 Gender;
+public:
+    virtual ~DataStoreSnapshotBase()
+    {
+    }
 };
 
-template <typename S, int bufferSize = 1024>
-class DataStore
+/**
+ * A compiled DataStore, mapped in memory, which never changes once mapped.
+ * Records are used in place, no memory is allocated per record and nothing
+ * is parsed on load. Records are contiguous and sorted by id; ids are
+ * looked up on the dense index when the store has one, and by binary
+ * search otherwise
+ */
+template <typename S>
+class DataStoreSnapshot : public DataStoreSnapshotBase
+{
+    static_assert(std::is_pod<S>::value, "DataStore records must be plain structs");
+    static_assert(std::alignment_of<S>::value <= DATASTORE_ALIGNMENT, "DataStore records must fit the sections alignment");
+
+public:
+    DataStoreSnapshot();
+
+    bool map(const std::string& path);
+
+    /**
+     * Finds a record by its id
+     *
+     * @param id Record id
+     * @return The record, or NULL if there is none
+     */
+    inline const S* find(Poco::UInt32 id) const
+    {
+        if (_dense)
+        {
+            Poco::UInt32 slot = id - _denseMin;
+            if (slot >= _denseSize || _dense[slot] == DATASTORE_NO_RECORD)
+                return NULL;
+
+            return _records + _dense[slot];
+        }
+
+        return findSorted(id);
+    }
+
+    /**
+     * Finds a record by binary search on the index
+     *
+     * @param id Record id
+     * @return The record, or NULL if there is none
+     */
+    inline const S* findSorted(Poco::UInt32 id) const
+    {
+        const Poco::UInt32* end = _index + _count;
+        const Poco::UInt32* itr = std::lower_bound(_index, end, id);
+        if (itr == end || *itr != id)
+            return NULL;
+
+        return _records + (itr - _index);
+    }
+
+    /**
+     * Gets a string of a record of this snapshot
+     *
+     * @param string String field of the record
+     * @return The string, empty if its offset is wrong
+     */
+    inline const char* getString(DataString string) const
+    {
+        if (string.offset >= _stringsSize)
+            return "";
+
+        return _strings + string.offset;
+    }
+
+    inline Poco::UInt32 size() const
+    {
+        return _count;
+    }
+
+    inline const S* begin() const
+    {
+        return _records;
+    }
+
+    inline const S* end() const
+    {
+        return _records + _count;
+    }
+
+private:
+    Poco::SharedMemory _memory;
+    const Poco::UInt32* _index;
+    const S* _records;
+    const char* _strings;
+    Poco::UInt32 _stringsSize;
+    Poco::UInt32 _count;
+    const Poco::UInt32* _dense;
+    Poco::UInt32 _denseMin;
+    Poco::UInt32 _denseSize;
+};
+
+/**
+ * Untyped part of the DataStores, which keeps them all by name, so that
+ * they can be reloaded, and frees the replaced snapshots
+ */
+class DataStoreBase
+{
+public:
+    DataStoreBase(const char* name);
+    virtual ~DataStoreBase();
+
+    virtual bool read() = 0;
+
+    inline const char* getName()
+    {
+        return _name;
+    }
+
+    static bool reload(const std::string& name);
+    static void update();
+
+protected:
+    static void retire(DataStoreSnapshotBase* snapshot);
+
+private:
+    const char* _name;
+    std::atomic<bool> _reloading;
+};
+
+/**
+ * A DataStore which can be reloaded while the server runs. Readers take the
+ * current snapshot without locking, and may use it, and the records found
+ * on it, until the end of the next world tick. A reload maps a new
+ * snapshot and swaps it in; the old one is freed two ticks later, once
+ * every grid and broadcast worker has moved on
+ */
+template <typename S>
+class DataStore : public DataStoreBase
 {
 public:
     DataStore();
     ~DataStore();
 
-    bool read(std::string file);
+    bool read();
+
+    inline const DataStoreSnapshot<S>* get() const
+    {
+        return _current.load(std::memory_order_acquire);
+    }
+
+    inline const S* find(Poco::UInt32 id) const
+    {
+        return get()->find(id);
+    }
 
 private:
-    typedef rde::hash_map<Poco::UInt32 /*id*/, S*> TypeDataStoreMap;    
-    TypeDataStoreMap _dataStore;
+    std::atomic<DataStoreSnapshot<S>*> _current;
 };
 
 extern DataStore<ItemStore> sItemStore;
+extern DataStore<CreatureStore> sCreatureStore;
+extern DataStore<SpawnStore> sSpawnStore;
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,48 @@
+#ifndef GAMESERVER_DATASTORE_FORMAT_H
+#define GAMESERVER_DATASTORE_FORMAT_H
+
+#include "Poco/Poco.h"
+
+/**
+ * Compiled DataStores, built from the tab separated sources by the
+ * DataStoreCompiler tool, and mapped by the server as they are:
+ *
+ *  Header
+ *  Index       count ids, sorted
+ *  Records     count fixed size records, in the index order
+ *  Strings     NUL terminated strings, records store their offsets. The
+ *              first one is always the empty string
+ *  Dense       Only if the ids are dense enough, the record of each id
+ *              from denseMin on, DATASTORE_NO_RECORD if there is none
+ *
+ * All the sections are aligned to DATASTORE_ALIGNMENT, values are stored
+ * little endian
+ */
+#define DATASTORE_MAGIC         0x53444645 // "EFDS"
+#define DATASTORE_VERSION       2
+#define DATASTORE_ALIGNMENT     8
+#define DATASTORE_NO_RECORD     0xFFFFFFFF
+
+// The dense index is built if it has at most this many slots per record
+#define DATASTORE_DENSE_FACTOR  4
+
+struct DataStoreHeader
+{
+    Poco::UInt32 magic;
+    Poco::UInt16 version;
+    Poco::UInt16 recordSize;
+    Poco::UInt32 schema;
+    Poco::UInt32 count;
+    Poco::UInt32 indexOffset;
+    Poco::UInt32 recordsOffset;
+    Poco::UInt32 stringsOffset;
+    Poco::UInt32 stringsSize;
+    Poco::UInt32 denseOffset;
+    Poco::UInt32 denseMin;
+    Poco::UInt32 denseSize;
+    Poco::UInt32 reserved;
+};
+
+static_assert(sizeof(DataStoreHeader) == 48, "DataStoreHeader layout must not change");
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef GAMESERVER_DATASTORE_RECORDS_H
+#define GAMESERVER_DATASTORE_RECORDS_H
+
+#include "Poco/Poco.h"
+
+#include "DataStoreSchema.h"
+
+/**
+ * Records of the static game tables. Each one is declared along with its
+ * schema, which lists the source columns in order. Members may be laid out
+ * differently than the columns, to avoid padding
+ */
+
+struct ItemStore
+{
+    Poco::UInt32 Id;
+    DataString Name;
+    Poco::UInt8 Level;
+    Poco::UInt8 Gender;
+};
+
+DATASTORE_SCHEMA(ItemStore, "Items",
+    DATASTORE_FIELD(ItemStore, Id),
+    DATASTORE_FIELD(ItemStore, Name),
+    DATASTORE_FIELD(ItemStore, Level),
+    DATASTORE_FIELD(ItemStore, Gender))
+
+struct CreatureStore
+{
+    Poco::UInt32 Id;
+    DataString Name;
+    Poco::UInt32 Model;
+    Poco::UInt32 MaxHP;
+    Poco::UInt32 MaxMP;
+    float WalkSpeed;
+    float RunSpeed;
+    Poco::UInt8 Level;
+};
+
+DATASTORE_SCHEMA(CreatureStore, "Creatures",
+    DATASTORE_FIELD(CreatureStore, Id),
+    DATASTORE_FIELD(CreatureStore, Name),
+    DATASTORE_FIELD(CreatureStore, Model),
+    DATASTORE_FIELD(CreatureStore, Level),
+    DATASTORE_FIELD(CreatureStore, MaxHP),
+    DATASTORE_FIELD(CreatureStore, MaxMP),
+    DATASTORE_FIELD(CreatureStore, WalkSpeed),
+    DATASTORE_FIELD(CreatureStore, RunSpeed))
+
+struct SpawnStore
+{
+    Poco::UInt32 Id;
+    Poco::UInt32 Creature;
+    float X;
+    float Y;
+};
+
+DATASTORE_SCHEMA(SpawnStore, "Spawns",
+    DATASTORE_FIELD(SpawnStore, Id),
+    DATASTORE_FIELD(SpawnStore, Creature),
+    DATASTORE_FIELD(SpawnStore, X),
+    DATASTORE_FIELD(SpawnStore, Y))
+
+#endif
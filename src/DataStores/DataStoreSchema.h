@@ -0,0 +1,230 @@
+#ifndef GAMESERVER_DATASTORE_SCHEMA_H
+#define GAMESERVER_DATASTORE_SCHEMA_H
+
+#include <cerrno>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Poco/Poco.h"
+
+/**
+ * String field of a record, stored on the string table
+ */
+struct DataString
+{
+    Poco::UInt32 offset;
+};
+
+/**
+ * Strings of a store being compiled, each distinct one is stored once
+ */
+class DataStoreStrings
+{
+public:
+    DataStoreStrings():
+        _data(1, '\0')
+    {
+    }
+
+    Poco::UInt32 add(const std::string& value)
+    {
+        if (value.empty())
+            return 0;
+
+        std::map<std::string, Poco::UInt32>::iterator itr = _offsets.find(value);
+        if (itr != _offsets.end())
+            return itr->second;
+
+        Poco::UInt32 offset = (Poco::UInt32)_data.size();
+        _data.insert(_data.end(), value.begin(), value.end());
+        _data.push_back('\0');
+
+        _offsets.insert(std::make_pair(value, offset));
+        return offset;
+    }
+
+    inline const std::vector<char>& data() const
+    {
+        return _data;
+    }
+
+private:
+    std::vector<char> _data;
+    std::map<std::string, Poco::UInt32> _offsets;
+};
+
+/**
+ * Parsing and layout code of each field type. Numbers are parsed whole,
+ * and must fit the field
+ */
+template <typename T>
+struct DataStoreType
+{
+    static_assert(std::is_arithmetic<T>::value, "DataStore fields must be numbers or DataString");
+
+    enum
+    {
+        Code = sizeof(T) | (std::is_signed<T>::value ? 0x10 : 0) | (std::is_floating_point<T>::value ? 0x20 : 0)
+    };
+
+    static bool parse(const std::string& token, T& value, DataStoreStrings& strings)
+    {
+        const char* begin = token.c_str();
+        char* end = NULL;
+        errno = 0;
+
+        if (std::is_floating_point<T>::value)
+            value = (T)strtod(begin, &end);
+        else if (std::is_signed<T>::value)
+        {
+            long long parsed = strtoll(begin, &end, 10);
+            value = (T)parsed;
+            if ((long long)value != parsed)
+                return false;
+        }
+        else
+        {
+            unsigned long long parsed = strtoull(begin, &end, 10);
+            value = (T)parsed;
+            if ((unsigned long long)value != parsed || token.find('-') != std::string::npos)
+                return false;
+        }
+
+        return end != begin && *end == '\0' && errno == 0;
+    }
+};
+
+template <>
+struct DataStoreType<DataString>
+{
+    enum
+    {
+        Code = 0x40
+    };
+
+    static bool parse(const std::string& token, DataString& value, DataStoreStrings& strings)
+    {
+        value.offset = strings.add(token);
+        return true;
+    }
+};
+
+/**
+ * A field of record S, declared through DATASTORE_FIELD
+ */
+template <class S, class T, T S::*Member>
+struct DataStoreField
+{
+    typedef T Type;
+
+    static inline T& get(S& record)
+    {
+        return record.*Member;
+    }
+
+    static inline Poco::UInt32 offset()
+    {
+        S record;
+        return (Poco::UInt32)((const char*)&(record.*Member) - (const char*)&record);
+    }
+};
+
+/**
+ * Field list of record S, one source column per field, in order
+ */
+template <class S, class... F>
+struct DataStoreFields;
+
+template <class S>
+struct DataStoreFields<S>
+{
+    enum
+    {
+        Count = 0
+    };
+
+    static bool parse(S& record, const std::vector<std::string>& columns, Poco::UInt32 column, DataStoreStrings& strings, Poco::UInt32& failed)
+    {
+        return true;
+    }
+
+    static Poco::UInt32 hash(Poco::UInt32 value)
+    {
+        return value;
+    }
+};
+
+template <class S, class F, class... R>
+struct DataStoreFields<S, F, R...>
+{
+    enum
+    {
+        Count = 1 + sizeof...(R)
+    };
+
+    /**
+     * Parses the columns of a row into a record
+     *
+     * @param record Output, the record
+     * @param columns Row columns
+     * @param column Column of this field
+     * @param strings Table where the strings are added
+     * @param failed Output, column which could not be parsed
+     * @return true if all the fields have been parsed
+     */
+    static bool parse(S& record, const std::vector<std::string>& columns, Poco::UInt32 column, DataStoreStrings& strings, Poco::UInt32& failed)
+    {
+        if (!DataStoreType<typename F::Type>::parse(columns[column], F::get(record), strings))
+        {
+            failed = column;
+            return false;
+        }
+
+        return DataStoreFields<S, R...>::parse(record, columns, column + 1, strings, failed);
+    }
+
+    /**
+     * Folds the type and offset of every field, so that a store compiled
+     * with another layout is refused
+     *
+     * @param value Hash of the previous fields
+     * @return Hash including the remaining fields
+     */
+    static Poco::UInt32 hash(Poco::UInt32 value)
+    {
+        value = (value ^ DataStoreType<typename F::Type>::Code) * 16777619;
+        value = (value ^ F::offset()) * 16777619;
+        return DataStoreFields<S, R...>::hash(value);
+    }
+};
+
+/**
+ * Schema of each record type, defined with DATASTORE_SCHEMA
+ */
+template <class S>
+struct DataStoreSchema;
+
+#define DATASTORE_FIELD(S, member) \
+    DataStoreField<S, decltype(((S*)0)->member), &S::member>
+
+// Declares the source name and the fields of record S. Records must be
+// plain structs with a Poco::UInt32 Id
+#define DATASTORE_SCHEMA(S, name, ...) \
+    template <> \
+    struct DataStoreSchema<S> : DataStoreFields<S, __VA_ARGS__> \
+    { \
+        static const char* getName() \
+        { \
+            return name; \
+        } \
+        \
+        static Poco::UInt32 getHash() \
+        { \
+            return hash((2166136261u ^ (Poco::UInt32)sizeof(S)) * 16777619); \
+        } \
+    };
+
+#endif
@@ -11,16 +11,17 @@ AuthDatabaseConnection::~AuthDatabaseConnection()
 
 void AuthDatabaseConnection::DoPreparedStatements()
 {
-    stmts.resize(MAX_AUTHDATABASE_STATEMENTS);
-
     try
     {
-        DO_PREPARED_STATEMENT(QUERY_AUTH_LOGIN, "SELECT u.id, u.online FROM account u WHERE u.username = ? and u.password = ?");
-        DO_PREPARED_STATEMENT(QUERY_AUTH_UPDATE_ONLINE_ONSTART, "UPDATE account u SET u.online = 0");
-		DO_PREPARED_STATEMENT(QUERY_AUTH_UPDATE_SID, "UPDATE account u SET u.sid = ? WHERE u.id = ?")
-		DO_PREPARED_STATEMENT(QUERY_AUTH_UPDATE_ONLINE, "UPDATE account u SET u.online = ? WHERE u.id = ?")
-		DO_PREPARED_STATEMENT(QUERY_AUTH_GET_ONLINE, "SELECT u.online FROM account u WHERE u.id = ?")
-		DO_PREPARED_STATEMENT(QUERY_AUTH_LOGIN_SID, "SELECT u.id FROM account u WHERE u.username = ? and u.password = ? and u.sid = ?")
+        DO_PREPARED_STATEMENT(AuthLogin, "SELECT u.id, u.online FROM account u WHERE u.username = ? and u.password = ?");
+        DO_PREPARED_STATEMENT(AuthUpdateOnlineOnStart, "UPDATE account SET online = 0");
+		DO_PREPARED_STATEMENT(AuthUpdateSID, "UPDATE account SET sid = ? WHERE id = ?")
+		DO_PREPARED_STATEMENT(AuthUpdateOnline, "UPDATE account SET online = ? WHERE id = ?")
+		DO_PREPARED_STATEMENT(AuthGetOnline, "SELECT u.online FROM account u WHERE u.id = ?")
+		DO_PREPARED_STATEMENT(AuthLoginSID, "SELECT u.id FROM account u WHERE u.username = ? and u.password = ? and u.sid = ?")
+
+        // Built for each batch by OnlineStatusBuffer, only its stats are kept
+        registerQuery(QUERY_AUTH_FLUSH_ONLINE, "", "AuthFlushOnline");
     }
     catch (Poco::Exception e)
     {
@@ -20,10 +20,24 @@ enum AuthDatabaseStatements
 	QUERY_AUTH_UPDATE_ONLINE,
 	QUERY_AUTH_GET_ONLINE,
 	QUERY_AUTH_LOGIN_SID,
+	QUERY_AUTH_FLUSH_ONLINE,
 
 	MAX_AUTHDATABASE_STATEMENTS
 };
 
+//  0       1
+// u.id, u.online
+struct AuthLogin : StatementDefinition<QUERY_AUTH_LOGIN, std::tuple<Poco::UInt32, Poco::UInt8>, std::string, std::string> {};
+struct AuthUpdateOnlineOnStart : StatementDefinition<QUERY_AUTH_UPDATE_ONLINE_ONSTART, NoRow> {};
+struct AuthUpdateSID : StatementDefinition<QUERY_AUTH_UPDATE_SID, NoRow, std::string, Poco::UInt32> {};
+struct AuthUpdateOnline : StatementDefinition<QUERY_AUTH_UPDATE_ONLINE, NoRow, Poco::UInt8, Poco::UInt32> {};
+//    0
+// u.online
+struct AuthGetOnline : StatementDefinition<QUERY_AUTH_GET_ONLINE, std::tuple<Poco::UInt8>, Poco::UInt32> {};
+//  0
+// u.id
+struct AuthLoginSID : StatementDefinition<QUERY_AUTH_LOGIN_SID, std::tuple<Poco::UInt32>, std::string, std::string, std::string> {};
+
 class AuthDatabaseConnection : public Database
 {
 public:
@@ -0,0 +1,321 @@
+#include "CharacterStore.h"
+#include "Character.h"
+#include "Log.h"
+#include "ObjectManager.h"
+#include "ServerConfig.h"
+
+// Characters written by each transaction
+#define CHARACTER_SAVE_BATCH 100
+
+CharacterStore::CharacterStore():
+    _inFlight(false)
+{
+    _interval = sConfig.getDefaultInt("CharacterSaveInterval", 10000);
+    _ttl = sConfig.getDefaultInt("CharacterCacheTTL", 300000);
+}
+
+/**
+ * Finds a cached character which nobody is playing. The state of one
+ * being played is only known on the tick boundary, so it is not found
+ *
+ * @param id Character id
+ * @param record Output, the character state
+ * @return true if the character is cached and not played
+ */
+bool CharacterStore::find(Poco::UInt32 id, CharacterRecord& record)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    EntriesMap::iterator itr = _entries.find(id);
+    if (itr == _entries.end() || itr->second.owner)
+        return false;
+
+    record = itr->second.record;
+    return true;
+}
+
+/**
+ * Caches a character loaded from the database. If it was cached meanwhile,
+ * the cached state is newer and the loaded one is discarded
+ *
+ * @param id Character id
+ * @param row Character loaded by CharactersSelectInformation
+ * @return The character state
+ */
+CharacterRecord CharacterStore::load(Poco::UInt32 id, const CharactersSelectInformation::Row& row)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    EntriesMap::iterator itr = _entries.find(id);
+    if (itr != _entries.end())
+        return itr->second.record;
+
+    //  0     1    2       3       4      5      6
+    // c.x, c.y, c.maxhp, c.hp, c.maxmp, c.mp, c.lvl
+    Entry& entry = _entries[id];
+    entry.record.id = id;
+    entry.record.x = std::get<0>(row);
+    entry.record.y = std::get<1>(row);
+    entry.record.maxhp = std::get<2>(row);
+    entry.record.hp = std::get<3>(row);
+    entry.record.maxmp = std::get<4>(row);
+    entry.record.mp = std::get<5>(row);
+    entry.record.lvl = std::get<6>(row);
+    entry.owner = NULL;
+    entry.dirty = 0;
+
+    return entry.record;
+}
+
+/**
+ * Binds a cached character to the entity playing it, from now on its
+ * changes are saved
+ *
+ * @param id Character id
+ * @param character Entity created from the cached state
+ * @return false if it is not cached, or another entity is playing it
+ */
+bool CharacterStore::attach(Poco::UInt32 id, Character* character)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    EntriesMap::iterator itr = _entries.find(id);
+    if (itr == _entries.end() || itr->second.owner)
+        return false;
+
+    // Fields set while creating the entity are not changes
+    character->takeDirty();
+    itr->second.owner = character;
+    return true;
+}
+
+/**
+ * Unbinds a character from its entity on the next collect. Grids may still
+ * be updating the entity, so its last state is only taken then, and only
+ * then the entity is removed from the ObjectManager. The character stays
+ * cached until the TTL expires
+ *
+ * @param id Character id
+ * @return false if the character is not bound, its entity must be removed
+ *  by the caller
+ */
+bool CharacterStore::release(Poco::UInt32 id)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    EntriesMap::iterator itr = _entries.find(id);
+    if (itr == _entries.end() || !itr->second.owner)
+        return false;
+
+    _released.push_back(id);
+    return true;
+}
+
+/**
+ * Unbinds all the characters, used on shutdown before the entities go away
+ */
+void CharacterStore::releaseAll()
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    for (EntriesMap::iterator itr = _entries.begin(); itr != _entries.end(); ++itr)
+    {
+        if (itr->second.owner)
+        {
+            capture(itr->second);
+            itr->second.owner = NULL;
+        }
+    }
+
+    _released.clear();
+}
+
+/**
+ * Takes the last state of the characters released during this tick, unbinds
+ * them and removes their entities. Called on the tick boundary, before the
+ * ObjectManager collect, which destroys the entities
+ */
+void CharacterStore::collect()
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    for (std::vector<Poco::UInt32>::iterator id = _released.begin(); id != _released.end(); ++id)
+    {
+        EntriesMap::iterator itr = _entries.find(*id);
+        if (itr == _entries.end() || !itr->second.owner)
+            continue;
+
+        capture(itr->second);
+        sObjectManager.removeObject(itr->second.owner->GetGUID());
+        itr->second.owner = NULL;
+        itr->second.released.update();
+    }
+
+    _released.clear();
+}
+
+/**
+ * Called on each world tick boundary, saves when the interval has elapsed
+ */
+void CharacterStore::update()
+{
+    if (_lastFlush.elapsed() / 1000 >= _interval)
+    {
+        _lastFlush.update();
+        flush();
+    }
+}
+
+/**
+ * Saves all the dirty characters and evicts the expired ones. Only one save
+ * is running at once, so that an older state never overwrites a newer one
+ *
+ * @param wait Whether to write on the calling thread, used on shutdown
+ */
+void CharacterStore::flush(bool wait /*= false*/)
+{
+    SaveJob* job = NULL;
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        if (_inFlight)
+            return;
+
+        RecordsList records;
+        EntriesMap::iterator itr = _entries.begin();
+        while (itr != _entries.end())
+        {
+            Entry& entry = itr->second;
+            if (entry.owner)
+                capture(entry);
+
+            if (entry.dirty)
+            {
+                records.push_back(entry.record);
+                entry.dirty = 0;
+            }
+            else if (!entry.owner && entry.released.elapsed() / 1000 >= _ttl)
+            {
+                _entries.erase(itr++);
+                continue;
+            }
+
+            ++itr;
+        }
+
+        if (records.empty())
+            return;
+
+        _inFlight = true;
+        job = new SaveJob(records);
+    }
+
+    if (wait)
+    {
+        Poco::Notification::Ptr holder(job);
+        job->execute(CharactersDatabase);
+    }
+    else
+        CharactersDatabase.enqueue(job);
+}
+
+/**
+ * Copies the changed fields of an entry entity into its record. Only on
+ * the tick boundary, as the grids update the entity meanwhile
+ *
+ * @param entry Entry with an owner
+ */
+void CharacterStore::capture(Entry& entry)
+{
+    Character* character = entry.owner;
+    Poco::UInt32 dirty = character->takeDirty();
+    if (!dirty)
+        return;
+
+    if (dirty & DIRTY_POSITION)
+    {
+        entry.record.x = character->GetPosition().x;
+        entry.record.y = character->GetPosition().z;
+    }
+
+    if (dirty & DIRTY_HP)
+    {
+        entry.record.maxhp = character->GetMaxHP();
+        entry.record.hp = character->GetHP();
+    }
+
+    if (dirty & DIRTY_MP)
+    {
+        entry.record.maxmp = character->GetMaxMP();
+        entry.record.mp = character->GetMP();
+    }
+
+    if (dirty & DIRTY_LEVEL)
+        entry.record.lvl = character->GetLVL();
+
+    entry.dirty |= dirty;
+}
+
+/**
+ * Ends a save, characters of a failed one are saved again on the next
+ *
+ * @param records Characters which were being saved
+ * @param success Whether they have been written
+ */
+void CharacterStore::onSaved(RecordsList& records, bool success)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    // Entries are never evicted while a save is running
+    if (!success)
+        for (RecordsList::iterator itr = records.begin(); itr != records.end(); ++itr)
+            _entries[itr->id].dirty |= DIRTY_POSITION | DIRTY_HP | DIRTY_MP | DIRTY_LEVEL;
+
+    _inFlight = false;
+}
+
+CharacterStore::SaveJob::SaveJob(RecordsList& records):
+    _records(records)
+{
+}
+
+/**
+ * Writes the characters, CHARACTER_SAVE_BATCH of them per transaction
+ *
+ * @param database Database the job was queued on
+ */
+void CharacterStore::SaveJob::execute(Database& database)
+{
+    _success = true;
+
+    Session& session = database.getSession();
+    PreparedStatement<CharactersSave>* stmt = database.getStatement<CharactersSave>();
+
+    RecordsList::iterator itr = _records.begin();
+    while (itr != _records.end() && _success)
+    {
+        try
+        {
+            session.begin();
+
+            for (Poco::UInt32 count = 0; itr != _records.end() && count < CHARACTER_SAVE_BATCH; ++itr, ++count)
+                stmt->execute(CharactersSave::Parameters(itr->x, itr->y, itr->maxhp, itr->hp, itr->maxmp, itr->mp, itr->lvl, itr->id));
+
+            session.commit();
+        }
+        catch (Poco::Exception& ex)
+        {
+            LOG_OUT(LOG_DB, Message::PRIO_ERROR, "Characters save failed: %s", ex.displayText().c_str());
+            _success = false;
+
+            try
+            {
+                session.rollback();
+            }
+            catch (Poco::Exception&)
+            {
+            }
+        }
+    }
+
+    sCharacterStore.onSaved(_records, _success);
+}
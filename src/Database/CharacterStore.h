@@ -0,0 +1,99 @@
+#ifndef GAMESERVER_CHARACTER_STORE_H
+#define GAMESERVER_CHARACTER_STORE_H
+
+#include <map>
+#include <vector>
+
+#include "Poco/Poco.h"
+#include "Poco/Mutex.h"
+#include "Poco/SingletonHolder.h"
+#include "Poco/Timestamp.h"
+
+#include "CharactersDatabase.h"
+#include "DatabaseJob.h"
+
+class Character;
+
+/**
+ * Saved state of a character, as stored on the characters table
+ */
+struct CharacterRecord
+{
+    Poco::UInt32 id;
+    float x;
+    float y;
+    Poco::UInt32 maxhp;
+    Poco::UInt32 hp;
+    Poco::UInt32 maxmp;
+    Poco::UInt32 mp;
+    Poco::UInt8 lvl;
+};
+
+/**
+ * Keeps the loaded characters in memory. Changes done in game are tracked
+ * through the entities dirty fields, and dirty characters are written every
+ * few seconds in batched transactions by a database worker. Characters stay
+ * cached for a while after logging out, so that a reconnect needs no query
+ */
+class CharacterStore
+{
+private:
+    typedef std::vector<CharacterRecord> RecordsList;
+
+    struct Entry
+    {
+        CharacterRecord record;
+        Character* owner;
+        Poco::UInt32 dirty;
+        Poco::Timestamp released;
+    };
+
+    typedef std::map<Poco::UInt32 /*id*/, Entry> EntriesMap;
+
+    class SaveJob : public DatabaseJob
+    {
+    public:
+        SaveJob(RecordsList& records);
+
+        void execute(Database& database);
+
+    private:
+        RecordsList _records;
+    };
+
+public:
+    CharacterStore();
+
+    static CharacterStore& instance()
+    {
+        static Poco::SingletonHolder<CharacterStore> sh;
+        return *sh.get();
+    }
+
+    bool find(Poco::UInt32 id, CharacterRecord& record);
+    CharacterRecord load(Poco::UInt32 id, const CharactersSelectInformation::Row& row);
+    bool attach(Poco::UInt32 id, Character* character);
+    bool release(Poco::UInt32 id);
+    void releaseAll();
+
+    void collect();
+    void update();
+    void flush(bool wait = false);
+
+private:
+    void capture(Entry& entry);
+    void onSaved(RecordsList& records, bool success);
+
+private:
+    EntriesMap _entries;
+    std::vector<Poco::UInt32> _released;
+    bool _inFlight;
+    Poco::Timestamp _lastFlush;
+    Poco::UInt32 _interval;
+    Poco::UInt32 _ttl;
+    Poco::FastMutex _mutex;
+};
+
+#define sCharacterStore CharacterStore::instance()
+
+#endif
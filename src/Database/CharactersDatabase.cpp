@@ -10,14 +10,12 @@ CharactersDatabaseConnection::~CharactersDatabaseConnection()
 
 void CharactersDatabaseConnection::DoPreparedStatements()
 {
-    stmts.resize(MAX_CHARACTERSDATABASE_STATEMENTS);
-
     try
     {
-	    DO_PREPARED_STATEMENT(QUERY_CHARACTERS_SELECT_BASIC_INFORMATION, "SELECT c.id, c.model, c.name FROM characters c WHERE c.account = ?")
-	    DO_PREPARED_STATEMENT(QUERY_CHARACTERS_UPDATE_GUID, "UPDATE characters c SET c.guid = ? WHERE c.id = ?")
-	    DO_PREPARED_STATEMENT(QUERY_CHARACTERS_SELECT_INFORMATION, "SELECT c.x, c.y, c.maxhp, c.hp, c.maxmp, c.mp, c.lvl FROM characters c WHERE c.id = ?")
-        DO_PREPARED_STATEMENT(QUERY_CHARACTERS_SELECT_VISIBLE_EQUIPMENT, "SELECT i.item_id FROM inventory i WHERE i.pid = ? and i.slot <= 6")
+	    DO_PREPARED_STATEMENT(CharactersSelectList, "SELECT c.id, c.model, c.name, COALESCE(i.item_id, 0) FROM characters c LEFT JOIN inventory i ON i.pid = c.id AND i.slot <= 6 WHERE c.account = ? ORDER BY c.id")
+	    DO_PREPARED_STATEMENT(CharactersUpdateGUID, "UPDATE characters SET guid = ? WHERE id = ?")
+	    DO_PREPARED_STATEMENT(CharactersSelectInformation, "SELECT c.x, c.y, c.maxhp, c.hp, c.maxmp, c.mp, c.lvl FROM characters c WHERE c.id = ?")
+	    DO_PREPARED_STATEMENT(CharactersSave, "UPDATE characters SET x = ?, y = ?, maxhp = ?, hp = ?, maxmp = ?, mp = ?, lvl = ? WHERE id = ?")
     }
     catch (Poco::Exception e)
     {
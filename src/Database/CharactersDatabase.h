@@ -14,14 +14,23 @@ using namespace Poco::Data;
 
 enum CharactersDatabaseStatements
 {
-    QUERY_CHARACTERS_SELECT_BASIC_INFORMATION,
+    QUERY_CHARACTERS_SELECT_LIST,
     QUERY_CHARACTERS_UPDATE_GUID,
     QUERY_CHARACTERS_SELECT_INFORMATION,
-    QUERY_CHARACTERS_SELECT_VISIBLE_EQUIPMENT,
+    QUERY_CHARACTERS_SAVE,
 
 	MAX_CHARACTERSDATABASE_STATEMENTS
 };
 
+//  0       1       2         3
+// c.id, c.model, c.name, i.item_id
+struct CharactersSelectList : StatementDefinition<QUERY_CHARACTERS_SELECT_LIST, std::tuple<Poco::UInt32, Poco::UInt32, std::string, Poco::UInt32>, Poco::UInt32> {};
+struct CharactersUpdateGUID : StatementDefinition<QUERY_CHARACTERS_UPDATE_GUID, NoRow, Poco::UInt32, Poco::UInt32> {};
+//  0     1    2       3       4      5      6
+// c.x, c.y, c.maxhp, c.hp, c.maxmp, c.mp, c.lvl
+struct CharactersSelectInformation : StatementDefinition<QUERY_CHARACTERS_SELECT_INFORMATION, std::tuple<float, float, Poco::UInt32, Poco::UInt32, Poco::UInt32, Poco::UInt32, Poco::UInt8>, Poco::UInt32> {};
+struct CharactersSave : StatementDefinition<QUERY_CHARACTERS_SAVE, NoRow, float, float, Poco::UInt32, Poco::UInt32, Poco::UInt32, Poco::UInt32, Poco::UInt8, Poco::UInt32> {};
+
 class CharactersDatabaseConnection : public Database
 {
 public:
@@ -1,38 +1,356 @@
 #include "Database.h"
+#include "DatabaseWorker.h"
+#include "Log.h"
+#include "ServerConfig.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "Poco/String.h"
 
 using namespace Poco::Data;
 
-Database::Database()
+Database::Database():
+    _pool(NULL),
+    _statsInterval(0)
 {
 }
 
 Database::~Database()
 {
+    for (std::vector<StatementStats*>::iterator itr = _stats.begin(); itr != _stats.end(); ++itr)
+        delete *itr;
 }
 
-void Database::Open(std::string connectionString)
+/**
+ * Connects to the database, and starts its workers
+ *
+ * @param connector Poco Data connector, either MySQL or SQLite
+ * @param connectionString Connection string, the file name for SQLite
+ * @param schema SQL script creating the tables if they do not exist, run
+ *  before any statement is prepared
+ * @return false if it can not connect or the schema can not be created
+ */
+bool Database::Open(std::string connector, std::string connectionString, std::string schema /*= ""*/)
 {
+    _connector = connector;
+
     try
     {
-        _pool = new SessionPool("MySQL", connectionString, 1, 32);
+        _pool = new SessionPool(connector, connectionString, 1, DATABASE_MAX_SESSIONS);
         if (!_pool->get().isConnected())
-            ASSERT(false);
+        {
+            LOG_OUT(LOG_DB, Message::PRIO_CRITICAL, "Can not connect to %s", connectionString.c_str());
+            return false;
+        }
+
+        PreparedStatementBase::MaxRetries = sConfig.getDefaultInt("DatabaseRetries", 3);
+        _statsInterval = sConfig.getDefaultInt("DatabaseStatsInterval", 0);
+
+        if (!schema.empty() && !runScript(schema))
+            return false;
     }
-    catch (Poco::Data::ConnectionFailedException ex)
+    catch (Poco::Exception& ex)
     {
-        printf("%s\n", ex.message().c_str());
-        ASSERT(false);
+        LOG_OUT(LOG_DB, Message::PRIO_CRITICAL, "Can not open the database: %s", ex.displayText().c_str());
+        releaseSession();
+        return false;
     }
-    catch (Poco::Data::MySQL::ConnectionException ex)
+
+    DoPreparedStatements();
+
+    // Statements were prepared only to check them, the opening thread
+    // does not query anymore
+    releaseSession();
+
+    // Start the workers, each one takes its own session from the pool and
+    // one is always left for the other threads
+    Poco::UInt32 workers = std::max(1, std::min(sConfig.getDefaultInt("DatabaseWorkers", 2), DATABASE_MAX_SESSIONS - 1));
+    for (Poco::UInt32 i = 0; i < workers; ++i)
     {
-        printf("%s\n", ex.message().c_str());
-        ASSERT(false);
+        DatabaseWorker* worker = new DatabaseWorker(this);
+        Poco::Thread* thread = new Poco::Thread();
+        thread->start(*worker);
+
+        _workers.push_back(worker);
+        _threads.push_back(thread);
     }
 
-    DoPreparedStatements();
+    return true;
 }
 
-PreparedStatement* Database::getPreparedStatement(Poco::UInt8 index)
+/**
+ * Waits for all the queued jobs to be executed and stops the workers.
+ * Completions not yet processed are discarded
+ *
+ */
+void Database::Close()
 {
-    return stmts[index];
+    // One stop notification per worker, queued after all the pending jobs
+    for (Poco::UInt32 i = 0; i < _threads.size(); ++i)
+        _jobs.enqueueNotification(new Poco::Notification());
+
+    for (Poco::UInt32 i = 0; i < _threads.size(); ++i)
+    {
+        _threads[i]->join();
+        delete _threads[i];
+        delete _workers[i];
+    }
+
+    _threads.clear();
+    _workers.clear();
+    _completed.clear();
+}
+
+/**
+ * Gets the session of the calling thread, for queries which can not be
+ * prepared beforehand
+ *
+ * @return The session
+ */
+Session& Database::getSession()
+{
+    StatementCache& cache = _cache.get();
+    if (!cache.session)
+    {
+        cache.session = new Session(_pool->get());
+        cache.statements.resize(_queries.size(), NULL);
+
+        // SQLite locks the whole file on writes, wait for other sessions
+        // instead of failing right away
+        if (isSQLite())
+            *cache.session << "PRAGMA busy_timeout = 5000", Keywords::now;
+    }
+
+    return *cache.session;
+}
+
+/**
+ * Returns the session of the calling thread to the pool, along with its
+ * statements. Threads which are done with the database must call it, or
+ * the session is only returned when the thread ends, if it is a Poco one
+ *
+ */
+void Database::releaseSession()
+{
+    _cache.get().release();
+}
+
+/**
+ * Gets the counters of a query built on each execution, which the caller
+ * times itself. They outlive the calling thread, as those of statements
+ *
+ * @param index Query index, registered with an empty query
+ * @return The counters, only written by the calling thread
+ */
+StatementStats* Database::getQueryStats(Poco::UInt8 index)
+{
+    StatementCache& cache = _cache.get();
+    if (index >= cache.queryStats.size())
+        cache.queryStats.resize(index + 1, NULL);
+
+    StatementStats*& stats = cache.queryStats[index];
+    if (!stats)
+        stats = createStats(index);
+
+    return stats;
+}
+
+/**
+ * Queues a job whose result is not needed
+ *
+ * @param job Job to be executed, ownership is taken
+ */
+void Database::enqueue(DatabaseJob* job)
+{
+    _jobs.enqueueNotification(job);
+}
+
+/**
+ * Runs the callbacks of all the executed jobs, on the calling thread
+ *
+ */
+void Database::processCompletions()
+{
+    while (true)
+    {
+        Poco::Notification::Ptr notification(_completed.dequeueNotification());
+        if (notification.isNull())
+            break;
+
+        if (DatabaseJob* job = dynamic_cast<DatabaseJob*>(notification.get()))
+            job->complete();
+    }
+}
+
+/**
+ * Stores the query of a statement, so that each thread can prepare it
+ *
+ * @param index Statement index
+ * @param query SQL of the statement
+ * @param name Name shown on the stats
+ */
+void Database::registerQuery(Poco::UInt8 index, std::string query, std::string name)
+{
+    if (index >= _queries.size())
+    {
+        _queries.resize(index + 1);
+        _names.resize(index + 1);
+    }
+
+    _queries[index] = query;
+    _names[index] = name;
+
+    StatementCache& cache = _cache.get();
+    if (cache.session && cache.statements.size() < _queries.size())
+        cache.statements.resize(_queries.size(), NULL);
+}
+
+/**
+ * Executes a SQL script on the calling thread session, statements are split
+ * on ';' and lines starting with "--" are skipped
+ *
+ * @param file Script file name
+ * @return false if the script can not be opened
+ * @throw Poco::Exception If a statement fails
+ */
+bool Database::runScript(std::string file)
+{
+    std::ifstream in(file.c_str());
+    if (!in.is_open())
+    {
+        LOG_OUT(LOG_DB, Message::PRIO_CRITICAL, "Can not open database script %s", file.c_str());
+        return false;
+    }
+
+    std::string query;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (Poco::trim(line).compare(0, 2, "--") == 0)
+            continue;
+
+        query.append(line).append("\n");
+
+        std::string::size_type end;
+        while ((end = query.find(';')) != std::string::npos)
+        {
+            std::string statement = Poco::trim(query.substr(0, end));
+            query.erase(0, end + 1);
+
+            if (!statement.empty())
+                getSession() << statement, Keywords::now;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Creates the counters of a statement being prepared by the calling thread.
+ * They outlive the thread, so that its executions are still accounted
+ *
+ * @param index Statement index
+ * @return The counters, only written by the calling thread
+ */
+StatementStats* Database::createStats(Poco::UInt8 index)
+{
+    StatementStats* stats = new StatementStats(index);
+
+    Poco::FastMutex::ScopedLock lock(_statsMutex);
+    _stats.push_back(stats);
+    return stats;
+}
+
+/**
+ * Logs the executions, latency, retries and rows of each statement, merging
+ * the counters of all the threads. Percentiles are upper bounds, taken from
+ * the latency histogram
+ */
+void Database::dumpStats()
+{
+    struct Totals
+    {
+        Poco::UInt64 executions;
+        Poco::UInt64 failures;
+        Poco::UInt64 retries;
+        Poco::UInt64 rows;
+        Poco::UInt64 time;
+        Poco::UInt64 maxTime;
+        Poco::UInt64 histogram[STATEMENT_STATS_BUCKETS];
+    };
+
+    std::vector<Totals> totals(_queries.size(), Totals());
+
+    {
+        Poco::FastMutex::ScopedLock lock(_statsMutex);
+        for (std::vector<StatementStats*>::iterator itr = _stats.begin(); itr != _stats.end(); ++itr)
+        {
+            StatementStats* stats = *itr;
+            Totals& total = totals[stats->index];
+
+            total.executions += stats->executions.load(std::memory_order_relaxed);
+            total.failures += stats->failures.load(std::memory_order_relaxed);
+            total.retries += stats->retries.load(std::memory_order_relaxed);
+            total.rows += stats->rows.load(std::memory_order_relaxed);
+            total.time += stats->time.load(std::memory_order_relaxed);
+            total.maxTime = std::max(total.maxTime, stats->maxTime.load(std::memory_order_relaxed));
+
+            for (Poco::UInt8 i = 0; i < STATEMENT_STATS_BUCKETS; ++i)
+                total.histogram[i] += stats->histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    for (Poco::UInt32 index = 0; index < totals.size(); ++index)
+    {
+        Totals& total = totals[index];
+        if (!total.executions)
+            continue;
+
+        // Microseconds under which 50% and 99% of the executions took
+        Poco::UInt64 percentiles[2] = {0, 0};
+        Poco::UInt64 thresholds[2] = {(total.executions + 1) / 2, (total.executions * 99 + 99) / 100};
+        Poco::UInt64 count = 0;
+        for (Poco::UInt8 i = 0; i < STATEMENT_STATS_BUCKETS; ++i)
+        {
+            count += total.histogram[i];
+            for (Poco::UInt8 p = 0; p < 2; ++p)
+                if (!percentiles[p] && count >= thresholds[p])
+                    percentiles[p] = std::min((Poco::UInt64)2 << i, total.maxTime);
+        }
+
+        LOG_OUT(LOG_DB, Message::PRIO_INFORMATION, "%s: %llu executions, %llu failed, %llu retries, %llu rows, avg %.2f ms, p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+            _names[index].c_str(), (unsigned long long)total.executions, (unsigned long long)total.failures,
+            (unsigned long long)total.retries, (unsigned long long)total.rows,
+            total.time / (double)total.executions / 1000.0, percentiles[0] / 1000.0, percentiles[1] / 1000.0, total.maxTime / 1000.0);
+    }
+}
+
+/**
+ * Called on each world tick, dumps the stats when the interval has elapsed,
+ * if it is set
+ */
+void Database::updateStats()
+{
+    if (_statsInterval && _lastStats.elapsed() / 1000 >= _statsInterval)
+    {
+        _lastStats.update();
+        dumpStats();
+    }
+}
+
+Database::StatementCache::~StatementCache()
+{
+    release();
+}
+
+void Database::StatementCache::release()
+{
+    // Statements must go before the session they were prepared on
+    for (std::vector<PreparedStatementBase*>::iterator itr = statements.begin(); itr != statements.end(); ++itr)
+        delete *itr;
+
+    statements.clear();
+    delete session;
+    session = NULL;
 }
@@ -1,34 +1,173 @@
 #ifndef GAMESERVER_DATABASE_H
 #define GAMESERVER_DATABASE_H
 
+#include <string>
+#include <vector>
+
 #include "Poco/Poco.h"
+#include "Poco/Mutex.h"
+#include "Poco/NotificationQueue.h"
+#include "Poco/String.h"
+#include "Poco/Thread.h"
+#include "Poco/ThreadLocal.h"
+#include "Poco/Timestamp.h"
 #include "Poco/Data/Column.h"
 #include "Poco/Data/SessionPool.h"
 #include "Poco/Data/MySQL/MySQL.h"
 #include "Poco/Data/MySQL/Connector.h"
 #include "Poco/Data/MySQL/MySQLException.h"
+#include "Poco/Data/SQLite/Connector.h"
 
 #include "debugging.h"
+#include "DatabaseJob.h"
 #include "PreparedStatement.h"
+#include "StatementStats.h"
 
 using namespace Poco::Data;
 
-#define DO_PREPARED_STATEMENT(a, b) stmts[a] = new PreparedStatement( (_pool->get() << b) );
+// Registers statement a with query b, which must have as many placeholders
+// as parameters has a
+#define DO_PREPARED_STATEMENT(a, b) \
+    static_assert(countPlaceholders(b) == a::ParametersCount, #a " parameters do not match its query"); \
+    registerStatement<a>(b, #a);
+
+// Sessions held by each database pool, one is kept for non worker threads
+#define DATABASE_MAX_SESSIONS 32
+
+class DatabaseWorker;
+
+template <class S>
+class StatementJob;
 
 class Database
 {
+    friend class DatabaseWorker;
+
 public:
     Database();
     ~Database();
     
-    void Open(std::string connectionString);
+    bool Open(std::string connector, std::string connectionString, std::string schema = "");
+    void Close();
 
     virtual void DoPreparedStatements() = 0;
-    PreparedStatement* getPreparedStatement(Poco::UInt8 index);
+
+    // The statement and session belong to the calling thread, they must not be shared
+    template <class S>
+    PreparedStatement<S>* getStatement();
+    Session& getSession();
+    void releaseSession();
+
+    // Counters of a query which can not be prepared, for the calling thread
+    StatementStats* getQueryStats(Poco::UInt8 index);
+
+    void enqueue(DatabaseJob* job);
+
+    template <class S>
+    void enqueue(StatementJob<S>* job, const typename StatementJob<S>::Callback& callback);
+    void processCompletions();
+
+    inline bool isSQLite()
+    {
+        return Poco::icompare(_connector, SQLite::Connector::KEY) == 0;
+    }
+
+    void dumpStats();
+    void updateStats();
+
+protected:
+    template <class S>
+    void registerStatement(const char* query, const char* name);
+    void registerQuery(Poco::UInt8 index, std::string query, std::string name);
+
+private:
+    bool runScript(std::string file);
+    StatementStats* createStats(Poco::UInt8 index);
+
+private:
+    /**
+     * Session and statements used by a single thread. Statements are
+     * prepared the first time the thread uses them
+     */
+    struct StatementCache
+    {
+        StatementCache():
+            session(NULL)
+        {}
+
+        ~StatementCache();
+
+        void release();
+
+        Session* session;
+        std::vector<PreparedStatementBase*> statements;
+        std::vector<StatementStats*> queryStats;
+    };
 
 protected:
     SessionPool* _pool;
-    std::vector<PreparedStatement*> stmts;
+
+private:
+    std::string _connector;
+    std::vector<std::string> _queries;
+    std::vector<std::string> _names;
+    Poco::ThreadLocal<StatementCache> _cache;
+    std::vector<DatabaseWorker*> _workers;
+    std::vector<Poco::Thread*> _threads;
+    Poco::NotificationQueue _jobs;
+    Poco::NotificationQueue _completed;
+
+    // Counters of every statement prepared by any thread
+    std::vector<StatementStats*> _stats;
+    Poco::FastMutex _statsMutex;
+    Poco::Timestamp _lastStats;
+    Poco::UInt32 _statsInterval;
 };
 
-#endif
\ No newline at end of file
+/**
+ * Gets a statement of the calling thread, preparing it on the thread
+ * session if it is the first time it is used. Each index has a single
+ * definition, so the stored statement is always of that type
+ *
+ * @return The statement
+ */
+template <class S>
+PreparedStatement<S>* Database::getStatement()
+{
+    Session& session = getSession();
+
+    PreparedStatementBase*& stmt = _cache.get().statements[S::Index];
+    if (!stmt)
+        stmt = new PreparedStatement<S>( (session << _queries[S::Index]), createStats(S::Index) );
+
+    return static_cast<PreparedStatement<S>*>(stmt);
+}
+
+/**
+ * Queues a job, the callback is run by processCompletions once executed
+ *
+ * @param job Job to be executed, ownership is taken
+ * @param callback Continuation receiving the executed job
+ */
+template <class S>
+void Database::enqueue(StatementJob<S>* job, const typename StatementJob<S>::Callback& callback)
+{
+    job->setCallback(callback);
+    enqueue(job);
+}
+
+/**
+ * Registers a statement. It is prepared right away on the registering
+ * thread, so that wrong queries are found on startup
+ *
+ * @param query SQL of the statement
+ * @param name Name of the statement definition, for the stats
+ */
+template <class S>
+void Database::registerStatement(const char* query, const char* name)
+{
+    registerQuery(S::Index, query, name);
+    getStatement<S>();
+}
+
+#endif
@@ -0,0 +1,27 @@
+#include "DatabaseJob.h"
+
+DatabaseJob::DatabaseJob():
+    _success(false)
+{
+}
+
+DatabaseJob::~DatabaseJob()
+{
+}
+
+/**
+ * Runs the continuation, if any, on the thread draining the completions
+ */
+void DatabaseJob::complete()
+{
+}
+
+/**
+ * Whether the job must go through the completion queue once executed
+ *
+ * @return false, fire and forget jobs are simply released
+ */
+bool DatabaseJob::hasCallback()
+{
+    return false;
+}
@@ -0,0 +1,34 @@
+#ifndef GAMESERVER_DATABASE_JOB_H
+#define GAMESERVER_DATABASE_JOB_H
+
+#include "Poco/Poco.h"
+#include "Poco/Notification.h"
+
+class Database;
+
+/**
+ * Work to be executed by a database worker. Jobs with a continuation go
+ * back to the caller thread through the database completion queue, where
+ * it is run. Single statements use StatementJob, jobs needing more than
+ * one statement derive from it and use the worker statements as they need
+ */
+class DatabaseJob : public Poco::Notification
+{
+public:
+    DatabaseJob();
+    virtual ~DatabaseJob();
+
+    virtual void execute(Database& database) = 0;
+    virtual void complete();
+    virtual bool hasCallback();
+
+    inline bool succeeded()
+    {
+        return _success;
+    }
+
+protected:
+    bool _success;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#include "DatabaseWorker.h"
+#include "Database.h"
+#include "DatabaseJob.h"
+
+DatabaseWorker::DatabaseWorker(Database* database):
+    _database(database)
+{
+}
+
+/**
+ * Executes jobs until a notification which is not a job is found
+ */
+void DatabaseWorker::run()
+{
+    while (true)
+    {
+        Poco::Notification::Ptr notification(_database->_jobs.waitDequeueNotification());
+        DatabaseJob* job = dynamic_cast<DatabaseJob*>(notification.get());
+        if (!job)
+            break;
+
+        job->execute(*_database);
+
+        // Fire and forget jobs are simply released
+        if (job->hasCallback())
+            _database->_completed.enqueueNotification(notification);
+    }
+
+    _database->releaseSession();
+}
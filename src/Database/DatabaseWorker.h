@@ -0,0 +1,24 @@
+#ifndef GAMESERVER_DATABASE_WORKER_H
+#define GAMESERVER_DATABASE_WORKER_H
+
+#include "Poco/Poco.h"
+#include "Poco/Runnable.h"
+
+class Database;
+
+/**
+ * Executes the jobs queued on a Database. Being a thread of its own, each
+ * worker uses its own session and statements, thus they run in parallel
+ */
+class DatabaseWorker : public Poco::Runnable
+{
+public:
+    DatabaseWorker(Database* database);
+
+    void run();
+
+private:
+    Database* _database;
+};
+
+#endif
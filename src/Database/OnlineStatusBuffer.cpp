@@ -0,0 +1,159 @@
+#include "OnlineStatusBuffer.h"
+#include "AuthDatabase.h"
+#include "Log.h"
+#include "ServerConfig.h"
+
+#include "Poco/NumberFormatter.h"
+
+// Accounts written by each UPDATE statement
+#define ONLINE_STATUS_BATCH 500
+
+OnlineStatusBuffer::OnlineStatusBuffer():
+    _inFlight(false)
+{
+    _interval = sConfig.getDefaultInt("OnlineFlushInterval", 1000);
+}
+
+/**
+ * Sets the online flag of an account, it will be written on the next flush
+ *
+ * @param account Account id
+ * @param online Whether the account is online or not
+ */
+void OnlineStatusBuffer::setOnline(Poco::UInt32 account, bool online)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    _pending[account] = online;
+}
+
+/**
+ * Checks if there is an online flag not yet written for an account, which
+ * must be used instead of the database one
+ *
+ * @param account Account id
+ * @param online Output, the online flag
+ * @return true if there is a flag not written
+ */
+bool OnlineStatusBuffer::getOnline(Poco::UInt32 account, bool& online)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    StatusMap::iterator itr = _pending.find(account);
+    if (itr == _pending.end())
+    {
+        itr = _flushing.find(account);
+        if (itr == _flushing.end())
+            return false;
+    }
+
+    online = itr->second;
+    return true;
+}
+
+/**
+ * Called on each world tick, flushes when the interval has elapsed
+ */
+void OnlineStatusBuffer::update()
+{
+    if (_lastFlush.elapsed() / 1000 >= _interval)
+    {
+        _lastFlush.update();
+        flush();
+    }
+}
+
+/**
+ * Writes all the pending changes. Only one flush is running at once, so
+ * that an older batch never overwrites a newer one
+ *
+ * @param wait Whether to write on the calling thread, used on shutdown
+ */
+void OnlineStatusBuffer::flush(bool wait /*= false*/)
+{
+    FlushJob* job = NULL;
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+        if (_pending.empty() || _inFlight)
+            return;
+
+        _inFlight = true;
+        _flushing.swap(_pending);
+        job = new FlushJob(_flushing);
+    }
+
+    if (wait)
+    {
+        Poco::Notification::Ptr holder(job);
+        job->execute(AuthDatabase);
+    }
+    else
+        AuthDatabase.enqueue(job);
+}
+
+/**
+ * Ends a flush, changes of a failed one are kept unless newer ones exist
+ *
+ * @param success Whether the changes have been written
+ */
+void OnlineStatusBuffer::onFlushed(bool success)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (!success)
+        for (StatusMap::iterator itr = _flushing.begin(); itr != _flushing.end(); ++itr)
+            _pending.insert(*itr);
+
+    _flushing.clear();
+    _inFlight = false;
+}
+
+OnlineStatusBuffer::FlushJob::FlushJob(StatusMap& status):
+    _status(status)
+{
+}
+
+/**
+ * Writes the batch as UPDATE ... SET online = CASE id WHEN ... END WHERE id IN (...)
+ *
+ * @param database Database the job was queued on
+ */
+void OnlineStatusBuffer::FlushJob::execute(Database& database)
+{
+    _success = true;
+
+    // Not a prepared statement, so it is timed here
+    StatementStats* stats = database.getQueryStats(QUERY_AUTH_FLUSH_ONLINE);
+
+    StatusMap::iterator itr = _status.begin();
+    while (itr != _status.end() && _success)
+    {
+        // Only integers are written, there is nothing to escape
+        std::string cases;
+        std::string ids;
+        for (Poco::UInt32 count = 0; itr != _status.end() && count < ONLINE_STATUS_BATCH; ++itr, ++count)
+        {
+            cases.append(" WHEN ").append(Poco::NumberFormatter::format(itr->first)).append(itr->second ? " THEN 1" : " THEN 0");
+
+            if (!ids.empty())
+                ids.append(",");
+            ids.append(Poco::NumberFormatter::format(itr->first));
+        }
+
+        std::string query = "UPDATE account SET online = CASE id" + cases + " END WHERE id IN (" + ids + ")";
+
+        Poco::Timestamp start;
+        try
+        {
+            database.getSession() << query, Keywords::now;
+        }
+        catch (Poco::Exception& ex)
+        {
+            LOG_OUT(LOG_DB, Message::PRIO_ERROR, "Online status flush failed: %s", ex.displayText().c_str());
+            _success = false;
+        }
+
+        stats->record(start.elapsed(), 1, _success);
+    }
+
+    sOnlineStatus.onFlushed(_success);
+}
@@ -0,0 +1,63 @@
+#ifndef GAMESERVER_ONLINE_STATUS_BUFFER_H
+#define GAMESERVER_ONLINE_STATUS_BUFFER_H
+
+#include <map>
+
+#include "Poco/Poco.h"
+#include "Poco/Mutex.h"
+#include "Poco/SingletonHolder.h"
+#include "Poco/Timestamp.h"
+
+#include "DatabaseJob.h"
+
+/**
+ * Write-behind buffer for the accounts online flag. Changes are coalesced
+ * per account, and written every few milliseconds in a single statement.
+ * Until then, the buffer and not the database holds the right value
+ */
+class OnlineStatusBuffer
+{
+private:
+    typedef std::map<Poco::UInt32 /*account*/, bool /*online*/> StatusMap;
+
+    class FlushJob : public DatabaseJob
+    {
+    public:
+        FlushJob(StatusMap& status);
+
+        void execute(Database& database);
+
+    private:
+        StatusMap _status;
+    };
+
+public:
+    OnlineStatusBuffer();
+
+    static OnlineStatusBuffer& instance()
+    {
+        static Poco::SingletonHolder<OnlineStatusBuffer> sh;
+        return *sh.get();
+    }
+
+    void setOnline(Poco::UInt32 account, bool online);
+    bool getOnline(Poco::UInt32 account, bool& online);
+
+    void update();
+    void flush(bool wait = false);
+
+private:
+    void onFlushed(bool success);
+
+private:
+    StatusMap _pending;
+    StatusMap _flushing;
+    bool _inFlight;
+    Poco::Timestamp _lastFlush;
+    Poco::UInt32 _interval;
+    Poco::FastMutex _mutex;
+};
+
+#define sOnlineStatus OnlineStatusBuffer::instance()
+
+#endif
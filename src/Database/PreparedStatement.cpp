@@ -1,71 +1,54 @@
 #include "PreparedStatement.h"
-#include "PreparedStatementData.h"
+#include "Log.h"
 
-#include "Poco/Data/Binding.h"
+#include "Poco/Timestamp.h"
 
 using namespace Poco::Data;
-using namespace Poco::Data::Keywords;
 
-PreparedStatement::PreparedStatement(Statement stmt):
-    _stmt(stmt)
-{
-    std::string query = _stmt.toString();
-    data.resize(std::count(query.begin(), query.end(), '?'));
+Poco::UInt32 PreparedStatementBase::MaxRetries = 3;
 
-    for (Poco::UInt8 i = 0; i < data.size(); ++i)
-        _stmt, use(data[i]);
-}
-    
-void PreparedStatement::bindString(Poco::UInt8 pos, std::string str)
+PreparedStatementBase::PreparedStatementBase(Statement stmt, StatementStats* stats):
+    _stmt(stmt), _stats(stats)
 {
-    data[pos].dataType = DATA_STRING;
-    data[pos].str = str;
 }
 
-void PreparedStatement::bindUInt8(Poco::UInt8 pos, Poco::UInt8 value)
+PreparedStatementBase::~PreparedStatementBase()
 {
-    data[pos].dataType = DATA_UINT8;
-    data[pos].u8 = value;
 }
 
-void PreparedStatement::bindUInt16(Poco::UInt8 pos, Poco::UInt16 value)
+/**
+ * Executes the statement with the values currently bound, retrying a few
+ * times on failure
+ *
+ * @throw Poco::Exception The last error, if all the retries failed
+ */
+void PreparedStatementBase::run()
 {
-    data[pos].dataType = DATA_UINT16;
-    data[pos].u16 = value;
-}
+    Poco::Timestamp start;
 
-void PreparedStatement::bindUInt32(Poco::UInt8 pos, Poco::UInt32 value)
-{
-    data[pos].dataType = DATA_UINT32;
-    data[pos].u32 = value;
-}
+    for (Poco::UInt32 attempt = 0; ; ++attempt)
+    {
+        try
+        {
+            do
+            {
+                _stmt.execute();
+            }
+            while (!_stmt.done());
 
-void PreparedStatement::bindUInt64(Poco::UInt8 pos, Poco::UInt64 value)
-{
-    data[pos].dataType = DATA_UINT64;
-    data[pos].u64 = value;
-}
+            _stats->record(start.elapsed(), attempt + 1, true);
+            return;
+        }
+        catch (Poco::Exception& ex)
+        {
+            LOG_OUT(LOG_DB, Message::PRIO_ERROR, "MYSQL Error: %s", ex.message().c_str());
+            reset();
 
-void PreparedStatement::bindInt8(Poco::UInt8 pos, Poco::Int8 value)
-{
-    data[pos].dataType = DATA_INT8;
-    data[pos].i8 = value;
-}
-
-void PreparedStatement::bindInt16(Poco::UInt8 pos, Poco::Int16 value)
-{
-    data[pos].dataType = DATA_INT16;
-    data[pos].i16 = value;
-}
-
-void PreparedStatement::bindInt32(Poco::UInt8 pos, Poco::Int32 value)
-{
-    data[pos].dataType = DATA_INT32;
-    data[pos].i32 = value;
-}
-
-void PreparedStatement::bindInt64(Poco::UInt8 pos, Poco::Int64 value)
-{
-    data[pos].dataType = DATA_INT64;
-    data[pos].i64 = value;
+            if (attempt >= MaxRetries)
+            {
+                _stats->record(start.elapsed(), attempt + 1, false);
+                throw;
+            }
+        }
+    }
 }
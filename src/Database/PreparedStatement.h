@@ -1,50 +1,122 @@
 #ifndef GAMESERVER_PREPARED_STATEMENT_H
 #define GAMESERVER_PREPARED_STATEMENT_H
 
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
 #include "Poco/Poco.h"
 #include "Poco/Data/Data.h"
-#include "Poco/Data/RecordSet.h"
 #include "Poco/Data/Statement.h"
 
+#include "StatementDefinition.h"
+#include "StatementStats.h"
+#include "TupleTypeHandler.h"
+
 using namespace Poco::Data;
 
-class PreparedStatementData;
+/**
+ * Untyped part of a prepared statement, so that statements of different
+ * definitions can be stored together
+ */
+class PreparedStatementBase
+{
+public:
+    PreparedStatementBase(Statement stmt, StatementStats* stats);
+    virtual ~PreparedStatementBase();
+
+public:
+    static Poco::UInt32 MaxRetries;
+
+protected:
+    void run();
+
+    // Drops whatever a failed attempt has fetched
+    virtual void reset() = 0;
+
+protected:
+    Statement _stmt;
+    StatementStats* _stats;
+};
 
-class PreparedStatement
+/**
+ * A statement of a given definition. Parameters and rows are bound by
+ * reference once, when it is prepared, so executing it only copies the
+ * parameters in and the rows out
+ */
+template <class S>
+class PreparedStatement : public PreparedStatementBase
 {
 public:
-    PreparedStatement(Statement stmt);
-
-    void bindString(Poco::UInt8 pos, std::string str);
-    void bindUInt8(Poco::UInt8 pos, Poco::UInt8 value);
-    void bindUInt16(Poco::UInt8 pos, Poco::UInt16 value);
-    void bindUInt32(Poco::UInt8 pos, Poco::UInt32 value);
-    void bindUInt64(Poco::UInt8 pos, Poco::UInt64 value);
-    void bindInt8(Poco::UInt8 pos, Poco::Int8 value);
-    void bindInt16(Poco::UInt8 pos, Poco::Int16 value);
-    void bindInt32(Poco::UInt8 pos, Poco::Int32 value);
-    void bindInt64(Poco::UInt8 pos, Poco::Int64 value);
-    
-    inline RecordSet execute()
-    {
-        while (true)
-        {
-            try
-            {
-                _stmt.execute();
-                if (_stmt.done())
-                    return RecordSet(_stmt);
-            }
-            catch (Poco::Exception& ex)
-            {
-                printf("MYSQL Error: %s\n", ex.message().c_str());
-            }
-        }
+    typedef typename S::Parameters Parameters;
+    typedef typename S::Row Row;
+    typedef std::vector<Row> Rows;
+
+    PreparedStatement(Statement stmt, StatementStats* stats):
+        PreparedStatementBase(stmt, stats)
+    {
+        bindParameters(std::integral_constant<bool, (std::tuple_size<Parameters>::value > 0)>());
+        bindRows(std::integral_constant<bool, (std::tuple_size<Row>::value > 0)>());
+    }
+
+    /**
+     * Executes the statement, retrying a few times on failure
+     *
+     * @param parameters Values of the placeholders
+     * @param rows Output, the resulting rows
+     * @throw Poco::Exception The last error, if all the retries failed
+     */
+    void execute(const Parameters& parameters, Rows& rows)
+    {
+        _parameters = parameters;
+        run();
+        _stats->recordRows(_rows.size());
+        rows.swap(_rows);
+        _rows.clear();
+    }
+
+    /**
+     * Executes a statement whose rows, if any, are not needed
+     *
+     * @param parameters Values of the placeholders
+     * @throw Poco::Exception The last error, if all the retries failed
+     */
+    void execute(const Parameters& parameters)
+    {
+        _parameters = parameters;
+        run();
+        _stats->recordRows(_rows.size());
+        _rows.clear();
+    }
+
+protected:
+    void reset()
+    {
+        _rows.clear();
     }
 
 private:
-    Statement _stmt;
-    std::vector<PreparedStatementData> data;
+    void bindParameters(std::true_type)
+    {
+        _stmt, Keywords::use(_parameters);
+    }
+
+    void bindParameters(std::false_type)
+    {
+    }
+
+    void bindRows(std::true_type)
+    {
+        _stmt, Keywords::into(_rows);
+    }
+
+    void bindRows(std::false_type)
+    {
+    }
+
+private:
+    Parameters _parameters;
+    Rows _rows;
 };
 
-#endif
\ No newline at end of file
+#endif
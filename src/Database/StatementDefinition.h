@@ -0,0 +1,45 @@
+#ifndef GAMESERVER_STATEMENT_DEFINITION_H
+#define GAMESERVER_STATEMENT_DEFINITION_H
+
+#include <cstddef>
+#include <tuple>
+
+#include "Poco/Poco.h"
+
+/**
+ * Number of '?' placeholders on a query, evaluated at compile time
+ *
+ * @param query SQL of the statement
+ * @return Placeholders count
+ */
+constexpr std::size_t countPlaceholders(const char* query)
+{
+    return *query ? (*query == '?') + countPlaceholders(query + 1) : 0;
+}
+
+// Row of statements which return nothing
+typedef std::tuple<> NoRow;
+
+/**
+ * Declares a statement: its index on the database, the row it returns and
+ * the types of its parameters, in placeholder order. Each statement is a
+ * struct deriving from it, so that it can be forward declared, e.g.
+ *
+ *  struct CharactersUpdateGUID : StatementDefinition<QUERY_CHARACTERS_UPDATE_GUID, NoRow, Poco::UInt32, Poco::UInt32> {};
+ *
+ * Rows are tuples, decoded column by column straight from the result
+ */
+template <Poco::UInt8 I, class R, class... P>
+struct StatementDefinition
+{
+    enum
+    {
+        Index = I,
+        ParametersCount = sizeof...(P)
+    };
+
+    typedef std::tuple<P...> Parameters;
+    typedef R Row;
+};
+
+#endif
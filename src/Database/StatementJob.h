@@ -0,0 +1,79 @@
+#ifndef GAMESERVER_STATEMENT_JOB_H
+#define GAMESERVER_STATEMENT_JOB_H
+
+#include <functional>
+#include <utility>
+
+#include "Database.h"
+#include "DatabaseJob.h"
+#include "Log.h"
+#include "PreparedStatement.h"
+
+/**
+ * A single statement executed on a database worker. Parameters are given
+ * on construction, and must match the statement definition, e.g.
+ *
+ *  new StatementJob<CharactersUpdateGUID>(GUID, characterID);
+ */
+template <class S>
+class StatementJob : public DatabaseJob
+{
+public:
+    typedef typename S::Parameters Parameters;
+    typedef typename S::Row Row;
+    typedef std::vector<Row> Rows;
+    typedef std::function<void (StatementJob<S>&)> Callback;
+
+    template <class... Args>
+    explicit StatementJob(Args&&... args):
+        _parameters(std::forward<Args>(args)...)
+    {
+    }
+
+    /**
+     * Executes the statement on the worker own prepared statement
+     *
+     * @param database Database the job was queued on
+     */
+    void execute(Database& database)
+    {
+        try
+        {
+            database.getStatement<S>()->execute(_parameters, _rows);
+            _success = true;
+        }
+        catch (Poco::Exception& ex)
+        {
+            LOG_OUT(LOG_DB, Message::PRIO_ERROR, "Database job failed: %s", ex.displayText().c_str());
+            _success = false;
+        }
+    }
+
+    void complete()
+    {
+        if (_callback)
+            _callback(*this);
+    }
+
+    bool hasCallback()
+    {
+        return (bool)_callback;
+    }
+
+    inline void setCallback(const Callback& callback)
+    {
+        _callback = callback;
+    }
+
+    inline Rows& getRows()
+    {
+        return _rows;
+    }
+
+private:
+    Parameters _parameters;
+    Rows _rows;
+    Callback _callback;
+};
+
+#endif
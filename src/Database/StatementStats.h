@@ -0,0 +1,72 @@
+#ifndef GAMESERVER_STATEMENT_STATS_H
+#define GAMESERVER_STATEMENT_STATS_H
+
+#include <atomic>
+
+#include "Poco/Poco.h"
+
+// Latency buckets, bucket i holds executions under 2^(i+1) microseconds,
+// and the last one all the slower ones
+#define STATEMENT_STATS_BUCKETS 24
+
+/**
+ * Counters of a statement on a single thread. Only the thread executing the
+ * statement writes them, so no atomic read-modify-write is needed, readers
+ * merge the counters of all the threads
+ */
+struct StatementStats
+{
+    StatementStats(Poco::UInt8 index):
+        index(index), executions(0), failures(0), retries(0), rows(0), time(0), maxTime(0)
+    {
+        for (Poco::UInt8 i = 0; i < STATEMENT_STATS_BUCKETS; ++i)
+            histogram[i] = 0;
+    }
+
+    /**
+     * Records an execution
+     *
+     * @param elapsed Microseconds, including the retries
+     * @param attempts Times it has been executed
+     * @param success Whether the last attempt succeeded
+     */
+    inline void record(Poco::UInt64 elapsed, Poco::UInt32 attempts, bool success)
+    {
+        add(executions, 1);
+        add(retries, attempts - 1);
+        add(time, elapsed);
+
+        if (!success)
+            add(failures, 1);
+
+        if (elapsed > maxTime.load(std::memory_order_relaxed))
+            maxTime.store(elapsed, std::memory_order_relaxed);
+
+        Poco::UInt8 bucket = 0;
+        while (bucket < STATEMENT_STATS_BUCKETS - 1 && (elapsed >> (bucket + 1)))
+            ++bucket;
+
+        add(histogram[bucket], 1);
+    }
+
+    inline void recordRows(Poco::UInt64 count)
+    {
+        add(rows, count);
+    }
+
+    static inline void add(std::atomic<Poco::UInt64>& counter, Poco::UInt64 value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    const Poco::UInt8 index;
+    std::atomic<Poco::UInt64> executions;
+    std::atomic<Poco::UInt64> failures;
+    std::atomic<Poco::UInt64> retries;
+    std::atomic<Poco::UInt64> rows;
+    std::atomic<Poco::UInt64> time;
+    std::atomic<Poco::UInt64> maxTime;
+    std::atomic<Poco::UInt64> histogram[STATEMENT_STATS_BUCKETS];
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef GAMESERVER_TUPLE_TYPE_HANDLER_H
+#define GAMESERVER_TUPLE_TYPE_HANDLER_H
+
+#include <tuple>
+
+#include "Poco/Poco.h"
+#include "Poco/Data/TypeHandler.h"
+
+namespace Poco {
+namespace Data {
+
+/**
+ * Walks the elements of a tuple, each one takes as many columns as its own
+ * TypeHandler says. Binders, preparators and extractors are passed through
+ * untouched, whatever pointer type Poco uses for them
+ */
+template <std::size_t I, class T, bool End = (I == std::tuple_size<T>::value)>
+struct TupleColumns
+{
+    typedef typename std::tuple_element<I, T>::type Element;
+    typedef TupleColumns<I + 1, T> Next;
+
+    static std::size_t size()
+    {
+        return TypeHandler<Element>::size() + Next::size();
+    }
+
+    template <class Binder>
+    static void bind(std::size_t pos, const T& obj, Binder binder, AbstractBinder::Direction dir)
+    {
+        TypeHandler<Element>::bind(pos, std::get<I>(obj), binder, dir);
+        Next::bind(pos + TypeHandler<Element>::size(), obj, binder, dir);
+    }
+
+    template <class Preparator>
+    static void prepare(std::size_t pos, const T& obj, Preparator preparator)
+    {
+        TypeHandler<Element>::prepare(pos, std::get<I>(obj), preparator);
+        Next::prepare(pos + TypeHandler<Element>::size(), obj, preparator);
+    }
+
+    template <class Extractor>
+    static void extract(std::size_t pos, T& obj, const T& defVal, Extractor extractor)
+    {
+        TypeHandler<Element>::extract(pos, std::get<I>(obj), std::get<I>(defVal), extractor);
+        Next::extract(pos + TypeHandler<Element>::size(), obj, defVal, extractor);
+    }
+};
+
+template <std::size_t I, class T>
+struct TupleColumns<I, T, true>
+{
+    static std::size_t size()
+    {
+        return 0;
+    }
+
+    template <class Binder>
+    static void bind(std::size_t, const T&, Binder, AbstractBinder::Direction)
+    {
+    }
+
+    template <class Preparator>
+    static void prepare(std::size_t, const T&, Preparator)
+    {
+    }
+
+    template <class Extractor>
+    static void extract(std::size_t, T&, const T&, Extractor)
+    {
+    }
+};
+
+template <class... E>
+class TypeHandler<std::tuple<E...> >
+{
+public:
+    typedef std::tuple<E...> Tuple;
+
+    static std::size_t size()
+    {
+        return TupleColumns<0, Tuple>::size();
+    }
+
+    template <class Binder>
+    static void bind(std::size_t pos, const Tuple& obj, Binder binder, AbstractBinder::Direction dir)
+    {
+        TupleColumns<0, Tuple>::bind(pos, obj, binder, dir);
+    }
+
+    template <class Preparator>
+    static void prepare(std::size_t pos, const Tuple& obj, Preparator preparator)
+    {
+        TupleColumns<0, Tuple>::prepare(pos, obj, preparator);
+    }
+
+    template <class Extractor>
+    static void extract(std::size_t pos, Tuple& obj, const Tuple& defVal, Extractor extractor)
+    {
+        TupleColumns<0, Tuple>::extract(pos, obj, defVal, extractor);
+    }
+};
+
+}
+}
+
+#endif
@@ -24,6 +24,7 @@ public:
     inline void SetMaxHP(Poco::UInt32 maxhp)
     {
         _maxhp = maxhp;
+        setDirty(DIRTY_HP);
     }
 
     inline Poco::UInt32 GetHP()
@@ -34,6 +35,7 @@ public:
     inline void SetHP(Poco::UInt32 hp)
     {
         _hp = hp;
+        setDirty(DIRTY_HP);
     }
 
     inline Poco::UInt32 GetMaxMP()
@@ -44,6 +46,7 @@ public:
     inline void SetMaxMP(Poco::UInt32 maxmp)
     {
         _maxmp = maxmp;
+        setDirty(DIRTY_MP);
     }
 
     inline Poco::UInt32 GetMP()
@@ -54,6 +57,7 @@ public:
     inline void SetMP(Poco::UInt32 mp)
     {
         _mp = mp;
+        setDirty(DIRTY_MP);
     }
 
     inline Poco::UInt8 GetLVL()
@@ -64,6 +68,7 @@ public:
     inline void SetLVL(Poco::UInt8 lvl)
     {
         _lvl = lvl;
+        setDirty(DIRTY_LEVEL);
     }
 
     inline float getFacingTo()
@@ -14,9 +14,9 @@ bool Creature::update(const Poco::UInt64 diff)
 {
     if (checkLOS())
     {
-        SharedPtr<Object> target = getSector()->selectTargetInAggroRange();
+        Object* target = getSector()->selectTargetInAggroRange();
 
-        if (!target.isNull())
+        if (target)
         {
             // attackStart(target);
         }
@@ -14,7 +14,9 @@
  */
 Object::Object(Client* client):
     _client(client),
-    _GUID(ObjectManager::MAX_GUID)
+    _GUID(ObjectManager::MAX_GUID),
+    _handle(INVALID_OBJECT_HANDLE),
+    _dirty(0)
 {
     // Reset all flags
     for (Poco::UInt8 i = 0; i < MAX_FLAGS_TYPES; ++i)
@@ -43,22 +45,29 @@ Object::~Object()
  */
 bool Object::update(const Poco::UInt64 diff)
 {
-    if (hasFlag(FLAGS_TYPE_MOVEMENT, FLAG_MOVING))
+    if (hasFlag(FLAGS_TYPE_MOVEMENT, FLAG_MOVING) && motionMaster.isBound())
     {
         // Save the previous grid
         Poco::UInt8 gridX = GetPosition().gridX;
         Poco::UInt8 gridY = GetPosition().gridY;
 
+        // The position has already been integrated by the Grid movement table
         // Check if movement has finalized, in which case, remove flag
         Vector2D newPos;
-        if (motionMaster.evaluate(diff, newPos))
+        bool crossed = false;
+        bool finished = motionMaster.evaluate(newPos, crossed);
+        if (finished)
         {
             //sLog.out(Message::PRIO_TRACE, "\t\tObject finished movement (%.2f, %.2f)", GetPosition().x, GetPosition().z);
             clearFlag(FLAGS_TYPE_MOVEMENT, FLAG_MOVING);
         }
 
-        // Relocate to the new position
-        Relocate(newPos);
+        // Relocate to the new position, cell and sector are only
+        // recomputed when the movement table reports a crossing
+        if (crossed || finished)
+            Relocate(newPos);
+        else
+            RelocateInSector(newPos.x, newPos.z);
 
         // Return if grid has changed
         return gridX == GetPosition().gridX && gridY == GetPosition().gridY;
@@ -111,6 +120,21 @@ void Object::Relocate(Vector2D position)
 {
     _position.Relocate(position);
     _position.Process();
+    setDirty(DIRTY_POSITION);
+}
+
+/**
+ * Updates the coordinates without recomputing cell and sector, only valid
+ * when they are known not to have changed
+ *
+ * @param x New x coordinate
+ * @param z New z coordinate
+ */
+void Object::RelocateInSector(float x, float z)
+{
+    _position.x = x;
+    _position.z = z;
+    setDirty(DIRTY_POSITION);
 }
 
 float Object::distanceTo(Object* to)
@@ -2,6 +2,7 @@
 #define GAMESERVER_ENTITIES_OBJECT_H
 
 #include <algorithm>
+#include <atomic>
 #include <list>
 #include "hash_map.h"
 #include "stack_allocator.h"
@@ -12,6 +13,7 @@
 
 #include "defines.h"
 #include "MotionMaster.h"
+#include "ObjectPool.h"
 #include "Position.h"
 
 using Poco::SharedPtr;
@@ -28,6 +30,14 @@ enum OBJECT_MOVEMENT_FLAGS
     FLAG_FLYING = 2,
 };
 
+enum OBJECT_DIRTY_FIELDS
+{
+    DIRTY_POSITION  = 1,
+    DIRTY_HP        = 2,
+    DIRTY_MP        = 4,
+    DIRTY_LEVEL     = 8,
+};
+
 class Character;
 class Client;
 class Creature;
@@ -48,6 +58,16 @@ public:
     Poco::UInt32 GetHighGUID();
     Poco::UInt32 GetLowGUID();
 
+    inline void SetHandle(ObjectHandle handle)
+    {
+        _handle = handle;
+    }
+
+    inline ObjectHandle GetHandle()
+    {
+        return _handle;
+    }
+
     inline void setFlag(Poco::UInt8 flagType, Poco::UInt64 flag)
     {
          _flags[flagType] |= flag;
@@ -63,12 +83,26 @@ public:
         _flags[flagType] &= ~flag;
     }
 
+    inline void setDirty(Poco::UInt32 fields)
+    {
+        _dirty.fetch_or(fields, std::memory_order_relaxed);
+    }
+
+    /**
+     * Gets and clears the fields changed since the last call
+     */
+    inline Poco::UInt32 takeDirty()
+    {
+        return _dirty.exchange(0, std::memory_order_relaxed);
+    }
+
     Vector2D GetPosition()
     {
         return _position;
     }
 
     void Relocate(Vector2D position);
+    void RelocateInSector(float x, float z);
 
     inline Grid* GetGrid()
     {
@@ -129,7 +163,9 @@ public:
 
 private:
     Poco::UInt64 _GUID;
+    ObjectHandle _handle;
     Poco::UInt64 _flags[MAX_FLAGS_TYPES];
+    std::atomic<Poco::UInt32> _dirty;
     Poco::Timestamp _lastUpdate;
     Poco::Timestamp _losTrigger;
     Vector2D _position;
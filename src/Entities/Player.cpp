@@ -2,6 +2,7 @@
 #include "defines.h"
 #include "Server.h"
 #include "Creature.h"
+#include "Grid.h"
 #include "ObjectManager.h"
 #include "Packet.h"
 #include "Sector.h"
@@ -26,7 +27,8 @@ Player::~Player()
 
 bool Player::update(const Poco::UInt64 diff)
 {
-    // Process join events on the grid
+    // Resolve the previous tick join events on the grid, packets are
+    // queued on the Grid and sent during the next tick flush
     if (Sector* sector = getSector())
     {
         if (sector->hasEvents())
@@ -34,8 +36,8 @@ bool Player::update(const Poco::UInt64 diff)
             // Get all the join events
             Sector::TypeSectorEvents* sectorEvents = sector->getEvents();
 
-            Packet* spawnPacket = NULL;
-            Packet* despawnPacket = NULL;
+            SharedPtr<Packet> spawnPacket;
+            SharedPtr<Packet> despawnPacket;
 
             for (Sector::TypeSectorEvents::iterator itr = sectorEvents->begin(); itr != sectorEvents->end();)
             {
@@ -43,52 +45,44 @@ bool Player::update(const Poco::UInt64 diff)
                 ++itr;
 
                 // Avoid self sending
-                if (GetGUID() == sectorEvent->Who->GetGUID())
+                if (GetHandle() == sectorEvent->Who)
                     continue;
 
                 switch (sectorEvent->EventType)
                 {
                     case EVENT_BROADCAST_JOIN:
                     {
-                        if (spawnPacket == NULL)
+                        if (spawnPacket.isNull())
                             spawnPacket = sServer->buildSpawnPacket(this, false);
 
                         // Send spawn of the visitor
-                        if (sectorEvent->Who->GetHighGUID() & HIGH_GUID_PLAYER)
-                            sServer->sendPacketTo(spawnPacket, sectorEvent->Who);
+                        if (HANDLE_TYPE(sectorEvent->Who) == HIGH_GUID_PLAYER)
+                            GetGrid()->queuePacket(spawnPacket, sectorEvent->Who);
 
                         // Send spawn to the visitor
-                        sServer->sendPacketTo(sectorEvent->EventPacket, this);
+                        GetGrid()->queuePacket(sectorEvent->EventPacket, GetHandle());
 
                         break;
                     }
 
                     case EVENT_BROADCAST_LEAVE:
                     {
-                        if (despawnPacket == NULL)
+                        if (despawnPacket.isNull())
                             despawnPacket = sServer->buildDespawnPacket(GetGUID());
 
                         // Send spawn of the visitor
-                        if (sectorEvent->Who->GetHighGUID() & HIGH_GUID_PLAYER)
-                            sServer->sendPacketTo(despawnPacket, sectorEvent->Who);
+                        if (HANDLE_TYPE(sectorEvent->Who) == HIGH_GUID_PLAYER)
+                            GetGrid()->queuePacket(despawnPacket, sectorEvent->Who);
 
                         // Send spawn to the visitor
-                        sServer->sendPacketTo(sectorEvent->EventPacket, this);
+                        GetGrid()->queuePacket(sectorEvent->EventPacket, GetHandle());
 
                         break;
                     }
                 }
             }
-
-            if (spawnPacket)
-                delete spawnPacket;
-
-            if (despawnPacket)
-                delete despawnPacket;
         }
     }
 
     return Object::update(diff);
 }
-
-
@@ -6,10 +6,12 @@
 #include "Creature.h"
 #include "Log.h"
 #include "Object.h"
+#include "ObjectManager.h"
 #include "Packet.h"
 #include "Player.h"
 #include "Server.h"
 #include "Tools.h"
+#include "Trace.h"
 
 Poco::UInt8 Grid::LOSRange;
 Poco::UInt8 Grid::AggroRange;
@@ -21,7 +23,9 @@ Poco::UInt32 Grid::GridRemove;
  */
 Grid::Grid(Poco::UInt16 x, Poco::UInt16 y):
     _x(x), _y(y),
-    _playersCount(0)
+    _playersCount(0),
+    _writeOutgoing(0),
+    _flushed(0)
 {
     forceLoad();
 }
@@ -46,7 +50,16 @@ Grid::~Grid()
  */
 bool Grid::update(Poco::UInt64 diff)
 {
+    TRACE_SCOPE("Grid::update");
     Poco::Mutex::ScopedLock lock(_mutex);
+
+    // Integrate all movements at once, objects only read their new position
+    // and those which crossed a sector are flagged to be bucketed again
+    _movement.integrate(diff / 1000.0f);
+
+    MovementTable::TypeHandleList& crossings = _movement.getCrossings();
+    for (MovementTable::TypeHandleList::iterator itr = crossings.begin(); itr != crossings.end(); ++itr)
+        _movement.getOwner(*itr)->motionMaster.setCrossed();
     
     // Iterate a safe list
     TypeSectorsMap sectors = _sectors;
@@ -84,7 +97,7 @@ bool Grid::update(Poco::UInt64 diff)
  * @param object Object which we must find near grids
  * @return the list of near grids
  */
-Grid::GridsList Grid::findNearGrids(SharedPtr<Object> object)
+Grid::GridsList Grid::findNearGrids(Object* object)
 {
     Vector2D position = object->GetPosition();
     Poco::UInt16 gridX = Tools::GetPositionInXCell(GetPositionX(), position.x);
@@ -181,11 +194,16 @@ Sector* Grid::getOrLoadSector_i(Poco::UInt16 hash)
  * @param object Object to be added
  * @return true if the object has been added
  */
-bool Grid::addObject(SharedPtr<Object> object)
+bool Grid::addObject(Object* object)
 {
-    if (getOrLoadSector(object->GetPosition().sector)->add(object))
+    Poco::Mutex::ScopedLock lock(_mutex);
+
+    if (getOrLoadSector_i(object->GetPosition().sector)->add(object))
     {
         object->SetGrid(this);
+
+        // Keeps moving on this Grid movement table, if it was moving
+        object->motionMaster.bind(&_movement, object);
         return true;
     }
 
@@ -196,12 +214,75 @@ bool Grid::addObject(SharedPtr<Object> object)
  * Removes an object from the Grid
  *
  */
-void Grid::removeObject(SharedPtr<Object> object)
+void Grid::removeObject(Object* object)
 {
-    getOrLoadSector(object->GetPosition().sector)->remove(object);
+    Poco::Mutex::ScopedLock lock(_mutex);
+
+    object->motionMaster.unbind();
+    getOrLoadSector_i(object->GetPosition().sector)->remove(object);
 }
 
 
+/**
+ * Queues a packet to be sent on the next tick flush stage. Packets are
+ * resolved during the simulation, but serialized and sent while the
+ * next tick simulates
+ *
+ * @param packet Packet to be sent, must not be deleted on send
+ * @param to Handle of the object which will receive it
+ */
+void Grid::queuePacket(SharedPtr<Packet> packet, ObjectHandle to)
+{
+    OutgoingPacket outgoing = {packet, to};
+    _outgoing[_writeOutgoing].push_back(outgoing);
+}
+
+/**
+ * Checks whether the previous tick has left packets to be sent
+ *
+ * @return true if there is something to flush
+ */
+bool Grid::hasOutgoing()
+{
+    return !_outgoing[_writeOutgoing ^ 1].empty();
+}
+
+/**
+ * Sends all the packets queued during the previous tick. Runs on the
+ * broadcast workers, concurrently with this Grid update
+ *
+ */
+void Grid::flush()
+{
+    TypeOutgoingList& outgoing = _outgoing[_writeOutgoing ^ 1];
+    for (TypeOutgoingList::iterator itr = outgoing.begin(); itr != outgoing.end(); ++itr)
+    {
+        // The object might have been destroyed since the packet was queued
+        Object* to = sObjectManager.resolve(itr->To);
+        if (to)
+        {
+            sServer->sendPacketTo(itr->Data, to);
+            ++_flushed;
+        }
+    }
+
+    outgoing.clear();
+}
+
+/**
+ * Publishes this tick sector events and outgoing packets for the next tick.
+ * Must only be called when neither updates nor flushes are running
+ *
+ */
+void Grid::swapBuffers()
+{
+    for (TypeSectorsMap::iterator itr = _sectors.begin(); itr != _sectors.end(); ++itr)
+        itr->second->swapEvents();
+
+    _writeOutgoing ^= 1;
+    _flushed = 0;
+}
+
 /**
  * Forces a Grid to remain loaded (this happens when a players gets near to a grid!)
  *
@@ -2,6 +2,8 @@
 #define GAMESERVER_GRID_H
 
 #include "defines.h"
+#include "MovementTable.h"
+#include "ObjectPool.h"
 
 //@ Poco includes
 #include "Poco/SharedPtr.h"
@@ -9,6 +11,7 @@
 
 //@ List and Hash Map
 #include <list>
+#include <vector>
 #include "hash_map.h"
 #include "stack_allocator.h"
 
@@ -16,6 +19,7 @@ using Poco::SharedPtr;
 using Poco::Timestamp;
 
 class Object;
+class Packet;
 class Sector;
 
 class Grid
@@ -25,6 +29,13 @@ class Grid
 private:
     typedef rde::hash_map<Poco::UInt16 /*hash*/, Sector*> TypeSectorsMap;
 
+    struct OutgoingPacket
+    {
+        SharedPtr<Packet> Data;
+        ObjectHandle To;
+    };
+    typedef std::vector<OutgoingPacket> TypeOutgoingList;
+
 public:
     typedef std::list<Grid*> GridsList;
 
@@ -34,10 +45,20 @@ public:
 
     Sector* getOrLoadSector(Poco::UInt16 hash);
 
-    bool addObject(SharedPtr<Object> object);
-    void removeObject(SharedPtr<Object> object);
+    bool addObject(Object* object);
+    void removeObject(Object* object);
+
+    GridsList findNearGrids(Object* object);
 
-    GridsList findNearGrids(SharedPtr<Object> object);
+    void queuePacket(SharedPtr<Packet> packet, ObjectHandle to);
+    bool hasOutgoing();
+    void flush();
+    void swapBuffers();
+
+    inline Poco::UInt32 getFlushed()
+    {
+        return _flushed;
+    }
     
     inline Poco::UInt16 GetPositionX()
     {
@@ -54,6 +75,11 @@ public:
         return (_x << 16) |  _y;
     }
 
+    inline MovementTable* getMovementTable()
+    {
+        return &_movement;
+    }
+
     inline bool hasPlayers()
     {
         return _playersCount > 0;
@@ -82,6 +108,10 @@ public:
 
 private:
     TypeSectorsMap _sectors;
+    MovementTable _movement;
+    TypeOutgoingList _outgoing[2];
+    Poco::UInt8 _writeOutgoing;
+    Poco::UInt32 _flushed;
     Poco::UInt32 _playersCount;
     Poco::Mutex _mutex;
     Timestamp _forceLoad;
@@ -0,0 +1,17 @@
+#include "GridBroadcastTask.h"
+#include "Grid.h"
+#include "Trace.h"
+
+GridBroadcastTask::GridBroadcastTask(Grid* grid):
+    Task(""),
+    _grid(grid)
+{
+}
+
+void GridBroadcastTask::runTask()
+{
+    TRACE_SCOPE("GridBroadcastTask::runTask");
+
+    if (_grid->hasOutgoing())
+        _grid->flush();
+}
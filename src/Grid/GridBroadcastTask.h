@@ -0,0 +1,24 @@
+#ifndef GAMESERVER_GRID_BROADCAST_TASK_H
+#define GAMESERVER_GRID_BROADCAST_TASK_H
+
+#include "Poco/Task.h"
+
+class Grid;
+
+class GridBroadcastTask: public Poco::Task
+{
+public:
+    GridBroadcastTask(Grid* grid);
+
+    void runTask();
+
+    inline Grid* getGrid()
+    {
+        return _grid;
+    }
+
+private:
+    Grid* _grid;
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include "GridLoader.h"
 #include "Grid.h"
+#include "GridBroadcastTask.h"
 #include "GridManager.h"
 #include "GridTask.h"
 
@@ -9,6 +10,7 @@
 #include "Server.h"
 #include "ServerConfig.h"
 #include "Tools.h"
+#include "Trace.h"
 
 #include "Poco/Observer.h"
 #include "Poco/Timestamp.h"
@@ -23,10 +25,16 @@ using Poco::Timestamp;
  */
 GridLoader::GridLoader()
 {
+    _stats = UpdateStats();
+
     // Create the GridManager and add a grid finished update callback
     _gridManager = new GridManager(sConfig.getDefaultInt("MapThreads", 1));
     _gridManager->addObserver(Observer<GridLoader, Poco::TaskFinishedNotification>(*this, &GridLoader::gridUpdated));
 
+    // Packets are sent by another set of threads, while the next tick simulates
+    _broadcastManager = new GridManager(sConfig.getDefaultInt("BroadcastThreads", 1));
+    _broadcastManager->addObserver(Observer<GridLoader, Poco::TaskFinishedNotification>(*this, &GridLoader::gridBroadcasted));
+
     for (Poco::UInt16 x = 0; x < MAX_X; ++x)
         for (Poco::UInt16 y = 0; y < MAX_Y; ++y)
             _isGridLoaded[x][y] = false;
@@ -35,10 +43,11 @@ GridLoader::GridLoader()
     Grid::LOSRange = sConfig.getDefaultInt("LOSRange", 35);
     Grid::AggroRange = sConfig.getDefaultInt("AggroRange", 15);
     Grid::GridRemove = sConfig.getDefaultInt("GridRemove", 15000);
-    sLog.out(Message::PRIO_TRACE, "\t[OK] LoS Range set to: %d", Grid::GridRemove);
-    sLog.out(Message::PRIO_TRACE, "\t[OK] Aggro Range set to: %d", Grid::AggroRange);
-    sLog.out(Message::PRIO_TRACE, "\t[OK] Grid Remove interval set to: %d", Grid::LOSRange);
-    sLog.out(Message::PRIO_TRACE, "\t[OK] Map threads set to: %d", _gridManager->getMaxThreads());
+    LOG_OUT(LOG_GRID, Message::PRIO_TRACE, "\t[OK] LoS Range set to: %d", Grid::GridRemove);
+    LOG_OUT(LOG_GRID, Message::PRIO_TRACE, "\t[OK] Aggro Range set to: %d", Grid::AggroRange);
+    LOG_OUT(LOG_GRID, Message::PRIO_TRACE, "\t[OK] Grid Remove interval set to: %d", Grid::LOSRange);
+    LOG_OUT(LOG_GRID, Message::PRIO_TRACE, "\t[OK] Map threads set to: %d", _gridManager->getMaxThreads());
+    LOG_OUT(LOG_GRID, Message::PRIO_TRACE, "\t[OK] Broadcast threads set to: %d", _broadcastManager->getMaxThreads());
 
     // Check for correct grid size
     ASSERT((MAP_MAX_X - MAP_MIN_X) / UNITS_PER_CELL < MAX_X)
@@ -52,6 +61,7 @@ GridLoader::GridLoader()
 GridLoader::~GridLoader()
 {
     delete _gridManager;
+    delete _broadcastManager;
 
     for (GridsMap::const_iterator itr = _grids.begin(); itr != _grids.end(); )
     {
@@ -81,7 +91,7 @@ bool GridLoader::checkAndLoad(Poco::UInt16 x, Poco::UInt16 y)
     if (_grids.insert(rde::make_pair(grid->hashCode(), grid)).second)
     {
         _isGridLoaded[x][y] = true;
-        sLog.out(Message::PRIO_DEBUG, "Grid (%d, %d) has been created", x, y);
+        LOG_OUT(LOG_GRID, Message::PRIO_DEBUG, "Grid (%d, %d) has been created", x, y);
         return true;
     }
     else
@@ -134,7 +144,7 @@ Grid* GridLoader::GetGridOrLoad(Poco::UInt16 x, Poco::UInt16 y)
  * @param object Object to be added
  * @return Grid where the object has been added
  */
-Grid* GridLoader::addObjectTo(Poco::UInt16 x, Poco::UInt16 y, SharedPtr<Object> object)
+Grid* GridLoader::addObjectTo(Poco::UInt16 x, Poco::UInt16 y, Object* object)
 {
     if (!checkAndLoad(x, y))
         return NULL;
@@ -153,7 +163,7 @@ Grid* GridLoader::addObjectTo(Poco::UInt16 x, Poco::UInt16 y, SharedPtr<Object>
  * @param object Object to be added
  * @return Grid where it has been added
  */
-Grid* GridLoader::addObject(SharedPtr<Object> object)
+Grid* GridLoader::addObject(Object* object)
 {
     return addObjectTo(object->GetPosition().gridX, object->GetPosition().gridY, object);
 }
@@ -183,11 +193,28 @@ bool GridLoader::removeObject(Object* object)
 }
 
 /**
- * Thread where the Grids are updating
+ * Thread where the Grids are updating. A tick is split in stages:
+ * - Simulation and event resolution (GridTask), which moves objects and
+ *   resolves the previous tick sector events into packets
+ * - Flush (GridBroadcastTask), which serializes and sends the packets
+ *   resolved on the previous tick, overlapped with the simulation
+ * - Swap, where this tick events and packets are published for the next one
  *
  */
 void GridLoader::update(Poco::UInt64 diff)
 {
+    TRACE_SCOPE("GridLoader::update");
+
+    Timestamp start;
+    _stats.grids = (Poco::UInt32)_grids.size();
+    _stats.packets = 0;
+
+    // Send previous tick packets while this one simulates
+    for (GridsMap::const_iterator itr = _grids.begin(); itr != _grids.end(); ++itr)
+        _broadcastManager->queue(new GridBroadcastTask(itr->second));
+
+    _broadcastManager->start();
+
     // Iterate a safe list
     for (GridsMap::const_iterator itr = _grids.begin(); itr != _grids.end(); )
     {
@@ -201,21 +228,35 @@ void GridLoader::update(Poco::UInt64 diff)
     // Start all threads
     _gridManager->start();
 
-    // Wait for all map updates to end
+    // Wait for all map updates and flushes to end
     _gridManager->wait();
+    _stats.simulate = start.elapsed();
+    _broadcastManager->wait();
+    _stats.flush = start.elapsed() - _stats.simulate;
+
+    // Tick boundary, nothing is running on the grids now
+    TRACE_SCOPE("GridLoader::swap");
+    Timestamp swap;
+    for (GridsMap::const_iterator itr = _grids.begin(); itr != _grids.end(); ++itr)
+    {
+        _stats.packets += itr->second->getFlushed();
+        itr->second->swapBuffers();
+    }
     
     // Remove grids
     for (GridsSet::iterator itr = _remove.begin(); itr != _remove.end(); )
     {
         Grid* grid = *itr;
         ++itr;
-        sLog.out(Message::PRIO_DEBUG, "Grid (%d, %d) has been deleted", grid->GetPositionX(), grid->GetPositionY());
+        LOG_OUT(LOG_GRID, Message::PRIO_DEBUG, "Grid (%d, %d) has been deleted", grid->GetPositionX(), grid->GetPositionY());
 
         _isGridLoaded[grid->GetPositionX()][grid->GetPositionY()] = false;
         _grids.erase(grid->hashCode());
         delete grid;
     }
     _remove.clear();
+
+    _stats.swap = swap.elapsed();
 }
 
 void GridLoader::gridUpdated(Poco::TaskFinishedNotification* nf)
@@ -234,3 +275,9 @@ void GridLoader::gridUpdated(Poco::TaskFinishedNotification* nf)
 
     _gridManager->dequeue();
 }
+
+void GridLoader::gridBroadcasted(Poco::TaskFinishedNotification* nf)
+{
+    nf->release();
+    _broadcastManager->dequeue();
+}
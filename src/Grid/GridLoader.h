@@ -5,6 +5,7 @@
 #include "Poco/SingletonHolder.h"
 #include "Poco/SharedPtr.h"
 #include "Poco/TaskNotification.h"
+#include "Poco/Timestamp.h"
 
 //@ List and Hash Map
 #include "hash_map.h"
@@ -26,6 +27,19 @@ private:
     typedef std::set<Grid*> GridsSet;
 
 public:
+    /**
+     * Time each stage of the last update took, in microseconds, and the
+     * packets flushed on it
+     */
+    struct UpdateStats
+    {
+        Poco::Timestamp::TimeDiff simulate;
+        Poco::Timestamp::TimeDiff flush;
+        Poco::Timestamp::TimeDiff swap;
+        Poco::UInt32 grids;
+        Poco::UInt32 packets;
+    };
+
     GridLoader();
     ~GridLoader();
 
@@ -39,20 +53,28 @@ public:
     Grid* GetGrid(Poco::UInt16 x, Poco::UInt16 y);
     Grid* GetGridOrLoad(Poco::UInt16 x, Poco::UInt16 y);
 
-    Grid* addObject(SharedPtr<Object> object);
+    Grid* addObject(Object* object);
     bool removeObject(Object* object);
     
     void update(Poco::UInt64 diff);
     void gridUpdated(Poco::TaskFinishedNotification* nf);
+    void gridBroadcasted(Poco::TaskFinishedNotification* nf);
+
+    inline const UpdateStats& getUpdateStats()
+    {
+        return _stats;
+    }
     
 private:
-    Grid* addObjectTo(Poco::UInt16 x, Poco::UInt16 y, SharedPtr<Object> object);
+    Grid* addObjectTo(Poco::UInt16 x, Poco::UInt16 y, Object* object);
 
 private:    
     GridManager* _gridManager;
+    GridManager* _broadcastManager;
     GridsMap _grids;
     GridsSet _remove;
     bool _isGridLoaded[MAX_X][MAX_Y];
+    UpdateStats _stats;
 };
 
 #define sGridLoader GridLoader::instance()
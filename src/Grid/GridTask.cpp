@@ -1,6 +1,7 @@
 #include "GridTask.h"
 #include "Grid.h"
 #include "Object.h"
+#include "Trace.h"
 
 GridTask::GridTask(Grid* grid, Poco::UInt64 diff):
     Task(""),
@@ -11,6 +12,8 @@ GridTask::GridTask(Grid* grid, Poco::UInt64 diff):
 
 void GridTask::runTask()
 {
+    TRACE_SCOPE("GridTask::runTask");
+
     if (_grid->hasPlayers())
         _result = _grid->update(_diff);
 }
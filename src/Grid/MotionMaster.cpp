@@ -2,11 +2,20 @@
 
 #include "Character.h"
 #include "debugging.h"
+#include "Grid.h"
 #include "Log.h"
 #include "Object.h"
 #include "Position.h"
 
 #include <cmath>
+#include <limits>
+
+MotionMaster::MotionMaster():
+    _table(NULL), _handle(MovementTable::INVALID_HANDLE),
+    _crossed(false)
+{
+    clear();
+}
 
 void MotionMaster::StartSimpleMovement(Object* object, Vector2D to, float speed)
 {
@@ -16,16 +25,22 @@ void MotionMaster::StartSimpleMovement(Object* object, Vector2D to, float speed)
     object->motionMaster.set(speed, MOVEMENT_TO_POINT);
     object->setFlag(FLAGS_TYPE_MOVEMENT, FLAG_MOVING);
 
-    //sLog.out(Message::PRIO_TRACE, "\t\tObject starting movement, t=%f", object->motionMaster._time);
+    if (Grid* grid = object->GetGrid())
+        object->motionMaster.bind(grid->getMovementTable(), object);
+
+    //sLog.out(Message::PRIO_TRACE, "\t\tObject starting movement, t=%f", object->motionMaster._movement.time);
 }
 
 void MotionMaster::StartAngleMovement(Object* object, float angle, float speed)
 {
     object->motionMaster.clear();
     object->motionMaster.addPoint(object->GetPosition());
-    object->motionMaster.set(speed, MOVEMENT_BY_ANGLE);
     object->motionMaster.angle(angle);
+    object->motionMaster.set(speed, MOVEMENT_BY_ANGLE);
     object->setFlag(FLAGS_TYPE_MOVEMENT, FLAG_MOVING);
+
+    if (Grid* grid = object->GetGrid())
+        object->motionMaster.bind(grid->getMovementTable(), object);
     
     //sLog.out(Message::PRIO_TRACE, "\t\tObject starting movement, a=%f", angle);
 }
@@ -37,19 +52,19 @@ void MotionMaster::addPoint(Vector2D point)
 
 Vector2D& MotionMaster::current()
 {
-    ASSERT(!_movement.points.empty())
-    return _movement.points[0];
+    ASSERT(_movement.cursor < _movement.points.size())
+    return _movement.points[_movement.cursor];
 }
 
 bool MotionMaster::hasNext()
 {
-    return _movement.points.size() > 1;
+    return _movement.cursor + 1 < _movement.points.size();
 }
 
 Vector2D& MotionMaster::next()
 {
-    ASSERT(_movement.points.size() > 1)
-    return _movement.points[1];
+    ASSERT(hasNext())
+    return _movement.points[_movement.cursor + 1];
 }
 
 void MotionMaster::angle(float angle)
@@ -57,7 +72,14 @@ void MotionMaster::angle(float angle)
     _movement.angle = angle;
 }
 
-void MotionMaster::set(float speed, Poco::UInt8 movementType, float elapsed)
+/**
+ * Sets up the current movement segment. Velocity is computed once here,
+ * the movement table only integrates it
+ *
+ * @param speed Units per second
+ * @param movementType MOVEMENT_TO_POINT or MOVEMENT_BY_ANGLE
+ */
+void MotionMaster::set(float speed, Poco::UInt8 movementType)
 {
     _movement.movementType = movementType;
     _movement.speed = speed;
@@ -67,52 +89,61 @@ void MotionMaster::set(float speed, Poco::UInt8 movementType, float elapsed)
         Vector2D c = current();
         Vector2D n = next();
 
-        _movement.dx = n.x - c.x;
-        _movement.dz = n.z - c.z;
+        float dx = n.x - c.x;
+        float dz = n.z - c.z;
+        float distance = std::sqrt(dx * dx + dz * dz);
 
-        float distance = std::sqrt(std::pow(_movement.dx, 2) + std::pow(_movement.dz, 2));
-        _time = distance/speed;
-        _elapsed = elapsed;
+        _movement.time = distance / speed;
+        _movement.vx = distance > 0 ? dx / _movement.time : 0;
+        _movement.vz = distance > 0 ? dz / _movement.time : 0;
     }
     else if (movementType == MOVEMENT_BY_ANGLE)
-        _elapsed = 0;
+    {
+        _movement.time = std::numeric_limits<float>::max();
+        _movement.vx = speed * std::cos(_movement.angle);
+        _movement.vz = speed * std::sin(_movement.angle);
+    }
+
+    if (_table)
+        _table->reset(_handle, current().x, current().z, _movement.vx, _movement.vz, _movement.time);
 }
 
-bool MotionMaster::evaluate(Poco::UInt64 diff, Vector2D& pos)
+/**
+ * Reads the position integrated by the movement table
+ *
+ * @param pos Where the new position is stored
+ * @param crossed Whether a sector has been crossed this tick
+ * @return true if the movement has finished
+ */
+bool MotionMaster::evaluate(Vector2D& pos, bool& crossed)
 {
-    _elapsed += diff/1000.0f;
-    Vector2D c = current();
-
-    if (_movement.movementType == MOVEMENT_TO_POINT)
-    {
-        float r = _elapsed;
-        if (_elapsed > _time)
-            r = _time;
+    ASSERT(_table)
 
-        pos.x = c.x + _movement.dx * _elapsed / _time;
-        pos.z = c.z + _movement.dz * _elapsed / _time;
+    pos.x = _table->getX(_handle);
+    pos.z = _table->getZ(_handle);
 
-        if (evaluatePosition(pos))
-            return true;
+    crossed = _crossed;
+    _crossed = false;
 
-        if (r >= _time)
-        {
-            _movement.points.erase(_movement.points.begin());
-            if (hasNext())
-                set(_movement.speed, _movement.movementType, _max(0, _elapsed - r));
-        }
+    if (!_table->hasFinished(_handle))
+        return false;
 
-        return r >= _time && !hasNext();
-    }
-    else if (_movement.movementType == MOVEMENT_BY_ANGLE)
+    // Map bounds reached, or end of the path
+    if (_table->isBlocked(_handle) || _movement.movementType != MOVEMENT_TO_POINT)
     {
-        pos.x = c.x + (_movement.speed * _elapsed * std::cos(_movement.angle));
-        pos.z = c.z + (_movement.speed * _elapsed * std::sin(_movement.angle));
+        unbind();
+        return true;
+    }
 
-        return evaluatePosition(pos);
+    ++_movement.cursor;
+    if (!hasNext())
+    {
+        unbind();
+        return true;
     }
 
-    return true;
+    set(_movement.speed, _movement.movementType);
+    return false;
 }
 
 Poco::UInt8 MotionMaster::getMovementType()
@@ -123,37 +154,50 @@ Poco::UInt8 MotionMaster::getMovementType()
 
 void MotionMaster::clear()
 {
+    unbind();
+
     _movement.points.clear();
-    _movement.dx = _movement.dz = 0;
+    _movement.cursor = 0;
+    _movement.vx = _movement.vz = 0;
     _movement.angle = 0;
     _movement.speed = 0;
+    _movement.time = 0;
 }
 
-bool MotionMaster::evaluatePosition(Vector2D& pos)
+/**
+ * Adds the movement to a Grid movement table, starting from the owner
+ * current position. Must be called with the Grid locked
+ *
+ * @param table Movement table of the Grid the owner is in
+ * @param owner Object owning this MotionMaster
+ */
+void MotionMaster::bind(MovementTable* table, Object* owner)
 {
-    if (pos.x < MAP_MIN_X)
-    {
-        pos.x = MAP_MIN_X;
-        return true;
-    }
+    unbind();
 
-    if (pos.x > MAP_MAX_X)
-    {
-        pos.x = MAP_MAX_X;
-        return true;
-    }
+    if (!owner->hasFlag(FLAGS_TYPE_MOVEMENT, FLAG_MOVING) || _movement.points.empty())
+        return;
 
-    if (pos.z < MAP_MIN_Z)
-    {
-        pos.z = MAP_MIN_Z;
-        return true;
-    }
+    Vector2D position = owner->GetPosition();
+    float time = _movement.time;
+    if (_movement.movementType == MOVEMENT_TO_POINT && hasNext())
+        time = position.Distance(next()) / _movement.speed;
 
-    if (pos.z > MAP_MAX_Z)
-    {
-        pos.z = MAP_MAX_Z;
-        return true;
-    }
+    _table = table;
+    _handle = _table->add(owner, position.x, position.z, _movement.vx, _movement.vz, time);
+    _crossed = false;
+}
 
-    return false;
+/**
+ * Removes the movement from the Grid movement table, if any. Must be
+ * called with the Grid locked
+ */
+void MotionMaster::unbind()
+{
+    if (!_table)
+        return;
+
+    _table->remove(_handle);
+    _table = NULL;
+    _handle = MovementTable::INVALID_HANDLE;
 }
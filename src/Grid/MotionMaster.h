@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "defines.h"
+#include "MovementTable.h"
 
 #define _max(a, b) ((a > b) ? (a) : (b))
 
@@ -34,6 +35,8 @@ struct Vector2D;
 class MotionMaster
 {
 public:
+    MotionMaster();
+
     static void StartSimpleMovement(Object* object, Vector2D to, float speed);
     static void StartAngleMovement(Object* object, float angle, float speed);
 
@@ -43,31 +46,51 @@ public:
     Vector2D& next();
 
     inline void angle(float angle);
-    void set(float speed, Poco::UInt8 movementType, float elapsed = 0);
-    bool evaluate(Poco::UInt64 diff, Vector2D& pos);
+    void set(float speed, Poco::UInt8 movementType);
+    bool evaluate(Vector2D& pos, bool& crossed);
 
     Poco::UInt8 getMovementType();
 
     void clear();
 
-private:
-    bool evaluatePosition(Vector2D& pos);
+    void bind(MovementTable* table, Object* owner);
+    void unbind();
 
+    inline bool isBound()
+    {
+        return _table != NULL;
+    }
+
+    inline void setHandle(MovementTable::Handle handle)
+    {
+        _handle = handle;
+    }
+
+    inline void setCrossed()
+    {
+        _crossed = true;
+    }
+
+private:
     struct MovementVector
     {
         Poco::UInt8 movementType;
         std::vector<Vector2D> points;
+        Poco::UInt32 cursor;
         float angle;
         float speed;
-        float dx;
-        float dz;
+        float vx;
+        float vz;
+        float time;
     };
 
 private:
     MovementVector _movement;
 
-    float _time;
-    float _elapsed;
+    // Row on the Grid movement table, where the position is integrated
+    MovementTable* _table;
+    MovementTable::Handle _handle;
+    bool _crossed;
 };
 
 #endif
@@ -0,0 +1,247 @@
+#include "MovementTable.h"
+#include "Grid.h"
+
+#include "defines.h"
+#include "Object.h"
+
+#include <algorithm>
+#include <limits>
+
+// Rows are checked slightly before their predicted crossing, as the
+// countdown and the position do not accumulate the same float errors
+#define CROSSING_TOLERANCE 0.001f
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define MOVEMENT_TABLE_SSE2
+    #include <emmintrin.h>
+#endif
+
+MovementTable::MovementTable():
+    _sectorSize(Grid::LOSRange / 2)
+{
+}
+
+/**
+ * Adds a moving object to the table
+ *
+ * @param owner Object which is moving
+ * @param x Starting x position
+ * @param z Starting z position
+ * @param vx Velocity on the x axis, in units per second
+ * @param vz Velocity on the z axis, in units per second
+ * @param time Seconds until the movement segment ends
+ * @return Handle to the row
+ */
+MovementTable::Handle MovementTable::add(Object* owner, float x, float z, float vx, float vz, float time)
+{
+    _x.push_back(x);
+    _z.push_back(z);
+    _vx.push_back(vx);
+    _vz.push_back(vz);
+    _remaining.push_back(time);
+    _crossing.push_back(0);
+    _keyX.push_back(sectorKey(x, MAP_MIN_X));
+    _keyZ.push_back(sectorKey(z, MAP_MIN_Z));
+    _owners.push_back(owner);
+
+    Handle handle = (Handle)(_owners.size() - 1);
+    scheduleCrossing(handle);
+    return handle;
+}
+
+/**
+ * Starts a new movement segment on an existing row
+ *
+ */
+void MovementTable::reset(Handle handle, float x, float z, float vx, float vz, float time)
+{
+    _x[handle] = x;
+    _z[handle] = z;
+    _vx[handle] = vx;
+    _vz[handle] = vz;
+    _remaining[handle] = time;
+    _keyX[handle] = sectorKey(x, MAP_MIN_X);
+    _keyZ[handle] = sectorKey(z, MAP_MIN_Z);
+    scheduleCrossing(handle);
+}
+
+/**
+ * Removes a row, the last row is moved to its place and its owner
+ * is notified of the new handle
+ *
+ * @param handle Row to be removed
+ */
+void MovementTable::remove(Handle handle)
+{
+    Handle last = (Handle)(_owners.size() - 1);
+    if (handle != last)
+    {
+        _x[handle] = _x[last];
+        _z[handle] = _z[last];
+        _vx[handle] = _vx[last];
+        _vz[handle] = _vz[last];
+        _remaining[handle] = _remaining[last];
+        _crossing[handle] = _crossing[last];
+        _keyX[handle] = _keyX[last];
+        _keyZ[handle] = _keyZ[last];
+        _owners[handle] = _owners[last];
+        _owners[handle]->motionMaster.setHandle(handle);
+    }
+
+    _x.pop_back();
+    _z.pop_back();
+    _vx.pop_back();
+    _vz.pop_back();
+    _remaining.pop_back();
+    _crossing.pop_back();
+    _keyX.pop_back();
+    _keyZ.pop_back();
+    _owners.pop_back();
+}
+
+/**
+ * Integrates all the rows, stopping them at the end of their segment
+ * or at the map bounds. The crossings list is rebuilt
+ *
+ * @param elapsed Seconds since the last integration
+ */
+void MovementTable::integrate(float elapsed)
+{
+    _crossings.clear();
+
+    Handle count = (Handle)_owners.size();
+    Handle i = 0;
+
+#ifdef MOVEMENT_TABLE_SSE2
+    const __m128 dt = _mm_set1_ps(elapsed);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 tolerance = _mm_set1_ps(CROSSING_TOLERANCE);
+    const __m128 blocked = _mm_set1_ps(-1.0f);
+    const __m128 minX = _mm_set1_ps(MAP_MIN_X);
+    const __m128 maxX = _mm_set1_ps(MAP_MAX_X);
+    const __m128 minZ = _mm_set1_ps(MAP_MIN_Z);
+    const __m128 maxZ = _mm_set1_ps(MAP_MAX_Z);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&_x[i]);
+        __m128 z = _mm_loadu_ps(&_z[i]);
+        __m128 remaining = _mm_loadu_ps(&_remaining[i]);
+
+        // Never go further than the segment end
+        __m128 step = _mm_min_ps(dt, _mm_max_ps(remaining, zero));
+        x = _mm_add_ps(x, _mm_mul_ps(_mm_loadu_ps(&_vx[i]), step));
+        z = _mm_add_ps(z, _mm_mul_ps(_mm_loadu_ps(&_vz[i]), step));
+        remaining = _mm_sub_ps(remaining, step);
+
+        // Stop at the map bounds
+        __m128 clampedX = _mm_min_ps(_mm_max_ps(x, minX), maxX);
+        __m128 clampedZ = _mm_min_ps(_mm_max_ps(z, minZ), maxZ);
+        __m128 out = _mm_or_ps(_mm_cmpneq_ps(clampedX, x), _mm_cmpneq_ps(clampedZ, z));
+        remaining = _mm_or_ps(_mm_and_ps(out, blocked), _mm_andnot_ps(out, remaining));
+
+        _mm_storeu_ps(&_x[i], clampedX);
+        _mm_storeu_ps(&_z[i], clampedZ);
+        _mm_storeu_ps(&_remaining[i], remaining);
+
+        // Count down to the next predicted crossing
+        __m128 crossing = _mm_sub_ps(_mm_loadu_ps(&_crossing[i]), step);
+        _mm_storeu_ps(&_crossing[i], crossing);
+
+        int due = _mm_movemask_ps(_mm_cmple_ps(crossing, tolerance));
+        for (Handle j = 0; due; ++j, due >>= 1)
+            if (due & 1)
+                checkCrossing(i + j);
+    }
+#endif
+
+    for (; i < count; ++i)
+        integrateRow(i, elapsed);
+}
+
+void MovementTable::integrateRow(Handle i, float elapsed)
+{
+    float step = std::min(elapsed, std::max(_remaining[i], 0.0f));
+    float x = _x[i] + _vx[i] * step;
+    float z = _z[i] + _vz[i] * step;
+    _remaining[i] -= step;
+
+    _x[i] = std::min(std::max(x, (float)MAP_MIN_X), (float)MAP_MAX_X);
+    _z[i] = std::min(std::max(z, (float)MAP_MIN_Z), (float)MAP_MAX_Z);
+    if (_x[i] != x || _z[i] != z)
+        _remaining[i] = -1.0f;
+
+    _crossing[i] -= step;
+    if (_crossing[i] <= CROSSING_TOLERANCE)
+        checkCrossing(i);
+}
+
+/**
+ * Called when a row reaches its predicted crossing time. If it is still
+ * short of the boundary it is simply scheduled again, and checked on the
+ * next tick
+ *
+ * @param i Row to check
+ */
+void MovementTable::checkCrossing(Handle i)
+{
+    Poco::Int32 keyX = sectorKey(_x[i], MAP_MIN_X);
+    Poco::Int32 keyZ = sectorKey(_z[i], MAP_MIN_Z);
+    if (keyX != _keyX[i] || keyZ != _keyZ[i])
+        _crossings.push_back(i);
+
+    _keyX[i] = keyX;
+    _keyZ[i] = keyZ;
+    scheduleCrossing(i);
+}
+
+/**
+ * Computes when the row will leave its current sector (or grid)
+ *
+ * @param i Row to schedule
+ */
+void MovementTable::scheduleCrossing(Handle i)
+{
+    _crossing[i] = std::min(timeToBoundary(_x[i], MAP_MIN_X, _vx[i]), timeToBoundary(_z[i], MAP_MIN_Z, _vz[i]));
+}
+
+/**
+ * Time needed to leave the current sector on one axis. Sectors are
+ * laid out from each cell origin, the last one being cut by the cell end
+ *
+ * @param position Position on the axis
+ * @param min Map minimum on the axis
+ * @param velocity Velocity on the axis
+ * @return Seconds until a boundary is crossed
+ */
+float MovementTable::timeToBoundary(float position, float min, float velocity)
+{
+    if (velocity == 0)
+        return std::numeric_limits<float>::max();
+
+    float distance = position - min;
+    Poco::Int32 cell = (Poco::Int32)(distance / UNITS_PER_CELL);
+    float offset = distance - (float)(cell * UNITS_PER_CELL);
+    float lower = (float)(((Poco::Int32)offset / (Poco::Int32)_sectorSize) * (Poco::Int32)_sectorSize);
+    float upper = std::min(lower + _sectorSize, (float)UNITS_PER_CELL);
+
+    if (velocity > 0)
+        return (upper - offset) / velocity;
+    return (offset - lower) / -velocity;
+}
+
+/**
+ * Cell and sector of a position on one axis, computed exactly as
+ * Vector2D::Process does, so that a key change means a sector change
+ *
+ * @param position Position on the axis
+ * @param min Map minimum on the axis
+ * @return (cell << 16) | sector
+ */
+Poco::Int32 MovementTable::sectorKey(float position, float min)
+{
+    float distance = position - min;
+    Poco::Int32 cell = (Poco::Int32)(distance / UNITS_PER_CELL);
+    Poco::Int32 offset = (Poco::Int32)(distance - (float)(cell * UNITS_PER_CELL));
+    return (cell << 16) | (Poco::Int32)(offset / (Poco::Int32)_sectorSize);
+}
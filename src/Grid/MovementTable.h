@@ -0,0 +1,92 @@
+#ifndef GAMESERVER_MOVEMENT_TABLE_H
+#define GAMESERVER_MOVEMENT_TABLE_H
+
+#include "Poco/Poco.h"
+
+#include <vector>
+
+class Object;
+
+/**
+ * Structure of arrays holding the movement state of all the moving objects
+ * in a Grid. All rows are integrated in one pass per tick, and the rows
+ * which have crossed a sector are reported in a compact list for the
+ * sector layer. As all movements are straight lines, the time of the next
+ * sector or grid crossing is computed when a segment starts, and nothing
+ * but a countdown is evaluated between crossings
+ */
+class MovementTable
+{
+public:
+    typedef Poco::UInt32 Handle;
+    typedef std::vector<Handle> TypeHandleList;
+
+    static const Handle INVALID_HANDLE = 0xFFFFFFFF;
+
+    MovementTable();
+
+    Handle add(Object* owner, float x, float z, float vx, float vz, float time);
+    void reset(Handle handle, float x, float z, float vx, float vz, float time);
+    void remove(Handle handle);
+
+    void integrate(float elapsed);
+
+    inline float getX(Handle handle)
+    {
+        return _x[handle];
+    }
+
+    inline float getZ(Handle handle)
+    {
+        return _z[handle];
+    }
+
+    // Either the end of the segment or the map bounds have been reached
+    inline bool hasFinished(Handle handle)
+    {
+        return _remaining[handle] <= 0;
+    }
+
+    inline bool isBlocked(Handle handle)
+    {
+        return _remaining[handle] < 0;
+    }
+
+    inline TypeHandleList& getCrossings()
+    {
+        return _crossings;
+    }
+
+    inline Object* getOwner(Handle handle)
+    {
+        return _owners[handle];
+    }
+
+    inline bool empty()
+    {
+        return _owners.empty();
+    }
+
+private:
+    void integrateRow(Handle i, float elapsed);
+    void checkCrossing(Handle i);
+    void scheduleCrossing(Handle i);
+    Poco::Int32 sectorKey(float position, float min);
+    float timeToBoundary(float position, float min, float velocity);
+
+private:
+    std::vector<float> _x;
+    std::vector<float> _z;
+    std::vector<float> _vx;
+    std::vector<float> _vz;
+    std::vector<float> _remaining;
+    std::vector<float> _crossing;
+    std::vector<Poco::Int32> _keyX;
+    std::vector<Poco::Int32> _keyZ;
+    std::vector<Object*> _owners;
+
+    TypeHandleList _crossings;
+    float _sectorSize;
+};
+
+#endif
@@ -29,7 +29,7 @@ void Vector2D::Process()
     gridY = Tools::GetYCellFromPos(z);
 
     _inCellX = Tools::GetPositionInXCell(gridX, x);
-    _inCellY = Tools::GetPositionInYCell(gridX, z);
+    _inCellY = Tools::GetPositionInYCell(gridY, z);
 
     sector = Tools::GetSector(_inCellX, _inCellY, Grid::LOSRange / 2);
 }
@@ -9,22 +9,18 @@
 #include "Server.h"
 #include "Tools.h"
 
-Sector::SectorEvent::SectorEvent(SharedPtr<Object> object, SharedPtr<Packet> packet, Poco::UInt8 eventType)
+Sector::SectorEvent::SectorEvent(ObjectHandle who, SharedPtr<Packet> packet, Poco::UInt8 eventType)
 {
-    Who.assign(object);
+    Who = who;
     EventPacket.assign(packet);
     EventType = eventType;
 }
 
-Sector::SectorEvent::~SectorEvent()
-{
-    Who = NULL;
-}
-
 Sector::Sector(Poco::UInt16 hash, Grid* grid):
     _hash(hash),
     _grid(grid),
-    _playersInSector(0)
+    _playersInSector(0),
+    _writeEvents(0)
 {
     _x = hash >> 8;
     _y = hash & 0xFF;
@@ -33,7 +29,8 @@ Sector::Sector(Poco::UInt16 hash, Grid* grid):
 
 Sector::~Sector()
 {
-    clearJoinEvents();
+    clearEvents(_sectorEvents[0]);
+    clearEvents(_sectorEvents[1]);
 }
 
 Poco::UInt16 Sector::hash(Poco::UInt8 x, Poco::UInt8 y)
@@ -48,7 +45,7 @@ bool Sector::update(Poco::UInt64 diff)
     // Update all players
     for (TypeObjectsMap::iterator itr = _objects.begin(); itr != _objects.end(); )
     {
-        SharedPtr<Object> object = itr->second;
+        Object* object = itr->second;
         ++itr;
 
         // Get last update time (in case the object switches grid)
@@ -82,11 +79,11 @@ bool Sector::update(Poco::UInt64 diff)
             sGridLoader.addObject(object); // Add to the new Grid
             remove_i(object); // Delete from the Sector (and Grid)
         }
-        else if (object->hasFlag(FLAGS_TYPE_MOVEMENT, FLAG_MOVING))
+        else
         {
+            // The sector only changes on the crossings predicted by the grid
+            // movement table, including the tick where the movement ends
             Poco::UInt16 actSector = object->GetPosition().sector;
-
-            // Have we changed sector?
             if (prevSector != actSector)
             {
                 Poco::UInt8 aX = (actSector - prevSector) >> 8;
@@ -97,15 +94,11 @@ bool Sector::update(Poco::UInt64 diff)
             }
         }
     }
-    
-    // Theorically, no join events can occure during the sector update, the mutex avoids it
-    // Delete them all
-    clearJoinEvents();
 
     return hasObjects();
 }
 
-SharedPtr<Object> Sector::selectTargetInAggroRange()
+Object* Sector::selectTargetInAggroRange()
 {
     // If there are no players, simply return
     if (!_playersInSector)
@@ -114,7 +107,7 @@ SharedPtr<Object> Sector::selectTargetInAggroRange()
     // All the sector is in aggro range ;)
     for (TypeObjectsMap::iterator itr = _objects.begin(), end = _objects.end(); itr != end; ++itr)
     {
-        SharedPtr<Object> object = itr->second;
+        Object* object = itr->second;
 
         if (object->GetHighGUID() & HIGH_GUID_PLAYER)
             return object;
@@ -125,7 +118,7 @@ SharedPtr<Object> Sector::selectTargetInAggroRange()
     return NULL;
 }
 
-bool Sector::add(SharedPtr<Object> object, Poco::UInt8* aX /*= NULL*/, Poco::UInt8* aY /*= NULL*/)
+bool Sector::add(Object* object, Poco::UInt8* aX /*= NULL*/, Poco::UInt8* aY /*= NULL*/)
 {
     Poco::Mutex::ScopedLock lock(_mutex);
 
@@ -178,13 +171,13 @@ bool Sector::add(SharedPtr<Object> object, Poco::UInt8* aX /*= NULL*/, Poco::UIn
     return false;
 }
 
-void Sector::remove(SharedPtr<Object> object)
+void Sector::remove(Object* object)
 {
     Poco::Mutex::ScopedLock lock(_mutex);
     remove_i(object);
 }
 
-void Sector::remove_i(SharedPtr<Object> object, Poco::UInt8* aX /*= NULL*/, Poco::UInt8* aY /*= NULL*/)
+void Sector::remove_i(Object* object, Poco::UInt8* aX /*= NULL*/, Poco::UInt8* aY /*= NULL*/)
 {
     if (object->GetHighGUID() & HIGH_GUID_PLAYER)
     {
@@ -229,22 +222,22 @@ void Sector::remove_i(SharedPtr<Object> object, Poco::UInt8* aX /*= NULL*/, Poco
     }
 }
 
-void Sector::join(SharedPtr<Object> who, SharedPtr<Packet> packet)
+void Sector::join(Object* who, SharedPtr<Packet> packet)
 {
-    _sectorEvents.push_back(new SectorEvent(who, packet, EVENT_BROADCAST_JOIN));
+    _sectorEvents[_writeEvents].push_back(new SectorEvent(who->GetHandle(), packet, EVENT_BROADCAST_JOIN));
 }
 
-void Sector::leave(SharedPtr<Object> who, SharedPtr<Packet> packet)
+void Sector::leave(Object* who, SharedPtr<Packet> packet)
 {
-    _sectorEvents.push_back(new SectorEvent(who, packet, EVENT_BROADCAST_LEAVE));
+    _sectorEvents[_writeEvents].push_back(new SectorEvent(who->GetHandle(), packet, EVENT_BROADCAST_LEAVE));
 }
 
-void Sector::clearJoinEvents()
+void Sector::clearEvents(TypeSectorEvents& events)
 {
-    while (!_sectorEvents.empty())
+    while (!events.empty())
     {
-        delete _sectorEvents.back();
-        _sectorEvents.pop_back();
+        delete events.back();
+        events.pop_back();
     }
 }
 
@@ -253,14 +246,25 @@ bool Sector::hasObjects()
     return !_objects.empty();
 }
 
+// Events are double buffered: joins and leaves generated during a tick are
+// written to one list, while players read the complete list of the previous tick
 bool Sector::hasEvents()
 {
-    return !_sectorEvents.empty();
+    return !_sectorEvents[_writeEvents ^ 1].empty();
 }
 
 Sector::TypeSectorEvents* Sector::getEvents()
 {
-    return &_sectorEvents;
+    return &_sectorEvents[_writeEvents ^ 1];
+}
+
+// Must only be called on a tick boundary, when no grid is updating
+void Sector::swapEvents()
+{
+    // Previous tick events have already been resolved, the packets they
+    // reference are kept alive by whoever still holds them
+    clearEvents(_sectorEvents[_writeEvents ^ 1]);
+    _writeEvents ^= 1;
 }
 
 Poco::UInt16 Sector::hashCode()
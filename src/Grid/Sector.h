@@ -11,6 +11,7 @@
 #include "hash_map.h"
 #include "stack_allocator.h"
 
+#include "ObjectPool.h"
 #include "Position.h"
 
 using Poco::SharedPtr;
@@ -20,7 +21,7 @@ class Object;
 class Grid;
 class Packet;
 
-typedef rde::hash_map<Poco::UInt64 /*guid*/, Poco::SharedPtr<Object>> TypeObjectsMap;
+typedef rde::hash_map<Poco::UInt64 /*guid*/, Object*> TypeObjectsMap;
 typedef std::vector<Poco::UInt16> TypeHashList;
 
 enum SECTOR_EVENTS
@@ -35,10 +36,10 @@ class Sector
 public:    
     struct SectorEvent
     {
-        SectorEvent(SharedPtr<Object> object, SharedPtr<Packet> packet, Poco::UInt8 eventType);
-        ~SectorEvent();
+        SectorEvent(ObjectHandle who, SharedPtr<Packet> packet, Poco::UInt8 eventType);
 
-        SharedPtr<Object> Who;
+        // Handle, events outlive the tick and the object might be gone
+        ObjectHandle Who;
         SharedPtr<Packet> EventPacket;
         Poco::UInt8 EventType;
     };
@@ -50,24 +51,25 @@ public:
 
     static Poco::UInt16 hash(Poco::UInt8 x, Poco::UInt8 y);
 
-    bool add(SharedPtr<Object> object, Poco::UInt8* aX = NULL, Poco::UInt8* aY = NULL);
-    void remove(SharedPtr<Object> object);
-    void remove_i(SharedPtr<Object> object, Poco::UInt8* aX = NULL, Poco::UInt8* aY = NULL);
+    bool add(Object* object, Poco::UInt8* aX = NULL, Poco::UInt8* aY = NULL);
+    void remove(Object* object);
+    void remove_i(Object* object, Poco::UInt8* aX = NULL, Poco::UInt8* aY = NULL);
 
     bool update(Poco::UInt64 diff);
-    SharedPtr<Object> selectTargetInAggroRange();
+    Object* selectTargetInAggroRange();
 
     bool hasObjects();
     bool hasEvents();
     TypeSectorEvents* getEvents();
+    void swapEvents();
 
     Poco::UInt16 hashCode();
 
 private:
-    void join(SharedPtr<Object> who, SharedPtr<Packet> packet);
-    void leave(SharedPtr<Object> who, SharedPtr<Packet> packet);
+    void join(Object* who, SharedPtr<Packet> packet);
+    void leave(Object* who, SharedPtr<Packet> packet);
 
-    void clearJoinEvents();
+    void clearEvents(TypeSectorEvents& events);
 
     TypeHashList getNearSectors();
 
@@ -78,7 +80,8 @@ private:
     Poco::UInt8 _y;
     TypeHashList _sectors;
     TypeObjectsMap _objects;
-    TypeSectorEvents _sectorEvents;
+    TypeSectorEvents _sectorEvents[2];
+    Poco::UInt8 _writeEvents;
     Poco::UInt32 _playersInSector;
     Poco::Mutex _mutex;
 };
@@ -0,0 +1,627 @@
+#include "Bot.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "Poco/Exception.h"
+
+#include "Opcodes.h"
+#include "Packet.h"
+
+//@ Reasons sent along OPCODE_SC_TIME_OUT, the server disconnect flags
+#define BOT_DISCONNECTED_TIME_OUT       4
+#define BOT_DISCONNECTED_INCORRECT_DATA 16
+
+//@ Length, opcode, security byte and HMAC digest
+#define BOT_HEADER_SIZE                 25
+#define BOT_READ_SIZE                   16384
+//@ Microseconds a connection may take before it is given up
+#define BOT_CONNECT_TIME_OUT            10000000
+
+Bot::Bot(Poco::UInt32 account, const Scenario& scenario, const Behaviour& behaviour, LoadStats& stats, SocketReactor& reactor, const SocketAddress& address):
+    _account(account), _scenario(scenario), _behaviour(behaviour),
+    _stats(stats), _reactor(reactor), _address(address),
+    _random(scenario.seed ^ account),
+    _state(STATE_IDLE), _writing(false),
+    _securityByte(0),
+    _verifier(NULL), _encryptor(NULL), _decryptor(NULL),
+    _disconnectReason(LoadStats::CLOSED_BY_SERVER),
+    _queued(false),
+    _reconnect(false)
+{
+}
+
+Bot::~Bot()
+{
+    close(LoadStats::LEFT);
+}
+
+/**
+ * Starts connecting, the connection is finished from the reactor
+ */
+void Bot::connect()
+{
+    _state = STATE_CONNECTING;
+    _stepStart.update();
+    _disconnectReason = LoadStats::CLOSED_BY_SERVER;
+    _queued = false;
+    _input.clear();
+    _output.clear();
+
+    try
+    {
+        _socket = StreamSocket();
+        _socket.connectNB(_address);
+    }
+    catch (Poco::Exception&)
+    {
+        close(LoadStats::CONNECT_FAILURES);
+        return;
+    }
+
+    _reactor.addEventHandler(_socket, Poco::NObserver<Bot, ReadableNotification>(*this, &Bot::onReadable));
+    _reactor.addEventHandler(_socket, Poco::NObserver<Bot, ErrorNotification>(*this, &Bot::onError));
+    setWriting(true);
+}
+
+/**
+ * Sends whatever is due: pings, keep alives, and the disconnection once
+ * it has stayed long enough. Reconnects if it is time to
+ *
+ * @param now Current time
+ */
+void Bot::update(const Poco::Timestamp& now)
+{
+    if (_state == STATE_IDLE)
+    {
+        if (_reconnect && now >= _reconnectAt)
+        {
+            _reconnect = false;
+            connect();
+        }
+        return;
+    }
+
+    if (_state == STATE_CONNECTING)
+    {
+        if (now - _stepStart > BOT_CONNECT_TIME_OUT)
+            close(LoadStats::CONNECT_FAILURES);
+        return;
+    }
+
+    if (_state < STATE_READY)
+        return;
+
+    if (_behaviour.stay && now - _settled >= (Poco::Timestamp::TimeDiff)_behaviour.stay * 1000)
+    {
+        close(LoadStats::LEFT);
+        return;
+    }
+
+    if (_behaviour.ping && now >= _nextPing)
+    {
+        _nextPing = now + (Poco::Timestamp::TimeDiff)_behaviour.ping * 1000;
+        sendPing();
+    }
+
+    if (_state != STATE_IDLE && _behaviour.keepAlive && now - _lastSend >= (Poco::Timestamp::TimeDiff)_behaviour.keepAlive * 1000)
+        send(new Packet(OPCODE_CS_KEEP_ALIVE), true);
+}
+
+void Bot::onReadable(const AutoPtr<ReadableNotification>& nf)
+{
+    nf->release();
+
+    if (_state == STATE_CONNECTING && !finishConnect())
+        return;
+
+    char buffer[BOT_READ_SIZE];
+    int nBytes = 0;
+    try
+    {
+        nBytes = _socket.receiveBytes(buffer, sizeof(buffer));
+    }
+    catch (Poco::TimeoutException&)
+    {
+        return;
+    }
+    catch (Poco::Exception&)
+    {
+        close(LoadStats::NETWORK_ERRORS);
+        return;
+    }
+
+    // Would have blocked
+    if (nBytes < 0)
+        return;
+
+    // Closed by the server, with the reason it gave if any
+    if (nBytes == 0)
+    {
+        close(_disconnectReason);
+        return;
+    }
+
+    _stats.add(LoadStats::BYTES_IN, nBytes);
+    _input.insert(_input.end(), buffer, buffer + nBytes);
+    readPackets();
+}
+
+void Bot::onWritable(const AutoPtr<WritableNotification>& nf)
+{
+    nf->release();
+
+    if (_state == STATE_CONNECTING && !finishConnect())
+        return;
+
+    flush();
+}
+
+void Bot::onError(const AutoPtr<ErrorNotification>& nf)
+{
+    nf->release();
+    close(_state == STATE_CONNECTING ? LoadStats::CONNECT_FAILURES : LoadStats::NETWORK_ERRORS);
+}
+
+/**
+ * Checks whether the connection has been established, once the socket is
+ * ready
+ *
+ * @return false if it has failed, and the bot has been closed
+ */
+bool Bot::finishConnect()
+{
+    int error = 0;
+    try
+    {
+        error = _socket.impl()->socketError();
+    }
+    catch (Poco::Exception&)
+    {
+        error = -1;
+    }
+
+    if (error)
+    {
+        close(LoadStats::CONNECT_FAILURES);
+        return false;
+    }
+
+    _stats.add(LoadStats::CONNECTS);
+    _stats.increase(LoadStats::OPEN);
+    _stats.sample(LoadStats::LATENCY_CONNECT, _stepStart.elapsed());
+
+    // Waiting for the EHLO
+    _state = STATE_HANDSHAKE;
+    _stepStart.update();
+    _lastSend.update();
+    return true;
+}
+
+/**
+ * Closes the connection, and schedules the next one if the bot reconnects
+ *
+ * @param reason Counted as the reason the connection has ended
+ */
+void Bot::close(LoadStats::Counter reason)
+{
+    if (_state == STATE_IDLE)
+        return;
+
+    _reactor.removeEventHandler(_socket, Poco::NObserver<Bot, ReadableNotification>(*this, &Bot::onReadable));
+    _reactor.removeEventHandler(_socket, Poco::NObserver<Bot, ErrorNotification>(*this, &Bot::onError));
+    setWriting(false);
+    _socket.close();
+
+    _stats.add(reason);
+    if (_state != STATE_CONNECTING)
+        _stats.decrease(LoadStats::OPEN);
+    if (_state == STATE_IN_WORLD)
+        _stats.decrease(LoadStats::IN_WORLD);
+
+    delete _verifier;
+    delete _encryptor;
+    delete _decryptor;
+    _verifier = NULL;
+    _encryptor = NULL;
+    _decryptor = NULL;
+
+    _state = STATE_IDLE;
+
+    if (_behaviour.reconnect)
+    {
+        _reconnect = true;
+        _reconnectAt.update();
+        _reconnectAt += (Poco::Timestamp::TimeDiff)_behaviour.reconnectDelay * 1000;
+    }
+}
+
+void Bot::setWriting(bool writing)
+{
+    if (_writing == writing)
+        return;
+
+    if (writing)
+        _reactor.addEventHandler(_socket, Poco::NObserver<Bot, WritableNotification>(*this, &Bot::onWritable));
+    else
+        _reactor.removeEventHandler(_socket, Poco::NObserver<Bot, WritableNotification>(*this, &Bot::onWritable));
+
+    _writing = writing;
+}
+
+/**
+ * Sends as much of the output as the socket takes, the rest is sent once
+ * it is writable again
+ */
+void Bot::flush()
+{
+    while (!_output.empty())
+    {
+        int nBytes = 0;
+        try
+        {
+            nBytes = _socket.sendBytes(&_output[0], (int)_output.size());
+        }
+        catch (Poco::TimeoutException&)
+        {
+            break;
+        }
+        catch (Poco::Exception&)
+        {
+            close(LoadStats::NETWORK_ERRORS);
+            return;
+        }
+
+        if (nBytes <= 0)
+            break;
+
+        _output.erase(_output.begin(), _output.begin() + nBytes);
+    }
+
+    setWriting(!_output.empty());
+}
+
+/**
+ * Writes a packet as the server reads it, and frees it
+ *
+ * @param packet Packet to send
+ * @param secured Signed, and encrypted if the behaviour says so; all but
+ *  the EHLO are
+ */
+void Bot::send(Packet* packet, bool secured)
+{
+    if (_state == STATE_IDLE)
+    {
+        delete packet;
+        return;
+    }
+
+    Poco::UInt16 length = packet->getLength();
+    std::vector<Poco::UInt8> data(packet->rawdata, packet->rawdata + length);
+    Poco::UInt16 len = length;
+
+    // The server decrypts whole blocks, the padding is left unread
+    if (secured && _behaviour.encrypt && length)
+    {
+        data.resize((length + 15) / 16 * 16, 0);
+        _encryptor->ProcessData(&data[0], &data[0], data.size());
+        len = (Poco::UInt16)data.size() | 0xA000;
+    }
+
+    // Each packet carries the next security byte, as the server expects it
+    Poco::UInt32 result = (0x3F * (~_securityByte + 0x34));
+    result = result ^ (result >> 4);
+    _securityByte = result & 0xFF;
+    Poco::UInt8 sec = (Poco::UInt8)_securityByte;
+
+    Poco::UInt8 digest[PACKET_HMAC_SIZE];
+    memset(digest, 0, sizeof(digest));
+    if (secured)
+        _verifier->CalculateDigest(digest, data.empty() ? NULL : &data[0], data.size());
+
+    _output.insert(_output.end(), (const char*)&len, (const char*)&len + sizeof(len));
+    _output.insert(_output.end(), (const char*)&packet->opcode, (const char*)&packet->opcode + sizeof(packet->opcode));
+    _output.insert(_output.end(), (const char*)&sec, (const char*)&sec + sizeof(sec));
+    _output.insert(_output.end(), (const char*)digest, (const char*)digest + sizeof(digest));
+    _output.insert(_output.end(), data.begin(), data.end());
+
+    _stats.add(LoadStats::PACKETS_OUT);
+    _stats.add(LoadStats::BYTES_OUT, BOT_HEADER_SIZE + data.size());
+    _lastSend.update();
+    delete packet;
+
+    flush();
+}
+
+/**
+ * Handles every complete packet read so far
+ */
+void Bot::readPackets()
+{
+    size_t offset = 0;
+    while (_state != STATE_IDLE && _input.size() - offset >= BOT_HEADER_SIZE)
+    {
+        const char* header = &_input[offset];
+
+        Poco::UInt16 len;
+        Poco::UInt16 opcode;
+        memcpy(&len, header, sizeof(len));
+        memcpy(&opcode, header + 2, sizeof(opcode));
+
+        Poco::UInt16 length = (len & 0xA000) == 0xA000 ? len & 0x5FFF : len;
+        if (_input.size() - offset < BOT_HEADER_SIZE + (size_t)length)
+            break;
+
+        Packet packet(opcode, length);
+        packet.len = len;
+        packet.sec = header[4];
+        memcpy(packet.digest, header + 5, sizeof(packet.digest));
+        if (length)
+            memcpy(packet.rawdata, header + BOT_HEADER_SIZE, length);
+
+        offset += BOT_HEADER_SIZE + length;
+        _stats.add(LoadStats::PACKETS_IN);
+
+        if (!handlePacket(&packet))
+            close(LoadStats::BAD_PACKETS);
+    }
+
+    // Closing leaves the input to be cleared on the next connection
+    if (_state != STATE_IDLE)
+        _input.erase(_input.begin(), _input.begin() + offset);
+}
+
+/**
+ * Verifies, decrypts and handles a packet from the server
+ *
+ * @param packet Packet read
+ * @return false if it is not what the server should have sent
+ */
+bool Bot::handlePacket(Packet* packet)
+{
+    // All but the EHLO are signed, and so is a time out unless it comes
+    // before the server has read our EHLO
+    if (packet->opcode != OPCODE_SC_EHLO && packet->opcode != OPCODE_SC_TIME_OUT)
+        if (!_verifier || !_verifier->VerifyDigest(packet->digest, packet->rawdata, packet->getLength()))
+            return false;
+
+    if (packet->isEncrypted() && !decrypt(packet))
+        return false;
+
+    switch (packet->opcode)
+    {
+        case OPCODE_SC_EHLO:
+            return handleEHLO(packet);
+
+        case OPCODE_SC_LOGIN_QUEUE:
+            if (!_queued)
+                _stats.add(LoadStats::QUEUED);
+            _queued = true;
+            return true;
+
+        case OPCODE_SC_LOGIN_RESULT:
+            return handleLoginResult(packet);
+
+        case OPCODE_SC_SEND_CHARACTERS_LIST:
+            return handleCharactersList(packet);
+
+        case OPCODE_SC_SELECT_CHARACTER_RESULT:
+            return handleSelectResult(packet);
+
+        case OPCODE_SC_PONG:
+            return handlePong(packet);
+
+        case OPCODE_SC_TIME_OUT:
+            return handleTimeOut(packet);
+
+        // The world (spawns, stats, tickets) is only counted
+        default:
+            return true;
+    }
+}
+
+/**
+ * Decrypts a packet, as encrypted by the server with PKCS padding
+ *
+ * @param packet Encrypted packet, its length is set to the plain one
+ * @return false if it can not be decrypted
+ */
+bool Bot::decrypt(Packet* packet)
+{
+    Poco::UInt16 length = packet->getLength();
+    if (!_decryptor || !length || length % 16)
+        return false;
+
+    _decryptor->ProcessData(packet->rawdata, packet->rawdata, length);
+
+    Poco::UInt8 padding = packet->rawdata[length - 1];
+    if (!padding || padding > 16)
+        return false;
+
+    packet->len = length - padding;
+    return true;
+}
+
+/**
+ * Takes the keys from the EHLO and answers it with the high part of the
+ * HMAC key, then logs in if it has to
+ */
+bool Bot::handleEHLO(Packet* packet)
+{
+    // 10 HMAC, 1 SEC, 16 AES Key
+    if (_state != STATE_HANDSHAKE || packet->getLength() < 27)
+        return false;
+
+    memcpy(_HMACKey, packet->rawdata, 10);
+    _securityByte = packet->rawdata[10];
+    memcpy(_AESKey, packet->rawdata + 11, sizeof(_AESKey));
+
+    Packet* resp = new Packet(OPCODE_CS_EHLO, 10);
+    for (Poco::UInt8 i = 0; i < 10; ++i)
+    {
+        _HMACKey[i + 10] = (Poco::UInt8)_random();
+        *resp << _HMACKey[i + 10];
+    }
+
+    _verifier = new CryptoPP::HMAC<CryptoPP::SHA1>(_HMACKey, PACKET_HMAC_SIZE);
+    _encryptor = new CryptoPP::ECB_Mode<CryptoPP::AES>::Encryption(_AESKey, 16);
+    _decryptor = new CryptoPP::ECB_Mode<CryptoPP::AES>::Decryption(_AESKey, 16);
+
+    send(resp, false);
+    if (_state == STATE_IDLE)
+        return true;
+
+    _stats.add(LoadStats::HANDSHAKES);
+    _stats.sample(LoadStats::LATENCY_HANDSHAKE, _stepStart.elapsed());
+
+    if (_behaviour.login)
+        sendLogin();
+    else
+        settle(STATE_READY);
+
+    return true;
+}
+
+void Bot::sendLogin()
+{
+    std::string username = _scenario.getUsername(_account);
+
+    Packet* packet = new Packet(OPCODE_CS_SEND_LOGIN, (Poco::UInt16)(sizeof(Poco::UInt16) + username.length() + 16));
+    *packet << username;
+    for (Poco::UInt8 i = 0; i < 16; ++i)
+        *packet << (Poco::UInt8)strtoul(_scenario.password.substr(i * 2, 2).c_str(), NULL, 16);
+
+    _state = STATE_LOGIN;
+    _stepStart.update();
+    send(packet, true);
+}
+
+bool Bot::handleLoginResult(Packet* packet)
+{
+    if (_state != STATE_LOGIN || packet->getLength() < 1)
+        return false;
+
+    Poco::UInt8 result;
+    *packet >> result;
+
+    if (result != 0x01)
+    {
+        close(result == 0x02 ? LoadStats::ALREADY_ONLINE : LoadStats::LOGIN_FAILURES);
+        return true;
+    }
+
+    _stats.add(LoadStats::LOGINS);
+    _stats.sample(LoadStats::LATENCY_LOGIN, _stepStart.elapsed());
+
+    if (!_behaviour.enterWorld)
+    {
+        settle(STATE_READY);
+        return true;
+    }
+
+    // Entering the world is timed from here to the select result
+    Packet* req = new Packet(OPCODE_CS_REQUEST_CHARACTERS, 1);
+    *req << Poco::UInt8(0x01);
+
+    _state = STATE_CHARACTERS;
+    _stepStart.update();
+    send(req, true);
+    return true;
+}
+
+bool Bot::handleCharactersList(Packet* packet)
+{
+    if (_state != STATE_CHARACTERS || packet->getLength() < 1)
+        return false;
+
+    Poco::UInt8 count;
+    *packet >> count;
+
+    if (!count)
+    {
+        close(LoadStats::NO_CHARACTERS);
+        return true;
+    }
+
+    if (packet->getLength() < 1 + sizeof(Poco::UInt32))
+        return false;
+
+    // The first one is played
+    Poco::UInt32 character;
+    *packet >> character;
+
+    Packet* req = new Packet(OPCODE_CS_SELECT_CHARACTER, 4);
+    *req << character;
+
+    _state = STATE_SELECT;
+    send(req, true);
+    return true;
+}
+
+bool Bot::handleSelectResult(Packet* packet)
+{
+    if (_state != STATE_SELECT || packet->getLength() < 1)
+        return false;
+
+    Poco::UInt8 result;
+    *packet >> result;
+
+    if (result != 0x01)
+    {
+        close(LoadStats::SELECT_FAILURES);
+        return true;
+    }
+
+    _stats.add(LoadStats::ENTERED_WORLD);
+    _stats.increase(LoadStats::IN_WORLD);
+    _stats.sample(LoadStats::LATENCY_ENTER_WORLD, _stepStart.elapsed());
+    settle(STATE_IN_WORLD);
+    return true;
+}
+
+void Bot::sendPing()
+{
+    Packet* packet = new Packet(OPCODE_CS_PING, 8);
+    *packet << (Poco::UInt64)Poco::Timestamp().epochMicroseconds();
+    send(packet, true);
+}
+
+bool Bot::handlePong(Packet* packet)
+{
+    if (packet->getLength() < sizeof(Poco::UInt64))
+        return false;
+
+    Poco::UInt64 sent;
+    *packet >> sent;
+
+    _stats.sample(LoadStats::LATENCY_RTT, Poco::Timestamp().epochMicroseconds() - (Poco::Timestamp::TimeVal)sent);
+    return true;
+}
+
+/**
+ * The server is about to close the connection, and says why
+ */
+bool Bot::handleTimeOut(Packet* packet)
+{
+    Poco::UInt8 reason = 0;
+    if (packet->getLength() >= 1)
+        *packet >> reason;
+
+    if (reason == BOT_DISCONNECTED_TIME_OUT)
+        _disconnectReason = LoadStats::DISCONNECTED_TIME_OUT;
+    else if (reason == BOT_DISCONNECTED_INCORRECT_DATA)
+        _disconnectReason = LoadStats::DISCONNECTED_INCORRECT_DATA;
+
+    return true;
+}
+
+/**
+ * The bot is done connecting, from now on it pings, keeps alive and
+ * waits to leave
+ */
+void Bot::settle(State state)
+{
+    _state = state;
+    _settled.update();
+    _nextPing = _settled;
+}
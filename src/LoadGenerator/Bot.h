@@ -0,0 +1,124 @@
+#ifndef GAMESERVER_BOT_H
+#define GAMESERVER_BOT_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Poco/Poco.h"
+#include "Poco/AutoPtr.h"
+#include "Poco/NObserver.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Net/SocketAddress.h"
+#include "Poco/Net/SocketNotification.h"
+#include "Poco/Net/SocketReactor.h"
+#include "Poco/Net/StreamSocket.h"
+
+#include <modes.h>
+#include <sha.h>
+#include <aes.h>
+#include <hmac.h>
+
+#include "LoadStats.h"
+#include "Scenario.h"
+
+using Poco::AutoPtr;
+using Poco::Net::ErrorNotification;
+using Poco::Net::ReadableNotification;
+using Poco::Net::SocketAddress;
+using Poco::Net::SocketReactor;
+using Poco::Net::StreamSocket;
+using Poco::Net::WritableNotification;
+
+class Packet;
+
+/**
+ * A client of the server, speaking its protocol on a non-blocking socket
+ * driven by a reactor: it answers the EHLO, logs in, enters the world with
+ * its first character and pings the server, as its behaviour says
+ */
+class Bot
+{
+public:
+    enum State
+    {
+        STATE_IDLE,
+        STATE_CONNECTING,
+        STATE_HANDSHAKE,
+        STATE_LOGIN,
+        STATE_CHARACTERS,
+        STATE_SELECT,
+        STATE_READY,
+        STATE_IN_WORLD,
+    };
+
+    Bot(Poco::UInt32 account, const Scenario& scenario, const Behaviour& behaviour, LoadStats& stats, SocketReactor& reactor, const SocketAddress& address);
+    ~Bot();
+
+    void connect();
+    void update(const Poco::Timestamp& now);
+
+    inline State getState()
+    {
+        return _state;
+    }
+
+    void onReadable(const AutoPtr<ReadableNotification>& nf);
+    void onWritable(const AutoPtr<WritableNotification>& nf);
+    void onError(const AutoPtr<ErrorNotification>& nf);
+
+private:
+    bool finishConnect();
+    void close(LoadStats::Counter reason);
+    void setWriting(bool writing);
+    void flush();
+
+    void send(Packet* packet, bool secured);
+    void readPackets();
+    bool handlePacket(Packet* packet);
+    bool decrypt(Packet* packet);
+
+    bool handleEHLO(Packet* packet);
+    bool handleLoginResult(Packet* packet);
+    bool handleCharactersList(Packet* packet);
+    bool handleSelectResult(Packet* packet);
+    bool handlePong(Packet* packet);
+    bool handleTimeOut(Packet* packet);
+
+    void sendLogin();
+    void sendPing();
+    void settle(State state);
+
+private:
+    Poco::UInt32 _account;
+    const Scenario& _scenario;
+    const Behaviour& _behaviour;
+    LoadStats& _stats;
+    SocketReactor& _reactor;
+    SocketAddress _address;
+    std::mt19937 _random;
+
+    State _state;
+    StreamSocket _socket;
+    bool _writing;
+    std::vector<char> _input;
+    std::vector<char> _output;
+
+    Poco::UInt32 _securityByte;
+    Poco::UInt8 _HMACKey[20];
+    Poco::UInt8 _AESKey[16];
+    CryptoPP::HMAC<CryptoPP::SHA1>* _verifier;
+    CryptoPP::ECB_Mode<CryptoPP::AES>::Encryption* _encryptor;
+    CryptoPP::ECB_Mode<CryptoPP::AES>::Decryption* _decryptor;
+
+    LoadStats::Counter _disconnectReason;
+    bool _queued;
+    Poco::Timestamp _stepStart;
+    Poco::Timestamp _settled;
+    Poco::Timestamp _lastSend;
+    Poco::Timestamp _nextPing;
+    Poco::Timestamp _reconnectAt;
+    bool _reconnect;
+};
+
+#endif
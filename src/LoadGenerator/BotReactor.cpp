@@ -0,0 +1,68 @@
+#include "BotReactor.h"
+#include "Bot.h"
+
+//@ Microseconds the reactor waits for its sockets, and between updates
+#define BOT_REACTOR_INTERVAL 10000
+
+/**
+ * @param connectInterval Microseconds between two connections
+ */
+BotReactor::BotReactor(Poco::Timestamp::TimeDiff connectInterval):
+    SocketReactor(Poco::Timespan(BOT_REACTOR_INTERVAL)),
+    _started(0),
+    _connectInterval(connectInterval)
+{
+}
+
+BotReactor::~BotReactor()
+{
+    for (std::vector<Bot*>::iterator itr = _bots.begin(); itr != _bots.end(); ++itr)
+        delete *itr;
+}
+
+/**
+ * Adds a bot, before the reactor runs
+ *
+ * @param bot Bot using this reactor, it is owned by it
+ */
+void BotReactor::add(Bot* bot)
+{
+    _bots.push_back(bot);
+}
+
+void BotReactor::onTimeout()
+{
+    update();
+}
+
+void BotReactor::onIdle()
+{
+    update();
+}
+
+void BotReactor::onBusy()
+{
+    update();
+}
+
+/**
+ * Connects the bots whose turn has come, and updates them all, no more
+ * than once per interval
+ */
+void BotReactor::update()
+{
+    Poco::Timestamp now;
+    if (now - _lastUpdate < BOT_REACTOR_INTERVAL)
+        return;
+
+    _lastUpdate = now;
+
+    while (_started < _bots.size() && now >= _nextConnect)
+    {
+        _bots[_started++]->connect();
+        _nextConnect += _connectInterval;
+    }
+
+    for (std::vector<Bot*>::iterator itr = _bots.begin(); itr != _bots.end(); ++itr)
+        (*itr)->update(now);
+}
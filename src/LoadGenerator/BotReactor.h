@@ -0,0 +1,40 @@
+#ifndef GAMESERVER_BOT_REACTOR_H
+#define GAMESERVER_BOT_REACTOR_H
+
+#include <vector>
+
+#include "Poco/Poco.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Net/SocketReactor.h"
+
+class Bot;
+
+/**
+ * Runs the sockets of a share of the bots on one thread, connects them
+ * at a given pace and gives them time to send what is due
+ */
+class BotReactor : public Poco::Net::SocketReactor
+{
+public:
+    BotReactor(Poco::Timestamp::TimeDiff connectInterval);
+    ~BotReactor();
+
+    void add(Bot* bot);
+
+protected:
+    void onTimeout();
+    void onIdle();
+    void onBusy();
+
+private:
+    void update();
+
+private:
+    std::vector<Bot*> _bots;
+    size_t _started;
+    Poco::Timestamp::TimeDiff _connectInterval;
+    Poco::Timestamp _nextConnect;
+    Poco::Timestamp _lastUpdate;
+};
+
+#endif
@@ -0,0 +1,261 @@
+/**
+ * Connects bots speaking the client protocol to a running server, as many
+ * and behaving as a scenario says (see LoadGenerator.scenario.dist), and
+ * reports what they see every few seconds:
+ *
+ *  LoadGenerator LoadGenerator.scenario
+ *
+ * Bots log in with the accounts the scenario makes up, which must be in the
+ * database. --sql writes them, with a character each, for the SQLite files:
+ *
+ *  LoadGenerator LoadGenerator.scenario --sql bots_
+ *  sqlite3 auth.db < bots_auth.sql
+ *  sqlite3 characters.db < bots_characters.sql
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Poco/Exception.h"
+#include "Poco/Thread.h"
+#include "Poco/Timestamp.h"
+#include "Poco/Net/SocketAddress.h"
+
+#include "Bot.h"
+#include "BotReactor.h"
+#include "defines.h"
+#include "LoadStats.h"
+#include "Scenario.h"
+
+/**
+ * Writes the accounts and characters of the bots, replacing the ones with
+ * the same ids
+ *
+ * @param scenario Scenario giving the bots
+ * @param prefix Prefix of the two files written
+ * @return false if they can not be written
+ */
+static bool writeSQL(const Scenario& scenario, const std::string& prefix)
+{
+    std::string authPath = prefix + "auth.sql";
+    std::string charactersPath = prefix + "characters.sql";
+
+    FILE* auth = fopen(authPath.c_str(), "w");
+    FILE* characters = fopen(charactersPath.c_str(), "w");
+    if (!auth || !characters)
+    {
+        fprintf(stderr, "Can not write %s\n", !auth ? authPath.c_str() : charactersPath.c_str());
+        if (auth)
+            fclose(auth);
+        if (characters)
+            fclose(characters);
+        return false;
+    }
+
+    // Characters are spread over the whole map
+    std::mt19937 random(scenario.seed);
+
+    fprintf(auth, "BEGIN;\n");
+    fprintf(characters, "BEGIN;\n");
+
+    for (Poco::UInt32 i = 0; i < scenario.bots; ++i)
+    {
+        Poco::UInt32 account = scenario.firstAccount + i;
+        std::string username = scenario.getUsername(account);
+        int x = MAP_MIN_X + int(random() % (MAP_MAX_X - MAP_MIN_X));
+        int z = MAP_MIN_Z + int(random() % (MAP_MAX_Z - MAP_MIN_Z));
+
+        fprintf(auth, "REPLACE INTO account (id, username, password, online) VALUES (%u, '%s', '%s', 0);\n",
+            account, username.c_str(), scenario.password.c_str());
+        fprintf(characters, "REPLACE INTO characters (id, account, name, x, y) VALUES (%u, %u, '%s', %d, %d);\n",
+            account, account, username.c_str(), x, z);
+    }
+
+    fprintf(auth, "COMMIT;\n");
+    fprintf(characters, "COMMIT;\n");
+
+    fclose(auth);
+    fclose(characters);
+
+    printf("%u accounts written to %s and %s\n", scenario.bots, authPath.c_str(), charactersPath.c_str());
+    return true;
+}
+
+template <typename T>
+static T percentile(std::vector<T> values, float percent)
+{
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)(percent / 100.0f * (values.size() - 1) + 0.5f);
+    return values[index];
+}
+
+/**
+ * Formats the p50 and p99 of some latencies, in miliseconds
+ */
+static std::string formatLatency(const LoadStats::Samples& samples)
+{
+    if (samples.empty())
+        return "-";
+
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.2f/%.2f", percentile(samples, 50) / 1000.0, percentile(samples, 99) / 1000.0);
+    return buffer;
+}
+
+static Poco::UInt64 countErrors(const Poco::UInt64* counters)
+{
+    return counters[LoadStats::CONNECT_FAILURES] + counters[LoadStats::LOGIN_FAILURES] +
+        counters[LoadStats::ALREADY_ONLINE] + counters[LoadStats::NO_CHARACTERS] +
+        counters[LoadStats::SELECT_FAILURES] + counters[LoadStats::BAD_PACKETS] +
+        counters[LoadStats::DISCONNECTED_TIME_OUT] + counters[LoadStats::DISCONNECTED_INCORRECT_DATA] +
+        counters[LoadStats::CLOSED_BY_SERVER] + counters[LoadStats::NETWORK_ERRORS];
+}
+
+/**
+ * Prints what has happened since the previous report
+ *
+ * @param elapsed Seconds since the start
+ * @param seconds Seconds since the previous report
+ * @param current Stats now
+ * @param previous Stats on the previous report
+ */
+static void printReport(Poco::UInt32 elapsed, double seconds, const LoadStats::Snapshot& current, const LoadStats::Snapshot& previous)
+{
+    Poco::UInt64 counters[LoadStats::MAX_COUNTERS];
+    for (Poco::UInt8 i = 0; i < LoadStats::MAX_COUNTERS; ++i)
+        counters[i] = current.counters[i] - previous.counters[i];
+
+    printf("%5us  open %6lld  world %6lld  connects %7.1f/s  in %8.1f KB/s  out %8.1f KB/s  errors %5llu  connect %s  login %s  world %s  rtt %s ms\n",
+        elapsed,
+        (long long)current.gauges[LoadStats::OPEN],
+        (long long)current.gauges[LoadStats::IN_WORLD],
+        counters[LoadStats::CONNECTS] / seconds,
+        counters[LoadStats::BYTES_IN] / seconds / 1024.0,
+        counters[LoadStats::BYTES_OUT] / seconds / 1024.0,
+        (unsigned long long)countErrors(counters),
+        formatLatency(current.latencies[LoadStats::LATENCY_CONNECT]).c_str(),
+        formatLatency(current.latencies[LoadStats::LATENCY_LOGIN]).c_str(),
+        formatLatency(current.latencies[LoadStats::LATENCY_ENTER_WORLD]).c_str(),
+        formatLatency(current.latencies[LoadStats::LATENCY_RTT]).c_str());
+    fflush(stdout);
+}
+
+/**
+ * Prints every counter and latency of the whole run
+ */
+static void printSummary(double seconds, const LoadStats::Snapshot& total)
+{
+    printf("\n");
+    for (Poco::UInt8 i = 0; i < LoadStats::MAX_COUNTERS; ++i)
+        printf("%-30s %12llu\n", LoadStats::getCounterName(LoadStats::Counter(i)), (unsigned long long)total.counters[i]);
+
+    printf("%-30s %12.1f\n", "bytes in per second", total.counters[LoadStats::BYTES_IN] / seconds);
+    printf("%-30s %12.1f\n", "bytes out per second", total.counters[LoadStats::BYTES_OUT] / seconds);
+
+    printf("\n");
+    for (Poco::UInt8 i = 0; i < LoadStats::MAX_LATENCIES; ++i)
+    {
+        const LoadStats::Samples& samples = total.latencies[i];
+        if (samples.empty())
+            continue;
+
+        printf("%-12s p50 %8.3f  p99 %8.3f  max %8.3f ms  (%u samples)\n", LoadStats::getLatencyName(LoadStats::Latency(i)),
+            percentile(samples, 50) / 1000.0,
+            percentile(samples, 99) / 1000.0,
+            *std::max_element(samples.begin(), samples.end()) / 1000.0,
+            (Poco::UInt32)samples.size());
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2 && !(argc == 4 && std::string(argv[2]) == "--sql"))
+    {
+        fprintf(stderr, "Usage: %s <scenario> [--sql <prefix>]\n", argv[0]);
+        return 1;
+    }
+
+    Scenario scenario;
+    if (!scenario.read(argv[1]))
+        return 1;
+
+    if (argc == 4)
+        return writeSQL(scenario, argv[3]) ? 0 : 1;
+
+    SocketAddress address;
+    try
+    {
+        address = SocketAddress(scenario.host, scenario.port);
+    }
+    catch (Poco::Exception& e)
+    {
+        fprintf(stderr, "Can not resolve %s: %s\n", scenario.host.c_str(), e.displayText().c_str());
+        return 1;
+    }
+
+    // Each reactor connects its share of the bots at its share of the rate
+    LoadStats stats;
+    Poco::Timestamp::TimeDiff connectInterval = (Poco::Timestamp::TimeDiff)1000000 * scenario.threads / scenario.connectRate;
+    std::vector<BotReactor*> reactors;
+    for (Poco::UInt32 i = 0; i < scenario.threads; ++i)
+        reactors.push_back(new BotReactor(connectInterval));
+
+    std::mt19937 random(scenario.seed);
+    for (Poco::UInt32 i = 0; i < scenario.bots; ++i)
+    {
+        BotReactor* reactor = reactors[i % scenario.threads];
+        reactor->add(new Bot(scenario.firstAccount + i, scenario, scenario.pick(random()), stats, *reactor, address));
+    }
+
+    printf("%u bots on %s, %u threads, %u connections per second\n", scenario.bots, address.toString().c_str(), scenario.threads, scenario.connectRate);
+
+    std::vector<Poco::Thread*> threads;
+    for (std::vector<BotReactor*>::iterator itr = reactors.begin(); itr != reactors.end(); ++itr)
+    {
+        Poco::Thread* thread = new Poco::Thread();
+        thread->setName("Bots");
+        thread->start(**itr);
+        threads.push_back(thread);
+    }
+
+    LoadStats::Snapshot previous = LoadStats::Snapshot();
+    LoadStats::Snapshot total = LoadStats::Snapshot();
+    Poco::Timestamp start;
+    Poco::Timestamp lastReport;
+
+    // A duration of 0 runs until killed
+    while (!scenario.duration || start.elapsed() < (Poco::Timestamp::TimeDiff)scenario.duration * 1000000)
+    {
+        Poco::Thread::sleep(scenario.report * 1000);
+
+        LoadStats::Snapshot current;
+        stats.take(current);
+        printReport((Poco::UInt32)(start.elapsed() / 1000000), lastReport.elapsed() / 1000000.0, current, previous);
+        lastReport.update();
+
+        for (Poco::UInt8 i = 0; i < LoadStats::MAX_LATENCIES; ++i)
+            total.latencies[i].insert(total.latencies[i].end(), current.latencies[i].begin(), current.latencies[i].end());
+
+        previous = current;
+    }
+
+    for (std::vector<BotReactor*>::iterator itr = reactors.begin(); itr != reactors.end(); ++itr)
+        (*itr)->stop();
+
+    for (std::vector<Poco::Thread*>::iterator itr = threads.begin(); itr != threads.end(); ++itr)
+    {
+        (*itr)->join();
+        delete *itr;
+    }
+
+    std::copy(previous.counters, previous.counters + LoadStats::MAX_COUNTERS, total.counters);
+    printSummary(start.elapsed() / 1000000.0, total);
+
+    for (std::vector<BotReactor*>::iterator itr = reactors.begin(); itr != reactors.end(); ++itr)
+        delete *itr;
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "LoadStats.h"
+
+static const char* CounterNames[LoadStats::MAX_COUNTERS] =
+{
+    "connects",
+    "connect failures",
+    "handshakes",
+    "logins",
+    "login failures",
+    "already online",
+    "queued",
+    "entered world",
+    "no characters",
+    "select failures",
+    "packets in",
+    "packets out",
+    "bytes in",
+    "bytes out",
+    "bad packets",
+    "disconnected, time out",
+    "disconnected, incorrect data",
+    "closed by server",
+    "network errors",
+    "left",
+};
+
+static const char* LatencyNames[LoadStats::MAX_LATENCIES] =
+{
+    "connect",
+    "handshake",
+    "login",
+    "enter world",
+    "rtt",
+};
+
+LoadStats::LoadStats()
+{
+    for (Poco::UInt8 i = 0; i < MAX_COUNTERS; ++i)
+        _counters[i] = 0;
+
+    for (Poco::UInt8 i = 0; i < MAX_GAUGES; ++i)
+        _gauges[i] = 0;
+}
+
+/**
+ * Records how long something took
+ *
+ * @param latency What took it
+ * @param elapsed Microseconds
+ */
+void LoadStats::sample(Latency latency, Poco::Timestamp::TimeDiff elapsed)
+{
+    Poco::FastMutex::ScopedLock lock(_latenciesMutex);
+    _latencies[latency].push_back((Poco::UInt32)elapsed);
+}
+
+/**
+ * Copies the counters and gauges, and moves the latencies recorded since
+ * the last call
+ *
+ * @param snapshot Where they are stored
+ */
+void LoadStats::take(Snapshot& snapshot)
+{
+    for (Poco::UInt8 i = 0; i < MAX_COUNTERS; ++i)
+        snapshot.counters[i] = _counters[i].load(std::memory_order_relaxed);
+
+    for (Poco::UInt8 i = 0; i < MAX_GAUGES; ++i)
+        snapshot.gauges[i] = _gauges[i].load(std::memory_order_relaxed);
+
+    Poco::FastMutex::ScopedLock lock(_latenciesMutex);
+    for (Poco::UInt8 i = 0; i < MAX_LATENCIES; ++i)
+    {
+        snapshot.latencies[i].clear();
+        snapshot.latencies[i].swap(_latencies[i]);
+    }
+}
+
+const char* LoadStats::getCounterName(Counter counter)
+{
+    return CounterNames[counter];
+}
+
+const char* LoadStats::getLatencyName(Latency latency)
+{
+    return LatencyNames[latency];
+}
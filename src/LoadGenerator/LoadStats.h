@@ -0,0 +1,101 @@
+#ifndef GAMESERVER_LOAD_STATS_H
+#define GAMESERVER_LOAD_STATS_H
+
+#include <atomic>
+#include <vector>
+
+#include "Poco/Poco.h"
+#include "Poco/Mutex.h"
+#include "Poco/Timestamp.h"
+
+/**
+ * What all the bots have done, recorded from every bot thread and read by
+ * the reports. Counters only grow, gauges go up and down, latencies are
+ * kept in microseconds until they are taken
+ */
+class LoadStats
+{
+public:
+    enum Counter
+    {
+        CONNECTS,
+        CONNECT_FAILURES,
+        HANDSHAKES,
+        LOGINS,
+        LOGIN_FAILURES,
+        ALREADY_ONLINE,
+        QUEUED,
+        ENTERED_WORLD,
+        NO_CHARACTERS,
+        SELECT_FAILURES,
+        PACKETS_IN,
+        PACKETS_OUT,
+        BYTES_IN,
+        BYTES_OUT,
+        BAD_PACKETS,
+        DISCONNECTED_TIME_OUT,
+        DISCONNECTED_INCORRECT_DATA,
+        CLOSED_BY_SERVER,
+        NETWORK_ERRORS,
+        LEFT,
+        MAX_COUNTERS,
+    };
+
+    enum Gauge
+    {
+        OPEN,
+        IN_WORLD,
+        MAX_GAUGES,
+    };
+
+    enum Latency
+    {
+        LATENCY_CONNECT,
+        LATENCY_HANDSHAKE,
+        LATENCY_LOGIN,
+        LATENCY_ENTER_WORLD,
+        LATENCY_RTT,
+        MAX_LATENCIES,
+    };
+
+    typedef std::vector<Poco::UInt32> Samples;
+
+    struct Snapshot
+    {
+        Poco::UInt64 counters[MAX_COUNTERS];
+        Poco::Int64 gauges[MAX_GAUGES];
+        Samples latencies[MAX_LATENCIES];
+    };
+
+    LoadStats();
+
+    inline void add(Counter counter, Poco::UInt64 value = 1)
+    {
+        _counters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    inline void increase(Gauge gauge)
+    {
+        _gauges[gauge].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline void decrease(Gauge gauge)
+    {
+        _gauges[gauge].fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void sample(Latency latency, Poco::Timestamp::TimeDiff elapsed);
+    void take(Snapshot& snapshot);
+
+    static const char* getCounterName(Counter counter);
+    static const char* getLatencyName(Latency latency);
+
+private:
+    std::atomic<Poco::UInt64> _counters[MAX_COUNTERS];
+    std::atomic<Poco::Int64> _gauges[MAX_GAUGES];
+
+    Samples _latencies[MAX_LATENCIES];
+    Poco::FastMutex _latenciesMutex;
+};
+
+#endif
@@ -0,0 +1,205 @@
+#include "Scenario.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#include "Poco/NumberFormatter.h"
+#include "Poco/StringTokenizer.h"
+
+Behaviour::Behaviour():
+    name("default"), weight(1),
+    login(true), enterWorld(true), encrypt(false),
+    ping(1000), keepAlive(5000), stay(0),
+    reconnect(false), reconnectDelay(0)
+{
+}
+
+Scenario::Scenario():
+    host("127.0.0.1"), port(1616),
+    bots(100), threads(2),
+    connectRate(100),
+    duration(60), report(1),
+    seed(1),
+    accountPrefix("bot"), firstAccount(1),
+    password("00000000000000000000000000000000"),
+    totalWeight(0)
+{
+}
+
+static bool parseNumber(const std::string& token, Poco::UInt32& value)
+{
+    char* end = NULL;
+    value = (Poco::UInt32)strtoul(token.c_str(), &end, 10);
+    return !token.empty() && *end == '\0';
+}
+
+static bool parseBool(const std::string& token, bool& value)
+{
+    value = token == "yes";
+    return value || token == "no";
+}
+
+/**
+ * Checks a hex string and lowercases it, as the server stores hex digests
+ *
+ * @param token Hex string, lowercased in place
+ * @param length Expected length
+ * @return false if it is not hex of that length
+ */
+static bool parseHex(std::string& token, Poco::UInt32 length)
+{
+    if (token.length() != length || token.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+        return false;
+
+    std::transform(token.begin(), token.end(), token.begin(), ::tolower);
+    return true;
+}
+
+/**
+ * Reads a scenario, one setting per line, as "name value". A behaviour
+ * line starts a behaviour, and the lines after it set it up:
+ *
+ *  bots 1000
+ *  behaviour idle 80
+ *      ping 1000
+ *
+ * @param path Scenario file
+ * @return false if it can not be read or has a wrong line, which is printed
+ */
+bool Scenario::read(const std::string& path)
+{
+    std::ifstream input(path.c_str());
+    if (!input.is_open())
+    {
+        fprintf(stderr, "Can not open %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    Poco::UInt32 lineNumber = 0;
+    while (std::getline(input, line))
+    {
+        ++lineNumber;
+
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        Poco::StringTokenizer tokens(line, " \t\r", Poco::StringTokenizer::TOK_TRIM | Poco::StringTokenizer::TOK_IGNORE_EMPTY);
+        if (tokens.count() == 0)
+            continue;
+
+        const std::string& key = tokens[0];
+        bool valid = tokens.count() == 2;
+        Behaviour* behaviour = behaviours.empty() ? NULL : &behaviours.back();
+
+        if (key == "behaviour")
+        {
+            Behaviour added;
+            valid = tokens.count() == 3 && parseNumber(tokens[2], added.weight) && added.weight;
+            if (valid)
+            {
+                added.name = tokens[1];
+                behaviours.push_back(added);
+            }
+        }
+        else if (valid && behaviour && key == "login")
+            valid = parseBool(tokens[1], behaviour->login);
+        else if (valid && behaviour && key == "enter-world")
+            valid = parseBool(tokens[1], behaviour->enterWorld);
+        else if (valid && behaviour && key == "encrypt")
+            valid = parseBool(tokens[1], behaviour->encrypt);
+        else if (valid && behaviour && key == "ping")
+            valid = parseNumber(tokens[1], behaviour->ping);
+        else if (valid && behaviour && key == "keep-alive")
+            valid = parseNumber(tokens[1], behaviour->keepAlive);
+        else if (valid && behaviour && key == "stay")
+            valid = parseNumber(tokens[1], behaviour->stay);
+        else if (valid && behaviour && key == "reconnect")
+        {
+            behaviour->reconnect = tokens[1] != "no";
+            valid = !behaviour->reconnect || parseNumber(tokens[1], behaviour->reconnectDelay);
+        }
+        else if (valid && key == "server")
+        {
+            std::string::size_type colon = tokens[1].rfind(':');
+            Poco::UInt32 number = 0;
+            valid = colon != std::string::npos && parseNumber(tokens[1].substr(colon + 1), number) && number && number <= 0xFFFF;
+            host = tokens[1].substr(0, colon);
+            port = (Poco::UInt16)number;
+        }
+        else if (valid && key == "bots")
+            valid = parseNumber(tokens[1], bots);
+        else if (valid && key == "threads")
+            valid = parseNumber(tokens[1], threads) && threads;
+        else if (valid && key == "connect-rate")
+            valid = parseNumber(tokens[1], connectRate) && connectRate;
+        else if (valid && key == "duration")
+            valid = parseNumber(tokens[1], duration);
+        else if (valid && key == "report")
+            valid = parseNumber(tokens[1], report) && report;
+        else if (valid && key == "seed")
+            valid = parseNumber(tokens[1], seed);
+        else if (key == "accounts")
+        {
+            valid = tokens.count() == 3 && parseNumber(tokens[2], firstAccount) && firstAccount;
+            if (valid)
+                accountPrefix = tokens[1];
+        }
+        else if (valid && key == "password")
+        {
+            std::string value = tokens[1];
+            valid = parseHex(value, 32);
+            password = value;
+        }
+        else
+            valid = false;
+
+        if (!valid)
+        {
+            fprintf(stderr, "%s, line %u: wrong setting \"%s\"\n", path.c_str(), lineNumber, line.c_str());
+            return false;
+        }
+    }
+
+    if (behaviours.empty())
+        behaviours.push_back(Behaviour());
+
+    totalWeight = 0;
+    for (std::vector<Behaviour>::iterator itr = behaviours.begin(); itr != behaviours.end(); ++itr)
+    {
+        // Entering the world needs a login
+        itr->enterWorld = itr->enterWorld && itr->login;
+        totalWeight += itr->weight;
+    }
+
+    return true;
+}
+
+/**
+ * Picks a behaviour according to their weights
+ *
+ * @param random Any random number
+ * @return The behaviour picked
+ */
+const Behaviour& Scenario::pick(Poco::UInt32 random) const
+{
+    Poco::UInt32 point = random % totalWeight;
+    for (std::vector<Behaviour>::const_iterator itr = behaviours.begin(); itr != behaviours.end(); ++itr)
+    {
+        if (point < itr->weight)
+            return *itr;
+
+        point -= itr->weight;
+    }
+
+    return behaviours.back();
+}
+
+std::string Scenario::getUsername(Poco::UInt32 account) const
+{
+    return accountPrefix + Poco::NumberFormatter::format(account);
+}
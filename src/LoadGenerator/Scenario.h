@@ -0,0 +1,59 @@
+#ifndef GAMESERVER_SCENARIO_H
+#define GAMESERVER_SCENARIO_H
+
+#include <string>
+#include <vector>
+
+#include "Poco/Poco.h"
+
+/**
+ * What a bot does once connected. Times are in miliseconds, 0 disables
+ * what they time
+ */
+struct Behaviour
+{
+    Behaviour();
+
+    std::string name;
+    Poco::UInt32 weight;
+
+    bool login;
+    bool enterWorld;
+    bool encrypt;
+    Poco::UInt32 ping;
+    Poco::UInt32 keepAlive;
+    Poco::UInt32 stay;
+    bool reconnect;
+    Poco::UInt32 reconnectDelay;
+};
+
+/**
+ * A load test: where to connect, how many bots, how fast they connect and
+ * the mix of behaviours they are given
+ */
+struct Scenario
+{
+    Scenario();
+
+    bool read(const std::string& path);
+    const Behaviour& pick(Poco::UInt32 random) const;
+    std::string getUsername(Poco::UInt32 account) const;
+
+    std::string host;
+    Poco::UInt16 port;
+    Poco::UInt32 bots;
+    Poco::UInt32 threads;
+    Poco::UInt32 connectRate;
+    Poco::UInt32 duration;
+    Poco::UInt32 report;
+    Poco::UInt32 seed;
+
+    std::string accountPrefix;
+    Poco::UInt32 firstAccount;
+    std::string password;
+
+    std::vector<Behaviour> behaviours;
+    Poco::UInt32 totalWeight;
+};
+
+#endif
@@ -2,105 +2,331 @@
 
 #include "Poco/FileChannel.h"
 #include "Poco/ConsoleChannel.h"
-#include "Poco/AsyncChannel.h"
 #include "Poco/SplitterChannel.h"
 #include "Poco/AutoPtr.h"
 
-#include <stdarg.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
 
 using Poco::FileChannel;
 using Poco::ConsoleChannel;
-using Poco::AsyncChannel;
 using Poco::SplitterChannel;
 using Poco::AutoPtr;
 
+//@ Interval, in miliseconds, at which the log thread writes queued lines
+#define LOG_WRITE_INTERVAL 5
+#define LOG_DEFAULT_BUFFER_SIZE 65536
+
 Log::Log():
-    _logger(Logger::get("Server"))
+    _logger(Logger::get("Server")),
+    _mainThread(Poco::Thread::currentTid()),
+    _bufferSize(LOG_DEFAULT_BUFFER_SIZE),
+    _running(true),
+    _writer(*this, &Log::run)
 {
-    _logger.setLevel(Message::PRIO_INFORMATION);
+    // Lines are filtered by category before being queued
+    _logger.setLevel(Message::PRIO_TRACE);
+    setLogLevel(Message::PRIO_INFORMATION);
 
+    // Channels are written from the log thread only, no need for them to
+    // be asynchronous
     AutoPtr<FileChannel> channel(new FileChannel);
     AutoPtr<ConsoleChannel> cons(new ConsoleChannel);
 
-    AutoPtr<AsyncChannel> asyncFile(new AsyncChannel(channel));
-    AutoPtr<AsyncChannel> asyncConsole(new AsyncChannel(cons));
-
     AutoPtr<SplitterChannel> splitter(new SplitterChannel);
-    
+
     channel->setProperty("path", "Server.log");
     channel->setProperty("rotation", "10 M");
     channel->setProperty("archive", "timestamp");
     channel->setProperty("rotateOnOpen", "true");
-    
-    splitter->addChannel(asyncFile);
-    splitter->addChannel(asyncConsole);
+
+    splitter->addChannel(channel);
+    splitter->addChannel(cons);
 
     _logger.setChannel(splitter);
+
+    _mainBuffer = createBuffer();
+    _sharedBuffer = createBuffer();
+
+    _thread.setName("Log");
+    _thread.start(_writer);
 }
 
 Log::~Log()
 {
+    _running = false;
+    _wakeUp.set();
+    _thread.join();
+
+    // Buffers of threads still running are left to them
+    for (std::vector<LogBuffer*>::iterator itr = _buffers.begin(); itr != _buffers.end(); ++itr)
+        if (*itr == _mainBuffer || *itr == _sharedBuffer || (*itr)->isClosed())
+            delete *itr;
 }
 
-void Log::out(Message::Priority prio, const char* fmt, ...)
+static const char* CategoryNames[MAX_LOG_CATEGORIES] =
 {
-    if (prio > _logger.getLevel())
-        return;
+    "server",
+    "net",
+    "grid",
+    "db",
+    "ai",
+};
 
-    int n, size=100;
-    bool b=false;
-    va_list marker;
-    std::string s;
+const char* Log::getCategoryName(LogCategory category)
+{
+    return CategoryNames[category];
+}
 
-    while (!b)
+/**
+ * Finds a category by its name, as used on the console
+ *
+ * @param name Category name
+ * @param category Category found
+ * @return true if there is one by that name
+ */
+bool Log::findCategory(const std::string& name, LogCategory& category)
+{
+    for (Poco::UInt8 i = 0; i < MAX_LOG_CATEGORIES; ++i)
     {
-        s.resize(size);
-        va_start(marker, fmt);
-        n = vsnprintf((char*)s.c_str(), size, fmt, marker);
-        va_end(marker);
-        if ((n>0) && ((b=(n<size))==true)) s.resize(n); else size*=2;
+        if (name == CategoryNames[i])
+        {
+            category = LogCategory(i);
+            return true;
+        }
     }
 
-    out(prio, s);
+    return false;
+}
+
+/**
+ * Sets the size of the buffer of each thread, for threads which have not
+ * logged yet
+ *
+ * @param size Size in bytes, lines logged while it is full are dropped
+ */
+void Log::setBufferSize(Poco::UInt32 size)
+{
+    Poco::FastMutex::ScopedLock lock(_buffersMutex);
+    _bufferSize = size;
 }
 
-void Log::out(Message::Priority prio, std::string msg)
+LogBuffer* Log::createBuffer()
 {
-    if (prio > _logger.getLevel())
+    Poco::FastMutex::ScopedLock lock(_buffersMutex);
+    LogBuffer* buffer = new LogBuffer(_bufferSize);
+    _buffers.push_back(buffer);
+    return buffer;
+}
+
+/**
+ * Log thread, writes the lines queued by each thread, and frees the
+ * buffers of the threads which have finished
+ */
+void Log::run()
+{
+    do
+    {
+        _wakeUp.tryWait(LOG_WRITE_INTERVAL);
+
+        std::vector<LogBuffer*> buffers;
+        {
+            Poco::FastMutex::ScopedLock lock(_buffersMutex);
+            buffers = _buffers;
+        }
+
+        std::vector<LogBuffer*> finished;
+        for (std::vector<LogBuffer*>::iterator itr = buffers.begin(); itr != buffers.end(); ++itr)
+            if (writeBuffer(*itr))
+                finished.push_back(*itr);
+
+        if (!finished.empty())
+        {
+            Poco::FastMutex::ScopedLock lock(_buffersMutex);
+            for (std::vector<LogBuffer*>::iterator itr = finished.begin(); itr != finished.end(); ++itr)
+            {
+                _buffers.erase(std::find(_buffers.begin(), _buffers.end(), *itr));
+                delete *itr;
+            }
+        }
+    }
+    while (_running);
+}
+
+/**
+ * Writes all the lines queued on a buffer
+ *
+ * @param buffer Buffer of a thread
+ * @return true if its thread has finished, and it can be freed
+ */
+bool Log::writeBuffer(LogBuffer* buffer)
+{
+    // Closed before the last lines are read, so none is left behind
+    bool closed = buffer->isClosed();
+
+    while (const LogRecord* record = buffer->front())
+    {
+        writeRecord(record);
+        buffer->pop(record);
+    }
+
+    if (Poco::UInt32 dropped = buffer->takeDropped())
+        _logger.warning(Poco::NumberFormatter::format(dropped) + " log lines were dropped, LogBufferSize is too small");
+
+    return closed;
+}
+
+/**
+ * Appends a formatted argument
+ *
+ * @param text Line being formatted
+ * @param spec Conversion specification, a single one
+ * @param value Argument, of the type it was given as
+ */
+template <typename T>
+static void appendFormatted(std::string& text, const char* spec, T value)
+{
+    char buffer[128];
+    int length = snprintf(buffer, sizeof(buffer), spec, value);
+    if (length < 0)
         return;
 
-    switch (prio)
+    if (length < (int)sizeof(buffer))
     {
-        case Message::PRIO_CRITICAL:
-            _logger.critical(msg);
-            break;
+        text.append(buffer, length);
+        return;
+    }
 
-        case Message::PRIO_DEBUG:
-            _logger.debug(msg);
-            break;
+    size_t start = text.size();
+    text.resize(start + length + 1);
+    snprintf(&text[start], length + 1, spec, value);
+    text.resize(start + length);
+}
 
-        case Message::PRIO_ERROR:
-            _logger.error(msg);
-            break;
+template <typename T>
+static const char* appendValue(std::string& text, const char* spec, const char* argument)
+{
+    T value;
+    memcpy(&value, argument, sizeof(T));
+    appendFormatted(text, spec, value);
+    return argument + sizeof(T);
+}
 
-        case Message::PRIO_FATAL:
-            _logger.fatal(msg);
-            break;
+/**
+ * Formats the next argument of a record
+ *
+ * @param text Line being formatted
+ * @param spec Conversion specification of the argument
+ * @param argument Argument type and value
+ * @return The following argument
+ */
+static const char* appendArgument(std::string& text, const char* spec, const char* argument)
+{
+    switch (*argument++)
+    {
+        case LogRecord::TYPE_INT:
+            return appendValue<int>(text, spec, argument);
 
-        case Message::PRIO_INFORMATION:
-            _logger.information(msg);
-            break;
+        case LogRecord::TYPE_UINT:
+            return appendValue<unsigned int>(text, spec, argument);
 
-        case Message::PRIO_NOTICE:
-            _logger.notice(msg);
-            break;
+        case LogRecord::TYPE_LONG:
+            return appendValue<long>(text, spec, argument);
 
-        case Message::PRIO_TRACE:
-            _logger.trace(msg);
-            break;
+        case LogRecord::TYPE_ULONG:
+            return appendValue<unsigned long>(text, spec, argument);
+
+        case LogRecord::TYPE_LONG_LONG:
+            return appendValue<long long>(text, spec, argument);
+
+        case LogRecord::TYPE_ULONG_LONG:
+            return appendValue<unsigned long long>(text, spec, argument);
+
+        case LogRecord::TYPE_DOUBLE:
+            return appendValue<double>(text, spec, argument);
+
+        case LogRecord::TYPE_POINTER:
+            return appendValue<const void*>(text, spec, argument);
+
+        case LogRecord::TYPE_STRING:
+        {
+            Poco::UInt32 length;
+            memcpy(&length, argument, sizeof(length));
+            argument += sizeof(length);
 
-        case Message::PRIO_WARNING:
-            _logger.trace(msg);
+            if (!strcmp(spec, "%s"))
+                text.append(argument, length);
+            else
+                appendFormatted(text, spec, argument);
+
+            return argument + length + 1;
+        }
+    }
+
+    return argument;
+}
+
+/**
+ * Formats a record, as printf would have, and writes it
+ *
+ * @param record Queued line
+ */
+void Log::writeRecord(const LogRecord* record)
+{
+    std::string text;
+    const char* format = record->format;
+    const char* argument = (const char*)(record + 1);
+    Poco::UInt8 remaining = record->arguments;
+    char spec[32];
+
+    while (*format)
+    {
+        if (*format != '%')
+        {
+            const char* start = format;
+            while (*format && *format != '%')
+                ++format;
+
+            text.append(start, format);
+            continue;
+        }
+
+        if (format[1] == '%')
+        {
+            text += '%';
+            format += 2;
+            continue;
+        }
+
+        const char* start = format++;
+        while (*format && strchr("-+ #0123456789.hlLqjzt", *format))
+            ++format;
+
+        if (!*format)
+        {
+            text.append(start);
             break;
+        }
+
+        ++format;
+        size_t length = format - start;
+
+        // Conversions printf would not make sense of are left as they are
+        if (!remaining || length >= sizeof(spec) || !strchr("diouxXeEfFgGaAcsp", format[-1]))
+        {
+            text.append(start, format);
+            continue;
+        }
+
+        memcpy(spec, start, length);
+        spec[length] = '\0';
+
+        argument = appendArgument(text, spec, argument);
+        --remaining;
     }
+
+    Message message(_logger.name(), text, Message::Priority(record->priority));
+    message.setTime(Poco::Timestamp(record->time));
+    _logger.log(message);
 }
@@ -1,38 +1,209 @@
 #ifndef GAMESERVER_LOG_H
 #define GAMESERVER_LOG_H
 
+#include <atomic>
+#include <string>
+#include <vector>
+
 #include "Poco/Poco.h"
-#include "Poco/SingletonHolder.h"
 #include "Poco/Logger.h"
 #include "Poco/Message.h"
 #include "Poco/NumberFormatter.h"
+#include "Poco/Event.h"
+#include "Poco/Mutex.h"
+#include "Poco/RunnableAdapter.h"
+#include "Poco/Thread.h"
+#include "Poco/ThreadLocal.h"
+#include "Poco/Timestamp.h"
+
+#include "LogBuffer.h"
 
 using Poco::Logger;
 using Poco::Message;
 
+enum LogCategory
+{
+    LOG_SERVER,
+    LOG_NET,
+    LOG_GRID,
+    LOG_DB,
+    LOG_AI,
+    MAX_LOG_CATEGORIES,
+};
+
+//@ Least important priority compiled in, lines past it are removed along
+//@ with their arguments. WITH_DEBUG_LOG=OFF sets it to 6 (information)
+#ifndef LOG_MAX_PRIORITY
+    #define LOG_MAX_PRIORITY 8
+#endif
+
+/**
+ * Lines are not formatted by the thread logging them: it only copies the
+ * format string pointer and the raw arguments to a buffer of its own, and
+ * the log thread formats and writes them. The format string must therefore
+ * be a literal, and arguments are limited to what printf takes (numbers,
+ * C strings and pointers, no '*' widths)
+ */
 class Log
 {
 public:
     Log();
     ~Log();
+    // Not a SingletonHolder, which locks on every access: every line goes
+    // through here, even those filtered out
     static Log& instance()
     {
-        static Poco::SingletonHolder<Log> sh;
-        return *sh.get();
+        static Log log;
+        return log;
+    }
+
+    template <typename... Args>
+    inline void out(Message::Priority prio, const char* fmt, Args... args)
+    {
+        out(LOG_SERVER, prio, fmt, args...);
+    }
+
+    template <typename... Args>
+    void out(LogCategory category, Message::Priority prio, const char* fmt, Args... args)
+    {
+        if (!isEnabled(category, prio))
+            return;
+
+        if (Poco::Thread::current())
+        {
+            write(getBuffer(), prio, fmt, args...);
+        }
+        else if (Poco::Thread::currentTid() == _mainThread)
+        {
+            write(_mainBuffer, prio, fmt, args...);
+        }
+        else
+        {
+            Poco::FastMutex::ScopedLock lock(_sharedMutex);
+            write(_sharedBuffer, prio, fmt, args...);
+        }
+
+        // Errors are written right away, the rest on the next interval
+        if (prio <= Message::PRIO_ERROR)
+            _wakeUp.set();
+    }
+
+    inline void out(Message::Priority prio, std::string msg)
+    {
+        out(prio, "%s", msg.c_str());
     }
 
-    void out(Message::Priority prio, const char* fmt, ...);
-    void out(Message::Priority prio, std::string msg);
+    inline bool isEnabled(LogCategory category, Message::Priority prio)
+    {
+        return prio <= _levels[category].load(std::memory_order_relaxed);
+    }
 
     inline void setLogLevel(Message::Priority prio)
     {
-        _logger.setLevel(prio);
+        for (Poco::UInt8 i = 0; i < MAX_LOG_CATEGORIES; ++i)
+            _levels[i] = prio;
+    }
+
+    inline void setLogLevel(LogCategory category, Message::Priority prio)
+    {
+        _levels[category] = prio;
     }
 
+    inline Message::Priority getLogLevel(LogCategory category)
+    {
+        return Message::Priority(_levels[category].load(std::memory_order_relaxed));
+    }
+
+    static const char* getCategoryName(LogCategory category);
+    static bool findCategory(const std::string& name, LogCategory& category);
+
+    void setBufferSize(Poco::UInt32 size);
+
+private:
+    struct BufferOwner
+    {
+        BufferOwner():
+            buffer(NULL)
+        {}
+
+        ~BufferOwner()
+        {
+            if (buffer)
+                buffer->close();
+        }
+
+        LogBuffer* buffer;
+    };
+
+    template <typename... Args>
+    inline void write(LogBuffer* buffer, Message::Priority prio, const char* fmt, Args... args)
+    {
+        Poco::UInt32 size = LogRecord::recordSize(args...);
+        char* data = buffer->reserve(size);
+        if (!data)
+        {
+            buffer->drop();
+            return;
+        }
+
+        LogRecord* record = (LogRecord*)data;
+        record->size = size;
+        record->priority = (Poco::UInt8)prio;
+        record->arguments = (Poco::UInt8)sizeof...(Args);
+        record->format = fmt;
+        record->time = Poco::Timestamp().epochMicroseconds();
+        LogRecord::writeArguments(data + sizeof(LogRecord), args...);
+
+        buffer->commit();
+    }
+
+    inline LogBuffer* getBuffer()
+    {
+        BufferOwner& owner = _buffer.get();
+        if (!owner.buffer)
+            owner.buffer = createBuffer();
+
+        return owner.buffer;
+    }
+
+    LogBuffer* createBuffer();
+
+    void run();
+    bool writeBuffer(LogBuffer* buffer);
+    void writeRecord(const LogRecord* record);
+
 private:
     Logger& _logger;
+    std::atomic<int> _levels[MAX_LOG_CATEGORIES];
+
+    Poco::ThreadLocal<BufferOwner> _buffer;
+    Poco::Thread::TID _mainThread;
+    LogBuffer* _mainBuffer;
+    LogBuffer* _sharedBuffer;
+    Poco::FastMutex _sharedMutex;
+
+    std::vector<LogBuffer*> _buffers;
+    Poco::UInt32 _bufferSize;
+    Poco::FastMutex _buffersMutex;
+
+    std::atomic<bool> _running;
+    Poco::Event _wakeUp;
+    Poco::Thread _thread;
+    Poco::RunnableAdapter<Log> _writer;
 };
 
 #define sLog Log::instance()
 
-#endif
\ No newline at end of file
+/**
+ * Logs a line of a category, its arguments are only evaluated if the line
+ * is logged, and the whole call is compiled out past LOG_MAX_PRIORITY
+ */
+#define LOG_OUT(category, prio, ...) \
+    do \
+    { \
+        if ((prio) <= LOG_MAX_PRIORITY && sLog.isEnabled(category, prio)) \
+            sLog.out(category, prio, __VA_ARGS__); \
+    } \
+    while (0)
+
+#endif
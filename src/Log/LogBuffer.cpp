@@ -0,0 +1,52 @@
+#include "LogBuffer.h"
+
+#define LOG_BUFFER_MIN_CAPACITY 4096
+
+/**
+ * @param capacity Size in bytes, rounded up to a power of two
+ */
+LogBuffer::LogBuffer(Poco::UInt32 capacity):
+    _capacity(LOG_BUFFER_MIN_CAPACITY), _head(0), _tail(0), _reserved(0), _dropped(0), _closed(false)
+{
+    while (_capacity < capacity && _capacity < 0x80000000)
+        _capacity <<= 1;
+
+    _mask = _capacity - 1;
+    _data = (char*)new Poco::UInt64[_capacity / sizeof(Poco::UInt64)];
+}
+
+LogBuffer::~LogBuffer()
+{
+    delete [] (Poco::UInt64*)_data;
+}
+
+/**
+ * Called from the log thread only
+ *
+ * @return The oldest record, or NULL if there is none
+ */
+const LogRecord* LogBuffer::front()
+{
+    Poco::UInt64 tail = _tail.load(std::memory_order_relaxed);
+    while (tail != _head.load(std::memory_order_acquire))
+    {
+        const LogRecord* record = (const LogRecord*)(_data + (tail & _mask));
+        if (record->priority)
+            return record;
+
+        tail += record->size;
+        _tail.store(tail, std::memory_order_release);
+    }
+
+    return NULL;
+}
+
+/**
+ * Frees the oldest record, called from the log thread only
+ *
+ * @param record Record returned by front
+ */
+void LogBuffer::pop(const LogRecord* record)
+{
+    _tail.store(_tail.load(std::memory_order_relaxed) + record->size, std::memory_order_release);
+}
@@ -0,0 +1,193 @@
+#ifndef GAMESERVER_LOG_BUFFER_H
+#define GAMESERVER_LOG_BUFFER_H
+
+#include <atomic>
+#include <cstring>
+
+#include "Poco/Poco.h"
+#include "Poco/Timestamp.h"
+
+/**
+ * A log line as it is queued: the format string, which must outlive the
+ * server (a literal), followed by its arguments, each one a type byte and
+ * its raw value. Strings are copied, with their length and terminator
+ */
+struct LogRecord
+{
+    enum
+    {
+        ALIGNMENT = 8,
+    };
+
+    enum Type
+    {
+        TYPE_INT,
+        TYPE_UINT,
+        TYPE_LONG,
+        TYPE_ULONG,
+        TYPE_LONG_LONG,
+        TYPE_ULONG_LONG,
+        TYPE_DOUBLE,
+        TYPE_STRING,
+        TYPE_POINTER,
+    };
+
+    // Size of the record, padding included; a priority of 0 marks the
+    // padding left at the end of the buffer
+    Poco::UInt32 size;
+    Poco::UInt8 priority;
+    Poco::UInt8 arguments;
+    const char* format;
+    Poco::Timestamp::TimeVal time;
+
+    // Arguments take the type they would be promoted to on a vararg call
+    static inline Poco::UInt32 argumentSize(int) { return 1 + sizeof(int); }
+    static inline Poco::UInt32 argumentSize(unsigned int) { return 1 + sizeof(unsigned int); }
+    static inline Poco::UInt32 argumentSize(long) { return 1 + sizeof(long); }
+    static inline Poco::UInt32 argumentSize(unsigned long) { return 1 + sizeof(unsigned long); }
+    static inline Poco::UInt32 argumentSize(long long) { return 1 + sizeof(long long); }
+    static inline Poco::UInt32 argumentSize(unsigned long long) { return 1 + sizeof(unsigned long long); }
+    static inline Poco::UInt32 argumentSize(double) { return 1 + sizeof(double); }
+    static inline Poco::UInt32 argumentSize(const void*) { return 1 + sizeof(const void*); }
+
+    static inline Poco::UInt32 argumentSize(const char* value)
+    {
+        return 1 + sizeof(Poco::UInt32) + (Poco::UInt32)strlen(value ? value : "(null)") + 1;
+    }
+
+    static inline char* writeArgument(char* data, int value) { return writeValue(data, TYPE_INT, value); }
+    static inline char* writeArgument(char* data, unsigned int value) { return writeValue(data, TYPE_UINT, value); }
+    static inline char* writeArgument(char* data, long value) { return writeValue(data, TYPE_LONG, value); }
+    static inline char* writeArgument(char* data, unsigned long value) { return writeValue(data, TYPE_ULONG, value); }
+    static inline char* writeArgument(char* data, long long value) { return writeValue(data, TYPE_LONG_LONG, value); }
+    static inline char* writeArgument(char* data, unsigned long long value) { return writeValue(data, TYPE_ULONG_LONG, value); }
+    static inline char* writeArgument(char* data, double value) { return writeValue(data, TYPE_DOUBLE, value); }
+    static inline char* writeArgument(char* data, const void* value) { return writeValue(data, TYPE_POINTER, value); }
+
+    static inline char* writeArgument(char* data, const char* value)
+    {
+        if (!value)
+            value = "(null)";
+
+        Poco::UInt32 length = (Poco::UInt32)strlen(value);
+        data = writeValue(data, TYPE_STRING, length);
+        memcpy(data, value, length + 1);
+        return data + length + 1;
+    }
+
+    template <typename T>
+    static inline char* writeValue(char* data, Poco::UInt8 type, T value)
+    {
+        *data = (char)type;
+        memcpy(data + 1, &value, sizeof(T));
+        return data + 1 + sizeof(T);
+    }
+
+    static inline Poco::UInt32 argumentsSize()
+    {
+        return 0;
+    }
+
+    template <typename T, typename... Args>
+    static inline Poco::UInt32 argumentsSize(T value, Args... args)
+    {
+        return argumentSize(value) + argumentsSize(args...);
+    }
+
+    static inline void writeArguments(char*)
+    {
+    }
+
+    template <typename T, typename... Args>
+    static inline void writeArguments(char* data, T value, Args... args)
+    {
+        writeArguments(writeArgument(data, value), args...);
+    }
+
+    template <typename... Args>
+    static inline Poco::UInt32 recordSize(Args... args)
+    {
+        return (sizeof(LogRecord) + argumentsSize(args...) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+};
+
+/**
+ * Ring of log records written by a single thread and read by the log
+ * thread, without locking. Records never wrap around the end, the space
+ * left there is skipped. When it is full, records are dropped and counted
+ * rather than waiting for the log thread
+ */
+class LogBuffer
+{
+public:
+    LogBuffer(Poco::UInt32 capacity);
+    ~LogBuffer();
+
+    /**
+     * Reserves room for a record, to be published with commit
+     *
+     * @param size Record size, aligned
+     * @return Where the record goes, or NULL if the buffer is full
+     */
+    inline char* reserve(Poco::UInt32 size)
+    {
+        Poco::UInt64 head = _head.load(std::memory_order_relaxed);
+        Poco::UInt32 offset = Poco::UInt32(head & _mask);
+        Poco::UInt32 contiguous = _capacity - offset;
+        Poco::UInt32 needed = size > contiguous ? contiguous + size : size;
+
+        if (head + needed - _tail.load(std::memory_order_acquire) > _capacity)
+            return NULL;
+
+        if (size > contiguous)
+        {
+            LogRecord* padding = (LogRecord*)(_data + offset);
+            padding->size = contiguous;
+            padding->priority = 0;
+            offset = 0;
+        }
+
+        _reserved = head + needed;
+        return _data + offset;
+    }
+
+    inline void commit()
+    {
+        _head.store(_reserved, std::memory_order_release);
+    }
+
+    inline void drop()
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline Poco::UInt32 takeDropped()
+    {
+        return _dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    inline void close()
+    {
+        _closed.store(true, std::memory_order_release);
+    }
+
+    inline bool isClosed()
+    {
+        return _closed.load(std::memory_order_acquire);
+    }
+
+    const LogRecord* front();
+    void pop(const LogRecord* record);
+
+private:
+    char* _data;
+    Poco::UInt32 _capacity;
+    Poco::UInt32 _mask;
+    std::atomic<Poco::UInt64> _head;
+    std::atomic<Poco::UInt64> _tail;
+    Poco::UInt64 _reserved;
+    std::atomic<Poco::UInt32> _dropped;
+    std::atomic<bool> _closed;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+#define TRACE_BUFFER_MIN_CAPACITY 1024
+#define TRACE_DEFAULT_BUFFER_SIZE 65536
+
+/**
+ * @param capacity Number of events, rounded up to a power of two
+ * @param id Identifier of the thread in the dumps
+ * @param threadName Name of the thread
+ */
+TraceBuffer::TraceBuffer(Poco::UInt32 capacity, Poco::UInt32 id, const std::string& threadName):
+    _capacity(TRACE_BUFFER_MIN_CAPACITY), _head(0), _id(id), _threadName(threadName), _closed(false)
+{
+    while (_capacity < capacity && _capacity < 0x80000000)
+        _capacity <<= 1;
+
+    _mask = _capacity - 1;
+    _events = new TraceEvent[_capacity];
+}
+
+TraceBuffer::~TraceBuffer()
+{
+    delete [] _events;
+}
+
+/**
+ * Copies the events which ended after a given time, while the thread keeps
+ * tracing. Events the thread may have overwritten meanwhile are dropped
+ *
+ * @param since Oldest end time copied
+ * @param events Where the events are appended, oldest first
+ */
+void TraceBuffer::copy(Poco::Timestamp::TimeVal since, std::vector<TraceEvent>& events)
+{
+    Poco::UInt64 head = _head.load(std::memory_order_acquire);
+    Poco::UInt64 first = head > _capacity ? head - _capacity : 0;
+    size_t start = events.size();
+
+    std::vector<Poco::UInt64> indexes;
+    for (Poco::UInt64 i = first; i < head; ++i)
+    {
+        const TraceEvent& event = _events[i & _mask];
+        if (event.begin + event.duration < since)
+            continue;
+
+        events.push_back(event);
+        indexes.push_back(i);
+    }
+
+    // The slot of the event being written is not safe either, hence the +1
+    std::atomic_thread_fence(std::memory_order_acquire);
+    Poco::UInt64 current = _head.load(std::memory_order_relaxed);
+    Poco::UInt64 valid = current >= _capacity ? current - _capacity + 1 : 0;
+
+    size_t stale = std::lower_bound(indexes.begin(), indexes.end(), valid) - indexes.begin();
+    events.erase(events.begin() + start, events.begin() + start + stale);
+}
+
+Trace::Trace():
+    _enabled(true),
+    _mainThread(Poco::Thread::currentTid()),
+    _mainBuffer(NULL),
+    _bufferSize(TRACE_DEFAULT_BUFFER_SIZE),
+    _nextId(1)
+{
+}
+
+Trace::~Trace()
+{
+    // Buffers of threads still running are left to them
+    for (std::vector<TraceBuffer*>::iterator itr = _buffers.begin(); itr != _buffers.end(); ++itr)
+        if (*itr == _mainBuffer || (*itr)->isClosed())
+            delete *itr;
+}
+
+/**
+ * Sets the number of events kept for each thread, for threads which have
+ * not traced yet
+ *
+ * @param events Events kept, 0 disables tracing
+ */
+void Trace::setBufferSize(Poco::UInt32 events)
+{
+    Poco::FastMutex::ScopedLock lock(_buffersMutex);
+    _bufferSize = events;
+    _enabled = events != 0;
+}
+
+TraceBuffer* Trace::createBuffer(const std::string& threadName)
+{
+    Poco::FastMutex::ScopedLock lock(_buffersMutex);
+    TraceBuffer* buffer = new TraceBuffer(_bufferSize, _nextId++, threadName);
+    _buffers.push_back(buffer);
+    return buffer;
+}
+
+static std::string escapeJSON(const std::string& text)
+{
+    std::string escaped;
+    for (std::string::const_iterator itr = text.begin(); itr != text.end(); ++itr)
+    {
+        if (*itr == '"' || *itr == '\\')
+            escaped += '\\';
+        else if ((unsigned char)*itr < 0x20)
+            continue;
+
+        escaped += *itr;
+    }
+
+    return escaped;
+}
+
+/**
+ * Writes the last spans traced by every thread, as Chrome trace_event
+ * JSON (chrome://tracing or Perfetto open it). The buffers of the threads
+ * which have finished are freed once written
+ *
+ * @param seconds How far back to go
+ * @param path File written
+ * @param written Number of spans written
+ * @return false if the file can not be written
+ */
+bool Trace::dump(Poco::UInt32 seconds, const std::string& path, Poco::UInt32& written)
+{
+    Poco::FastMutex::ScopedLock dumpLock(_dumpMutex);
+
+    written = 0;
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    std::vector<TraceBuffer*> buffers;
+    {
+        Poco::FastMutex::ScopedLock lock(_buffersMutex);
+        buffers = _buffers;
+    }
+
+    Poco::Timestamp::TimeVal since = Poco::Timestamp().epochMicroseconds() - (Poco::Timestamp::TimeDiff)seconds * 1000000;
+    std::vector<TraceBuffer*> finished;
+    std::vector<TraceEvent> events;
+    const char* separator = "";
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    for (std::vector<TraceBuffer*>::iterator itr = buffers.begin(); itr != buffers.end(); ++itr)
+    {
+        TraceBuffer* buffer = *itr;
+
+        // Closed before its last events are read, so none is left behind
+        if (buffer->isClosed())
+            finished.push_back(buffer);
+
+        events.clear();
+        buffer->copy(since, events);
+        if (events.empty())
+            continue;
+
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            separator, buffer->getId(), escapeJSON(buffer->getThreadName()).c_str());
+        separator = ",";
+
+        for (std::vector<TraceEvent>::iterator event = events.begin(); event != events.end(); ++event)
+        {
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"tick\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%lld,\"dur\":%lld}",
+                event->name, buffer->getId(), (long long)event->begin, (long long)event->duration);
+        }
+
+        written += (Poco::UInt32)events.size();
+    }
+
+    fprintf(file, "\n]}\n");
+    bool ok = !ferror(file);
+    fclose(file);
+
+    if (!finished.empty())
+    {
+        Poco::FastMutex::ScopedLock lock(_buffersMutex);
+        for (std::vector<TraceBuffer*>::iterator itr = finished.begin(); itr != finished.end(); ++itr)
+        {
+            _buffers.erase(std::find(_buffers.begin(), _buffers.end(), *itr));
+            delete *itr;
+        }
+    }
+
+    return ok;
+}
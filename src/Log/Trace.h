@@ -0,0 +1,208 @@
+#ifndef GAMESERVER_TRACE_H
+#define GAMESERVER_TRACE_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "Poco/Poco.h"
+#include "Poco/Mutex.h"
+#include "Poco/Thread.h"
+#include "Poco/ThreadLocal.h"
+#include "Poco/Timestamp.h"
+
+//@ Whether trace scopes are compiled in, WITH_TRACE=OFF sets it to 0
+#ifndef TRACE_ENABLED
+    #define TRACE_ENABLED 1
+#endif
+
+/**
+ * A traced span: its name, which must outlive the server (a literal), when
+ * it began and how long it took, in microseconds
+ */
+struct TraceEvent
+{
+    const char* name;
+    Poco::Timestamp::TimeVal begin;
+    Poco::Timestamp::TimeDiff duration;
+};
+
+/**
+ * Ring of the last events traced by a single thread. Unlike the log
+ * buffers nothing consumes it: the oldest events are overwritten, and a
+ * dump copies whatever is there, leaving out the events overwritten while
+ * it was copying
+ */
+class TraceBuffer
+{
+public:
+    TraceBuffer(Poco::UInt32 capacity, Poco::UInt32 id, const std::string& threadName);
+    ~TraceBuffer();
+
+    inline void record(const char* name, Poco::Timestamp::TimeVal begin, Poco::Timestamp::TimeDiff duration)
+    {
+        Poco::UInt64 head = _head.load(std::memory_order_relaxed);
+        TraceEvent& event = _events[head & _mask];
+        event.name = name;
+        event.begin = begin;
+        event.duration = duration;
+        _head.store(head + 1, std::memory_order_release);
+    }
+
+    inline void close()
+    {
+        _closed.store(true, std::memory_order_release);
+    }
+
+    inline bool isClosed()
+    {
+        return _closed.load(std::memory_order_acquire);
+    }
+
+    inline Poco::UInt32 getId()
+    {
+        return _id;
+    }
+
+    inline const std::string& getThreadName()
+    {
+        return _threadName;
+    }
+
+    void copy(Poco::Timestamp::TimeVal since, std::vector<TraceEvent>& events);
+
+private:
+    TraceEvent* _events;
+    Poco::UInt32 _capacity;
+    Poco::UInt32 _mask;
+    std::atomic<Poco::UInt64> _head;
+    Poco::UInt32 _id;
+    std::string _threadName;
+    std::atomic<bool> _closed;
+};
+
+/**
+ * Keeps the last spans traced by each thread, so that a slow tick can be
+ * looked at after it happened. Tracing a span takes two clock reads and a
+ * write to the thread ring, nothing is formatted until it is dumped
+ */
+class Trace
+{
+public:
+    Trace();
+    ~Trace();
+
+    // Not a SingletonHolder, which locks on every access: spans are
+    // traced from every grid thread, many times per tick
+    static Trace& instance()
+    {
+        static Trace trace;
+        return trace;
+    }
+
+    inline bool isEnabled()
+    {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    inline void record(const char* name, Poco::Timestamp::TimeVal begin, Poco::Timestamp::TimeDiff duration)
+    {
+        if (TraceBuffer* buffer = getBuffer())
+            buffer->record(name, begin, duration);
+    }
+
+    void setBufferSize(Poco::UInt32 events);
+    bool dump(Poco::UInt32 seconds, const std::string& path, Poco::UInt32& written);
+
+private:
+    struct BufferOwner
+    {
+        BufferOwner():
+            buffer(NULL)
+        {}
+
+        ~BufferOwner()
+        {
+            if (buffer)
+                buffer->close();
+        }
+
+        TraceBuffer* buffer;
+    };
+
+    inline TraceBuffer* getBuffer()
+    {
+        if (Poco::Thread* thread = Poco::Thread::current())
+        {
+            BufferOwner& owner = _buffer.get();
+            if (!owner.buffer)
+                owner.buffer = createBuffer(thread->name());
+
+            return owner.buffer;
+        }
+
+        // Threads not started by Poco share a single storage, only the
+        // main one is traced
+        if (Poco::Thread::currentTid() != _mainThread)
+            return NULL;
+
+        if (!_mainBuffer)
+            _mainBuffer = createBuffer("Main");
+
+        return _mainBuffer;
+    }
+
+    TraceBuffer* createBuffer(const std::string& threadName);
+
+private:
+    std::atomic<bool> _enabled;
+
+    Poco::ThreadLocal<BufferOwner> _buffer;
+    Poco::Thread::TID _mainThread;
+    TraceBuffer* _mainBuffer;
+
+    std::vector<TraceBuffer*> _buffers;
+    Poco::UInt32 _bufferSize;
+    Poco::UInt32 _nextId;
+    Poco::FastMutex _buffersMutex;
+    Poco::FastMutex _dumpMutex;
+};
+
+#define sTrace Trace::instance()
+
+/**
+ * Traces a span from where it is declared to the end of its scope
+ */
+class TraceScope
+{
+public:
+    inline TraceScope(const char* name):
+        _name(name),
+        _begin(sTrace.isEnabled() ? Poco::Timestamp().epochMicroseconds() : 0)
+    {}
+
+    inline ~TraceScope()
+    {
+        if (_begin)
+            sTrace.record(_name, _begin, Poco::Timestamp().epochMicroseconds() - _begin);
+    }
+
+private:
+    const char* _name;
+    Poco::Timestamp::TimeVal _begin;
+};
+
+#define TRACE_CONCAT_I(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_I(a, b)
+
+/**
+ * Traces the rest of the enclosing scope under a name, which must be a
+ * literal. The whole call is compiled out when TRACE_ENABLED is 0
+ */
+#if TRACE_ENABLED
+    #define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+    #define TRACE_SCOPE(name) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+#include "GuidAllocator.h"
+#include "ObjectManager.h"
+
+//@ The free stack head is (tag << 32) | GUID, tag avoids the ABA problem
+#define HEAD_GUID(h) Poco::UInt32( (h) & 0xFFFFFFFF )
+#define HEAD_TAG(h) Poco::UInt32( (h) >> 32 )
+#define MAKE_HEAD(tag, guid) ( ((Poco::UInt64)(tag) << 32) | (guid) )
+
+GuidAllocator::GuidAllocator():
+    _next(1),
+    _freeHead(0)
+{
+    _chunks = new std::atomic<Link*>[MAX_CHUNKS];
+    for (Poco::UInt32 i = 0; i < MAX_CHUNKS; ++i)
+        _chunks[i].store(NULL, std::memory_order_relaxed);
+}
+
+GuidAllocator::~GuidAllocator()
+{
+    for (Poco::UInt32 i = 0; i < MAX_CHUNKS; ++i)
+        delete [] _chunks[i].load(std::memory_order_relaxed);
+
+    delete [] _chunks;
+}
+
+/**
+ * Allocates a new low GUID, GUID 0 is never returned
+ *
+ * @return The GUID, or ObjectManager::MAX_GUID if there are none left
+ */
+Poco::UInt32 GuidAllocator::allocate()
+{
+    Poco::UInt32 GUID;
+    if (pop(GUID))
+        return GUID;
+
+    Block& block = _block.get();
+    if (block.next == block.end)
+    {
+        Poco::UInt64 start = _next.fetch_add(BLOCK_SIZE, std::memory_order_relaxed);
+        if (start + BLOCK_SIZE > ObjectManager::MAX_GUID)
+            return ObjectManager::MAX_GUID;
+
+        block.next = start;
+        block.end = start + BLOCK_SIZE;
+    }
+
+    return (Poco::UInt32)block.next++;
+}
+
+/**
+ * Gives back a GUID, it must not be referenced anymore
+ *
+ * @param GUID GUID to be reused
+ */
+void GuidAllocator::release(Poco::UInt32 GUID)
+{
+    Link& next = link(GUID);
+
+    Poco::UInt64 head = _freeHead.load(std::memory_order_relaxed);
+    Poco::UInt64 newHead;
+    do
+    {
+        next.store(HEAD_GUID(head), std::memory_order_relaxed);
+        newHead = MAKE_HEAD(HEAD_TAG(head) + 1, GUID);
+    }
+    while (!_freeHead.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+}
+
+bool GuidAllocator::pop(Poco::UInt32& GUID)
+{
+    Poco::UInt64 head = _freeHead.load(std::memory_order_acquire);
+    while (HEAD_GUID(head) != 0)
+    {
+        // The link might be stale if another thread pops it first, but then
+        // the tag has changed and the exchange fails
+        Poco::UInt32 next = link(HEAD_GUID(head)).load(std::memory_order_relaxed);
+        if (_freeHead.compare_exchange_weak(head, MAKE_HEAD(HEAD_TAG(head) + 1, next), std::memory_order_acquire, std::memory_order_acquire))
+        {
+            GUID = HEAD_GUID(head);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Next pointer of a GUID on the free stack. Links are stored in chunks
+ * indexed by GUID, allocated the first time a GUID on them is released
+ * and never freed until the allocator is destroyed
+ *
+ * @param GUID GUID whose link is wanted
+ * @return The link
+ */
+GuidAllocator::Link& GuidAllocator::link(Poco::UInt32 GUID)
+{
+    std::atomic<Link*>& chunk = _chunks[GUID >> CHUNK_BITS];
+
+    Link* links = chunk.load(std::memory_order_acquire);
+    if (!links)
+    {
+        Link* created = new Link[CHUNK_SIZE];
+        if (chunk.compare_exchange_strong(links, created, std::memory_order_acq_rel, std::memory_order_acquire))
+            links = created;
+        else
+            delete [] created;
+    }
+
+    return links[GUID & (CHUNK_SIZE - 1)];
+}
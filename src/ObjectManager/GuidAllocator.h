@@ -0,0 +1,55 @@
+#ifndef GAMESERVER_GUID_ALLOCATOR_H
+#define GAMESERVER_GUID_ALLOCATOR_H
+
+#include <atomic>
+
+#include "Poco/Poco.h"
+#include "Poco/ThreadLocal.h"
+
+/**
+ * Hands out low GUIDs of a single type without taking any lock. Released
+ * GUIDs are kept on a tagged lock-free stack and reused first, otherwise
+ * each thread takes GUIDs from a block it reserved with a single atomic add.
+ * GUIDs left in the block of a finished thread are never used
+ */
+class GuidAllocator
+{
+public:
+    enum
+    {
+        BLOCK_SIZE = 64,
+        CHUNK_BITS = 16,
+        CHUNK_SIZE = 1 << CHUNK_BITS,
+        MAX_CHUNKS = 1 << (32 - CHUNK_BITS)
+    };
+
+    GuidAllocator();
+    ~GuidAllocator();
+
+    Poco::UInt32 allocate();
+    void release(Poco::UInt32 GUID);
+
+private:
+    struct Block
+    {
+        Block():
+            next(0), end(0)
+        {}
+
+        Poco::UInt64 next;
+        Poco::UInt64 end;
+    };
+
+    typedef std::atomic<Poco::UInt32> Link;
+
+    bool pop(Poco::UInt32& GUID);
+    Link& link(Poco::UInt32 GUID);
+
+private:
+    std::atomic<Poco::UInt64> _next;
+    std::atomic<Poco::UInt64> _freeHead;
+    std::atomic<Link*>* _chunks;
+    Poco::ThreadLocal<Block> _block;
+};
+
+#endif
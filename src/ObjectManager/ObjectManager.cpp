@@ -10,14 +10,28 @@ Poco::UInt32 ObjectManager::MAX_GUID = std::numeric_limits<Poco::UInt32>::max();
 
 ObjectManager::ObjectManager()
 {
-    _playersGUID = 1;
-    _creaturesGUID = 1;
-    _itemsGUID = 1;   
+    _playersPool = new ObjectPool<Player>(HIGH_GUID_PLAYER);
+    _creaturesPool = new ObjectPool<Creature>(HIGH_GUID_CREATURE);
 }
 
-SharedPtr<Object> ObjectManager::create(Poco::UInt32 highGUID)
+ObjectManager::~ObjectManager()
 {
-    SharedPtr<Object> object = NULL;
+    collect();
+
+    delete _playersPool;
+    delete _creaturesPool;
+}
+
+/**
+ * Creates an object of the given type
+ *
+ * @param highGUID Type of the object
+ * @return The object, valid until the next tick boundary
+ */
+Object* ObjectManager::create(Poco::UInt32 highGUID)
+{
+    Object* object = NULL;
+    ObjectHandle handle = INVALID_OBJECT_HANDLE;
     
     Poco::UInt32 lowGUID = newGUID(highGUID);
     if (lowGUID != MAX_GUID)
@@ -25,55 +39,68 @@ SharedPtr<Object> ObjectManager::create(Poco::UInt32 highGUID)
         switch (highGUID)
         {
             case HIGH_GUID_CREATURE:
-                object.assign(new Creature());
-                _creatures.insert(rde::make_pair(lowGUID, object));
+                if (void* memory = _creaturesPool->allocate(handle))
+                {
+                    object = new (memory) Creature();
+                    _creatures.insert(lowGUID, object);
+                }
                 break;
+        }
 
-            default:
-                return NULL;
+        if (!object)
+        {
+            freeGUID(MAKE_GUID(highGUID, lowGUID));
+            return NULL;
         }
 
         object->SetGUID(MAKE_GUID(highGUID, lowGUID));
+        object->SetHandle(handle);
     }
 
     return object;
 }
 
-SharedPtr<Player> ObjectManager::createPlayer(std::string name, Client* client)
+/**
+ * Creates a player
+ *
+ * @param name Name of the character
+ * @param client Client which controls it
+ * @return The player, valid until the next tick boundary
+ */
+Player* ObjectManager::createPlayer(std::string name, Client* client)
 {
-    SharedPtr<Object> object = NULL;
+    Player* player = NULL;
+    ObjectHandle handle = INVALID_OBJECT_HANDLE;
 
     Poco::UInt32 lowGUID = newGUID(HIGH_GUID_PLAYER);
     if (lowGUID != MAX_GUID)
     {
-        object.assign(new Player(name, client));
-        object->SetGUID(MAKE_GUID(HIGH_GUID_PLAYER, lowGUID));
+        void* memory = _playersPool->allocate(handle);
+        if (!memory)
+        {
+            freeGUID(MAKE_GUID(HIGH_GUID_PLAYER, lowGUID));
+            return NULL;
+        }
 
-        _players.insert(rde::make_pair(lowGUID, object));
+        player = new (memory) Player(name, client);
+        player->SetGUID(MAKE_GUID(HIGH_GUID_PLAYER, lowGUID));
+        player->SetHandle(handle);
+
+        _players.insert(lowGUID, player);
     }
 
-    return object.cast<Player>();
+    return player;
 }
 
-SharedPtr<Object> ObjectManager::getObject(Poco::UInt64 GUID)
+Object* ObjectManager::getObject(Poco::UInt64 GUID)
 {
     switch (HIGUID(GUID))
     {
         case HIGH_GUID_PLAYER:
-            {
-                ObjectsMap::iterator itr = _players.find(LOGUID(GUID));
-                if (itr != _players.end())
-                    return itr->second;
-            }
-            break;
+            return _players.find(LOGUID(GUID));
 
         case HIGH_GUID_CREATURE:
-            {
-                ObjectsMap::iterator itr = _creatures.find(LOGUID(GUID));
-                if (itr != _creatures.end())
-                    return itr->second;
-            }
-            break;
+            return _creatures.find(LOGUID(GUID));
 
         case HIGH_GUID_ITEM:
             break;
@@ -82,78 +109,120 @@ SharedPtr<Object> ObjectManager::getObject(Poco::UInt64 GUID)
     return NULL;
 }
 
+/**
+ * Resolves a pool handle, without any map lookup
+ *
+ * @param handle Handle of the object
+ * @return The object, or NULL if it has already been destroyed
+ */
+Object* ObjectManager::resolve(ObjectHandle handle)
+{
+    switch (HANDLE_TYPE(handle))
+    {
+        case HIGH_GUID_PLAYER:
+            return _playersPool->get(handle);
+
+        case HIGH_GUID_CREATURE:
+            return _creaturesPool->get(handle);
+    }
+
+    return NULL;
+}
+
+/**
+ * Unregisters an object, which must have already been removed from its grid.
+ * It is destroyed on the next collect
+ *
+ * @param GUID GUID of the object
+ */
 void ObjectManager::removeObject(Poco::UInt64 GUID)
 {
-    // An object removed from here should also be removed from grid
+    Object* object = NULL;
+
     switch (HIGUID(GUID))
     {
         case HIGH_GUID_PLAYER:
             //@todo: DB set guid = 0
-            _players.erase(LOGUID(GUID));
-            _freePlayers.insert(LOGUID(GUID));
+            object = _players.erase(LOGUID(GUID));
             break;
 
         case HIGH_GUID_CREATURE:
-            _creatures.erase(LOGUID(GUID));
-            _freeCreatures.insert(LOGUID(GUID));
+            object = _creatures.erase(LOGUID(GUID));
             break;
+    }
 
-        case HIGH_GUID_ITEM:
-            break;
+    if (!object)
+        return;
+
+    Poco::FastMutex::ScopedLock lock(_removedMutex);
+    _removed.push_back(object);
+}
+
+/**
+ * Destroys the objects removed since the last call and releases their
+ * GUIDs. Must only be called on a tick boundary, when no grid is updating
+ *
+ */
+void ObjectManager::collect()
+{
+    ObjectsList removed;
+    {
+        Poco::FastMutex::ScopedLock lock(_removedMutex);
+        removed.swap(_removed);
+    }
+
+    for (ObjectsList::iterator itr = removed.begin(); itr != removed.end(); ++itr)
+    {
+        Object* object = *itr;
+        Poco::UInt64 GUID = object->GetGUID();
+
+        switch (HIGUID(GUID))
+        {
+            case HIGH_GUID_PLAYER:
+                _playersPool->destroy(object->GetHandle());
+                break;
+
+            case HIGH_GUID_CREATURE:
+                _creaturesPool->destroy(object->GetHandle());
+                break;
+        }
+
+        // Only now the GUID can be reused, no event nor packet refers to it
+        freeGUID(GUID);
     }
 }
 
 Poco::UInt32 ObjectManager::newGUID(Poco::UInt32 highGUID)
 {
-    Poco::UInt32 GUID = MAX_GUID;
-
     switch (highGUID)
     {
         case HIGH_GUID_PLAYER:
-            _playersMutex.lock();
-            if (!_freePlayers.empty())
-            {
-                GUID = *(_freePlayers.begin());
-                _freePlayers.erase(GUID);
-            }
-            else if (_playersGUID != MAX_GUID)
-            {
-                GUID = _playersGUID;
-                _playersGUID++;
-            }
-            _playersMutex.unlock();
-            break;
+            return _playersGUID.allocate();
         
         case HIGH_GUID_CREATURE:
-            _creaturesMutex.lock();
-            if (!_freeCreatures.empty())
-            {
-                GUID = *(_freeCreatures.begin());
-                _freeCreatures.erase(GUID);
-            }
-            else if (_creaturesGUID != MAX_GUID)
-            {
-                GUID = _creaturesGUID;
-                _creaturesGUID++;
-            }
-            _creaturesMutex.unlock();
+            return _creaturesGUID.allocate();
+
+        case HIGH_GUID_ITEM:
+            return _itemsGUID.allocate();
+    }
+
+    return MAX_GUID;
+}
+
+void ObjectManager::freeGUID(Poco::UInt64 GUID)
+{
+    switch (HIGUID(GUID))
+    {
+        case HIGH_GUID_PLAYER:
+            _playersGUID.release(LOGUID(GUID));
+            break;
+
+        case HIGH_GUID_CREATURE:
+            _creaturesGUID.release(LOGUID(GUID));
             break;
 
         case HIGH_GUID_ITEM:
-            _itemsMutex.lock();
-            if (!_freeItems.empty())
-            {
-                GUID = *(_freeItems.begin());
-                _freeItems.erase(GUID);
-            }
-            else if (_itemsGUID != MAX_GUID)
-            {
-                GUID = _itemsGUID;
-                _itemsGUID++;
-            }
-            _itemsMutex.unlock();
+            _itemsGUID.release(LOGUID(GUID));
             break;
     }
-
-    return GUID;
 }
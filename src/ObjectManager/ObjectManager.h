@@ -7,6 +7,7 @@
 #endif
 
 #include <list>
+#include <vector>
 
 #include "Poco/Poco.h"
 #include "Poco/SingletonHolder.h"
@@ -15,60 +16,71 @@
 
 #include "Poco/SharedPtr.h"
 
-// Hash maps
-#include "hash_map.h"
-#include "stack_allocator.h"
-
 #include "defines.h"
+#include "GuidAllocator.h"
+#include "ObjectPool.h"
+#include "ObjectRegistry.h"
 
 using Poco::SharedPtr;
 
 
 class Object;
 class Client;
+class Creature;
 class Player;
 
+/**
+ * Owns all the entities, which are stored in per type pools. Lifetime model:
+ * - Raw pointers handed out by the manager are valid until the next tick
+ *   boundary, they must not be kept across ticks
+ * - Anything stored longer keeps the GUID (network) or the handle (pool)
+ *   and resolves it again, getting NULL once the object is gone
+ * - removeObject only unregisters the object, it is destroyed and its GUID
+ *   released on collect, which the server calls between ticks
+ */
 class ObjectManager
 {
 public:
     ObjectManager();
+    ~ObjectManager();
+
     static ObjectManager& instance()
     {
         static Poco::SingletonHolder<ObjectManager> sh;
         return *sh.get();
     }
 
-    SharedPtr<Object> create(Poco::UInt32 highGUID);
-    SharedPtr<Player> createPlayer(std::string name, Client* client);
+    Object* create(Poco::UInt32 highGUID);
+    Player* createPlayer(std::string name, Client* client);
 
-    SharedPtr<Object> getObject(Poco::UInt64 GUID);
+    Object* getObject(Poco::UInt64 GUID);
+    Object* resolve(ObjectHandle handle);
     void removeObject(Poco::UInt64 GUID);
 
+    void collect();
+
 private:
     Poco::UInt32 newGUID(Poco::UInt32 highGUID);
+    void freeGUID(Poco::UInt64 GUID);
 
 public:
     static Poco::UInt32 MAX_GUID;
 
 private:
-    typedef rde::hash_map<Poco::UInt32 /*loguid*/, SharedPtr<Object> /*object*/> ObjectsMap;
-    typedef std::set<Poco::UInt32> LowGuidsSet;
+    typedef std::vector<Object*> ObjectsList;
 
-    ObjectsMap _players;
-    ObjectsMap _creatures;
-    ObjectsMap _items;
+    ObjectPool<Player>* _playersPool;
+    ObjectPool<Creature>* _creaturesPool;
 
-    Poco::UInt32 _playersGUID;
-    Poco::UInt32 _creaturesGUID;
-    Poco::UInt32 _itemsGUID;
+    ObjectRegistry _players;
+    ObjectRegistry _creatures;
 
-    LowGuidsSet _freePlayers;
-    LowGuidsSet _freeCreatures;
-    LowGuidsSet _freeItems;
+    GuidAllocator _playersGUID;
+    GuidAllocator _creaturesGUID;
+    GuidAllocator _itemsGUID;
 
-    Poco::Mutex _playersMutex;
-    Poco::Mutex _creaturesMutex;
-    Poco::Mutex _itemsMutex;
+    ObjectsList _removed;
+    Poco::FastMutex _removedMutex;
 };
 
 #define sObjectManager ObjectManager::instance()
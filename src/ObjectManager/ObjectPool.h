@@ -0,0 +1,176 @@
+#ifndef GAMESERVER_OBJECT_POOL_H
+#define GAMESERVER_OBJECT_POOL_H
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "Poco/Poco.h"
+#include "Poco/Mutex.h"
+#include "Poco/ScopedLock.h"
+
+//@ Handles are generation (32 bits) | pool type (8 bits) | slot index (24 bits)
+typedef Poco::UInt64 ObjectHandle;
+
+#define INVALID_OBJECT_HANDLE ObjectHandle(0)
+#define MAKE_OBJECT_HANDLE(gen, type, index) ( ((Poco::UInt64)(gen) << 32) | ((Poco::UInt32)(type) << 24) | (index) )
+#define HANDLE_GENERATION(h) Poco::UInt32( (h) >> 32 )
+#define HANDLE_TYPE(h) Poco::UInt8( ((h) >> 24) & 0xFF )
+#define HANDLE_INDEX(h) Poco::UInt32( (h) & 0xFFFFFF )
+
+/**
+ * Stores objects of a single type in fixed size slabs. Slabs are never moved
+ * nor freed until the pool is destroyed, so resolving a handle takes no lock.
+ * Each slot has a generation, bumped when its object is destroyed, which
+ * makes stale handles resolve to NULL instead of to the slot new tenant
+ */
+template <class T>
+class ObjectPool
+{
+public:
+    enum
+    {
+        SLAB_SIZE = 1024,
+        MAX_SLABS = 0x1000000 / SLAB_SIZE
+    };
+
+    ObjectPool(Poco::UInt8 type):
+        _type(type),
+        _slabsCount(0)
+    {
+        _slabs = new Slab*[MAX_SLABS];
+    }
+
+    ~ObjectPool()
+    {
+        Poco::UInt32 slabsCount = _slabsCount.load(std::memory_order_relaxed);
+        for (Poco::UInt32 i = 0; i < slabsCount; ++i)
+        {
+            Slab* slab = _slabs[i];
+            for (Poco::UInt32 j = 0; j < SLAB_SIZE; ++j)
+                if (slab->alive[j])
+                    reinterpret_cast<T*>(&slab->objects[j])->~T();
+
+            delete slab;
+        }
+
+        delete [] _slabs;
+    }
+
+    /**
+     * Reserves a slot, the object must be constructed in place on the
+     * returned memory before its handle is published
+     *
+     * @param handle Output, handle of the reserved slot
+     * @return Memory of the slot, NULL if the pool is full
+     */
+    void* allocate(ObjectHandle& handle)
+    {
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        if (_free.empty() && !grow())
+            return NULL;
+
+        Poco::UInt32 index = _free.back();
+        _free.pop_back();
+
+        Slab* slab = _slabs[index / SLAB_SIZE];
+        Poco::UInt32 slot = index % SLAB_SIZE;
+        slab->alive[slot] = true;
+
+        handle = MAKE_OBJECT_HANDLE(slab->generations[slot], _type, index);
+        return &slab->objects[slot];
+    }
+
+    /**
+     * Resolves a handle
+     *
+     * @param handle Handle to resolve
+     * @return The object, or NULL if it has been destroyed
+     */
+    T* get(ObjectHandle handle)
+    {
+        Poco::UInt32 index = HANDLE_INDEX(handle);
+        // Pairs with grow, the slab is there once it is counted
+        if (HANDLE_TYPE(handle) != _type || index / SLAB_SIZE >= _slabsCount.load(std::memory_order_acquire))
+            return NULL;
+
+        Slab* slab = _slabs[index / SLAB_SIZE];
+        Poco::UInt32 slot = index % SLAB_SIZE;
+        if (!slab->alive[slot] || slab->generations[slot] != HANDLE_GENERATION(handle))
+            return NULL;
+
+        return reinterpret_cast<T*>(&slab->objects[slot]);
+    }
+
+    /**
+     * Destroys the object and frees its slot
+     *
+     * @param handle Handle of the object
+     */
+    void destroy(ObjectHandle handle)
+    {
+        T* object = get(handle);
+        if (!object)
+            return;
+
+        object->~T();
+
+        Poco::FastMutex::ScopedLock lock(_mutex);
+
+        Poco::UInt32 index = HANDLE_INDEX(handle);
+        Slab* slab = _slabs[index / SLAB_SIZE];
+        Poco::UInt32 slot = index % SLAB_SIZE;
+        slab->alive[slot] = false;
+
+        // Generation 0 is never used, so that a zero handle is always invalid
+        if (++slab->generations[slot] == 0)
+            slab->generations[slot] = 1;
+
+        _free.push_back(index);
+    }
+
+private:
+    typedef typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type Storage;
+
+    struct Slab
+    {
+        Storage objects[SLAB_SIZE];
+        Poco::UInt32 generations[SLAB_SIZE];
+        bool alive[SLAB_SIZE];
+    };
+
+    bool grow()
+    {
+        Poco::UInt32 slabsCount = _slabsCount.load(std::memory_order_relaxed);
+        if (slabsCount == MAX_SLABS)
+            return false;
+
+        Slab* slab = new Slab();
+        for (Poco::UInt32 j = 0; j < SLAB_SIZE; ++j)
+        {
+            slab->generations[j] = 1;
+            slab->alive[j] = false;
+        }
+
+        // Pushed in reverse, so that the lowest slots are used first
+        Poco::UInt32 base = slabsCount * SLAB_SIZE;
+        for (Poco::UInt32 j = SLAB_SIZE; j > 0; --j)
+            _free.push_back(base + j - 1);
+
+        // Published after the slab, get reads the count without the lock
+        _slabs[slabsCount] = slab;
+        _slabsCount.store(slabsCount + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    Poco::UInt8 _type;
+    Slab** _slabs;
+    std::atomic<Poco::UInt32> _slabsCount;
+    std::vector<Poco::UInt32> _free;
+    Poco::FastMutex _mutex;
+};
+
+#endif
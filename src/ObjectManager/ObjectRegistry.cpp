@@ -0,0 +1,54 @@
+#include "ObjectRegistry.h"
+
+/**
+ * Registers an object
+ *
+ * @param lowGUID Low GUID of the object
+ * @param object Object to be registered
+ * @return false if the GUID was already registered
+ */
+bool ObjectRegistry::insert(Poco::UInt32 lowGUID, Object* object)
+{
+    Shard& target = shard(lowGUID);
+    Poco::ScopedWriteRWLock lock(target.lock);
+    return target.objects.insert(rde::make_pair(lowGUID, object)).second;
+}
+
+/**
+ * Finds an object
+ *
+ * @param lowGUID Low GUID of the object
+ * @return The object, NULL if it is not registered
+ */
+Object* ObjectRegistry::find(Poco::UInt32 lowGUID)
+{
+    Shard& target = shard(lowGUID);
+    Poco::ScopedReadRWLock lock(target.lock);
+
+    ObjectsMap::iterator itr = target.objects.find(lowGUID);
+    if (itr != target.objects.end())
+        return itr->second;
+
+    return NULL;
+}
+
+/**
+ * Unregisters an object
+ *
+ * @param lowGUID Low GUID of the object
+ * @return The object which was registered, NULL if there was none, so that
+ *  only one of many concurrent erases gets it
+ */
+Object* ObjectRegistry::erase(Poco::UInt32 lowGUID)
+{
+    Shard& target = shard(lowGUID);
+    Poco::ScopedWriteRWLock lock(target.lock);
+
+    ObjectsMap::iterator itr = target.objects.find(lowGUID);
+    if (itr == target.objects.end())
+        return NULL;
+
+    Object* object = itr->second;
+    target.objects.erase(itr);
+    return object;
+}
@@ -0,0 +1,50 @@
+#ifndef GAMESERVER_OBJECT_REGISTRY_H
+#define GAMESERVER_OBJECT_REGISTRY_H
+
+#include "Poco/Poco.h"
+#include "Poco/RWLock.h"
+
+// Hash maps
+#include "hash_map.h"
+#include "stack_allocator.h"
+
+class Object;
+
+/**
+ * Maps low GUIDs to objects. The map is split in shards, each one with its
+ * own lock, so that lookups from the grid and network threads and inserts
+ * from concurrent spawns seldom wait for each other
+ */
+class ObjectRegistry
+{
+public:
+    enum
+    {
+        SHARDS = 16
+    };
+
+    bool insert(Poco::UInt32 lowGUID, Object* object);
+    Object* find(Poco::UInt32 lowGUID);
+    Object* erase(Poco::UInt32 lowGUID);
+
+private:
+    typedef rde::hash_map<Poco::UInt32 /*loguid*/, Object* /*object*/> ObjectsMap;
+
+    // Padded so that two shards locks never share a cache line
+    struct Shard
+    {
+        Poco::RWLock lock;
+        ObjectsMap objects;
+        char padding[64];
+    };
+
+    inline Shard& shard(Poco::UInt32 lowGUID)
+    {
+        return _shards[lowGUID & (SHARDS - 1)];
+    }
+
+private:
+    Shard _shards[SHARDS];
+};
+
+#endif
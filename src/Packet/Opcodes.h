@@ -0,0 +1,35 @@
+#ifndef GAMESERVER_OPCODES_H
+#define GAMESERVER_OPCODES_H
+
+//@ Packet opcodes, shared by the server and the LoadGenerator bots
+enum OPCODES
+{
+    OPCODE_NULL                         = 0x00,
+
+    // Server -> Client
+    OPCODE_SC_EHLO                      = 0x9000,
+    OPCODE_SC_TIME_OUT                  = 0x3001,
+    OPCODE_SC_PONG                      = 0x3002,
+    OPCODE_SC_LOGIN_RESULT              = 0x5101,
+    OPCODE_SC_SEND_CHARACTERS_LIST      = 0x5102,
+    OPCODE_SC_SELECT_CHARACTER_RESULT   = 0x5103,
+    OPCODE_SC_CREATE_CHARACTER_RESULT   = 0x5104,
+    OPCODE_SC_LOGIN_QUEUE               = 0x5105,
+    OPCODE_SC_SESSION_TICKET            = 0x5106,
+    OPCODE_SC_RESUME_SESSION_RESULT     = 0x5107,
+
+    OPCODE_SC_SPAWN_OBJECT              = 0x5201,
+    OPCODE_SC_DESPAWN_OBJECT            = 0x5202,
+    OPCODE_SC_PLAYER_STATS              = 0x5203,
+
+    // Client -> Server
+    OPCODE_CS_EHLO                      = 0x9000,
+    OPCODE_CS_KEEP_ALIVE                = 0x3000,
+    OPCODE_CS_PING                      = 0x3002,
+    OPCODE_CS_SEND_LOGIN                = 0x3101,
+    OPCODE_CS_REQUEST_CHARACTERS        = 0x3102,
+    OPCODE_CS_SELECT_CHARACTER          = 0x3103,
+    OPCODE_CS_RESUME_SESSION            = 0x3104,
+};
+
+#endif
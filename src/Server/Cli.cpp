@@ -1,7 +1,14 @@
 #include "Cli.h"
+#include "AuthDatabase.h"
+#include "CharactersDatabase.h"
+#include "DataStore.h"
 #include "defines.h"
 #include "Log.h"
 #include "Server.h"
+#include "Trace.h"
+
+#include <sstream>
+#include <stdlib.h>
 
 CLI::CLI()
 {
@@ -19,8 +26,96 @@ bool CLI::parseCLI(std::string cmd)
 {
     if (cmd.compare("diff") == 0)
         sLog.out(Message::PRIO_INFORMATION, "Server diff time: %d", sServer->getDiff());
+    else if (cmd.compare("dbstats") == 0)
+    {
+        AuthDatabase.dumpStats();
+        CharactersDatabase.dumpStats();
+    }
+    else if (cmd.compare(0, 7, "reload ") == 0)
+    {
+        std::string name = cmd.substr(7);
+        if (!DataStoreBase::reload(name))
+            sLog.out(Message::PRIO_INFORMATION, "DataStore %s does not exist or is already reloading", name.c_str());
+    }
+    else if (cmd.compare(0, 8, "loglevel") == 0)
+        setLogLevel(cmd.substr(8));
+    else if (cmd.compare(0, 5, "trace") == 0)
+        dumpTrace(cmd.substr(5));
     else if (cmd.compare("stop") == 0)
         return false;
 
     return true;
 }
+
+/**
+ * Shows the level of each log category, or sets it:
+ *  loglevel <level>             all categories
+ *  loglevel <category> <level>  a single one
+ *
+ * @param args Command arguments
+ */
+void CLI::setLogLevel(std::string args)
+{
+    std::istringstream stream(args);
+    std::string first;
+    std::string second;
+    stream >> first >> second;
+
+    if (first.empty())
+    {
+        for (Poco::UInt8 i = 0; i < MAX_LOG_CATEGORIES; ++i)
+            sLog.out(Message::PRIO_INFORMATION, "Log level of %s: %d", Log::getCategoryName(LogCategory(i)), (int)sLog.getLogLevel(LogCategory(i)));
+        return;
+    }
+
+    LogCategory category = LOG_SERVER;
+    std::string level = second.empty() ? first : second;
+    int prio = atoi(level.c_str());
+
+    if ((!second.empty() && !Log::findCategory(first, category)) || prio < Message::PRIO_FATAL || prio > Message::PRIO_TRACE)
+    {
+        sLog.out(Message::PRIO_INFORMATION, "Usage: loglevel [server|net|grid|db|ai] <1-8>");
+        return;
+    }
+
+    if (second.empty())
+        sLog.setLogLevel(Message::Priority(prio));
+    else
+        sLog.setLogLevel(category, Message::Priority(prio));
+}
+
+/**
+ * Writes the spans traced on the last seconds, as Chrome trace_event JSON:
+ *  trace <seconds> [file]
+ *
+ * @param args Command arguments
+ */
+void CLI::dumpTrace(std::string args)
+{
+    std::istringstream stream(args);
+    std::string seconds;
+    std::string path;
+    stream >> seconds >> path;
+
+    int time = atoi(seconds.c_str());
+    if (time <= 0)
+    {
+        sLog.out(Message::PRIO_INFORMATION, "Usage: trace <seconds> [file]");
+        return;
+    }
+
+    if (path.empty())
+        path = "Trace.json";
+
+    if (!sTrace.isEnabled())
+    {
+        sLog.out(Message::PRIO_INFORMATION, "Tracing is disabled, TraceBufferSize is 0");
+        return;
+    }
+
+    Poco::UInt32 written = 0;
+    if (sTrace.dump((Poco::UInt32)time, path, written))
+        sLog.out(Message::PRIO_INFORMATION, "%u spans of the last %d seconds written to %s", written, time, path.c_str());
+    else
+        sLog.out(Message::PRIO_ERROR, "Trace could not be written to %s", path.c_str());
+}
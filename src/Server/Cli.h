@@ -14,6 +14,8 @@ public:
     
 private:
     bool parseCLI(std::string cmd);
+    void setLogLevel(std::string args);
+    void dumpTrace(std::string args);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "LoginQueue.h"
+#include "ServerConfig.h"
+
+#include <algorithm>
+
+// Weight of each new sample on the latency average
+#define LOGIN_LATENCY_WEIGHT 0.1f
+
+LoginQueue::LoginQueue():
+    _inFlight(0)
+{
+    _limit = (float)std::max(sConfig.getDefaultInt("LoginConcurrency", 8), 1);
+    _maxLimit = std::max(sConfig.getDefaultInt("LoginMaxConcurrency", 64), 1);
+    _targetLatency = sConfig.getDefaultInt("LoginTargetLatency", 200);
+    _notifyInterval = sConfig.getDefaultInt("LoginQueueNotifyInterval", 5000);
+    _latency = (float)_targetLatency;
+}
+
+/**
+ * Admits a login, or queues it if too many are running. A connection only
+ * has one login queued or running, so that resending it takes no more room
+ *
+ * @param request Login to be admitted
+ * @param position Output, position on the queue if it has been queued
+ * @return LOGIN_EXECUTE if the login must be executed now, LOGIN_PENDING if
+ *  the connection already has one
+ */
+LoginQueue::EnterResult LoginQueue::enter(const Request& request, Poco::UInt32& position)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (!_connections.insert(request.connection).second)
+        return LOGIN_PENDING;
+
+    // Nobody skips the queue, even if there is room
+    if (_queue.empty() && _inFlight < (Poco::UInt32)_limit)
+    {
+        ++_inFlight;
+        return LOGIN_EXECUTE;
+    }
+
+    _queue.push_back(request);
+    position = (Poco::UInt32)_queue.size();
+    return LOGIN_QUEUED;
+}
+
+/**
+ * Ends an admitted login, and adapts the limit to its latency
+ *
+ * @param connection Connection id of the login
+ * @param latency Miliseconds since the login query was queued on the
+ *  database until its result was processed
+ */
+void LoginQueue::leave(Poco::UInt32 connection, Poco::UInt64 latency)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    _connections.erase(connection);
+    if (_inFlight > 0)
+        --_inFlight;
+
+    _latency += ((float)latency - _latency) * LOGIN_LATENCY_WEIGHT;
+
+    if (latency <= _targetLatency)
+        _limit = std::min(_limit + 1.0f / _limit, (float)_maxLimit);
+    else if ((Poco::UInt64)_lastDecrease.elapsed() / 1000 >= latency)
+    {
+        // Logins executed before the decrease would trigger it again
+        _lastDecrease.update();
+        _limit = std::max(_limit / 2.0f, 1.0f);
+    }
+}
+
+/**
+ * Takes the first queued login, if there is room for it
+ *
+ * @param request Output, login which must be executed now
+ * @return true if a login has been admitted
+ */
+bool LoginQueue::next(Request& request)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_queue.empty() || _inFlight >= (Poco::UInt32)_limit)
+        return false;
+
+    request = _queue.front();
+    _queue.pop_front();
+    ++_inFlight;
+    return true;
+}
+
+/**
+ * Drops the queued logins of a disconnected client
+ *
+ * @param connection Connection id of the client
+ */
+void LoginQueue::remove(Poco::UInt32 connection)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    // A running login leaves once its result is processed
+    for (std::list<Request>::iterator itr = _queue.begin(); itr != _queue.end(); ++itr)
+    {
+        if (itr->connection == connection)
+        {
+            _queue.erase(itr);
+            _connections.erase(connection);
+            return;
+        }
+    }
+}
+
+/**
+ * Estimates the time until a queued login is executed
+ *
+ * @param position Position on the queue
+ * @return Seconds, rounded up
+ */
+Poco::UInt32 LoginQueue::getETA(Poco::UInt32 position)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+    return (Poco::UInt32)(position * _latency / _limit / 1000.0f) + 1;
+}
+
+/**
+ * Gets the position of all the queued logins, once per notify interval
+ *
+ * @param positions Output, positions in queue order
+ * @return true if the positions must be sent
+ */
+bool LoginQueue::getPositions(std::vector<Position>& positions)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_queue.empty() || _lastNotify.elapsed() / 1000 < _notifyInterval)
+        return false;
+
+    _lastNotify.update();
+
+    Poco::UInt32 position = 0;
+    for (std::list<Request>::iterator itr = _queue.begin(); itr != _queue.end(); ++itr)
+    {
+        ++position;
+
+        Position entry = {itr->connection, position, (Poco::UInt32)(position * _latency / _limit / 1000.0f) + 1};
+        positions.push_back(entry);
+    }
+
+    return true;
+}
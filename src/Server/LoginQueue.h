@@ -0,0 +1,67 @@
+#ifndef GAMESERVER_LOGIN_QUEUE_H
+#define GAMESERVER_LOGIN_QUEUE_H
+
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Poco/Poco.h"
+#include "Poco/Mutex.h"
+#include "Poco/Timestamp.h"
+
+/**
+ * Admission control for logins. Only a limited number of login queries run
+ * at once, the rest wait in FIFO order. The limit follows the measured
+ * query latency: it grows by one every limit completions under the target
+ * latency, and halves, at most once per latency, when it is exceeded
+ */
+class LoginQueue
+{
+public:
+    struct Request
+    {
+        Poco::UInt32 connection;
+        std::string username;
+        std::string password;
+    };
+
+    struct Position
+    {
+        Poco::UInt32 connection;
+        Poco::UInt32 position;
+        Poco::UInt32 eta;
+    };
+
+    enum EnterResult
+    {
+        LOGIN_EXECUTE,
+        LOGIN_QUEUED,
+        LOGIN_PENDING
+    };
+
+    LoginQueue();
+
+    EnterResult enter(const Request& request, Poco::UInt32& position);
+    void leave(Poco::UInt32 connection, Poco::UInt64 latency);
+    bool next(Request& request);
+    void remove(Poco::UInt32 connection);
+
+    Poco::UInt32 getETA(Poco::UInt32 position);
+    bool getPositions(std::vector<Position>& positions);
+
+private:
+    std::list<Request> _queue;
+    std::set<Poco::UInt32> _connections;
+    Poco::UInt32 _inFlight;
+    float _limit;
+    Poco::UInt32 _maxLimit;
+    float _latency;
+    Poco::UInt32 _targetLatency;
+    Poco::Timestamp _lastDecrease;
+    Poco::Timestamp _lastNotify;
+    Poco::UInt32 _notifyInterval;
+    Poco::FastMutex _mutex;
+};
+
+#endif
@@ -10,16 +10,24 @@
 #include "AuthDatabase.h"
 #include "debugging.h"
 #include "CharactersDatabase.h"
+#include "DataStore.h"
+#include "CharacterStore.h"
 #include "Cli.h"
 #include "Client.h"
 #include "defines.h"
 #include "GridLoader.h"
 #include "Log.h"
 #include "ObjectManager.h"
+#include "OnlineStatusBuffer.h"
 #include "Object.h"
+#include "Opcodes.h"
 #include "Packet.h"
 #include "Player.h"
+#include "StatementJob.h"
 #include "Tools.h"
+#include "Trace.h"
+
+#include <functional>
 
 using Poco::Net::SocketReactor;
 using Poco::Net::SocketAcceptor;
@@ -50,30 +58,6 @@ enum HANDLE_IF_TYPE
     TYPE_ALWAYS
 };
 
-enum OPCODES
-{
-    OPCODE_NULL                         = 0x00,
-    
-    // Server -> Client
-    OPCODE_SC_EHLO                      = 0x9000,
-    OPCODE_SC_TIME_OUT                  = 0x3001,
-    OPCODE_SC_LOGIN_RESULT              = 0x5101,
-    OPCODE_SC_SEND_CHARACTERS_LIST      = 0x5102,
-    OPCODE_SC_SELECT_CHARACTER_RESULT   = 0x5103,
-    OPCODE_SC_CREATE_CHARACTER_RESULT   = 0x5104,
-
-    OPCODE_SC_SPAWN_OBJECT              = 0x5201,
-    OPCODE_SC_DESPAWN_OBJECT            = 0x5202,
-    OPCODE_SC_PLAYER_STATS              = 0x5203,
-    
-    // Client -> Server
-    OPCODE_CS_EHLO                      = 0x9000,
-    OPCODE_CS_KEEP_ALIVE                = 0x3000,
-    OPCODE_CS_SEND_LOGIN                = 0x3101,
-    OPCODE_CS_REQUEST_CHARACTERS        = 0x3102,
-    OPCODE_CS_SELECT_CHARACTER          = 0x3103,
-};
-
 struct OpcodeHandleType
 {
     OPCODES Opcode;
@@ -90,9 +74,11 @@ const OpcodeHandleType Server::OpcodeTable[] =
     // Client -> Server
     {OPCODE_CS_EHLO,                {&Server::handlePlayerEHLO,         TYPE_NOT_LOGGED_SKIP_HMAC   }},
     {OPCODE_CS_KEEP_ALIVE,          {NULL,                              TYPE_ALWAYS                 }},
+    {OPCODE_CS_PING,                {&Server::handlePing,               TYPE_ALWAYS                 }},
     {OPCODE_CS_SEND_LOGIN,          {&Server::handlePlayerLogin,        TYPE_NOT_LOGGED             }},
     {OPCODE_CS_REQUEST_CHARACTERS,  {&Server::handleRequestCharacters,  TYPE_LOGGED                 }},
     {OPCODE_CS_SELECT_CHARACTER,    {&Server::handleCharacterSelect,    TYPE_LOGGED                 }},
+    {OPCODE_CS_RESUME_SESSION,      {&Server::handleResumeSession,      TYPE_NOT_LOGGED_SKIP_HMAC   }},
 
     {OPCODE_NULL,                   {NULL,                              TYPE_NULL                   }},
 };
@@ -110,7 +96,8 @@ OpcodeHash OpcodesMap;
 * @param port The port where the servers binds
 */
 Server::Server():
-    _serverRunning(false)
+    _serverRunning(false),
+    _nextConnection(1)
 {
     // Create the Opcodes Map
     for (int i = 0; ; ++i)
@@ -120,10 +107,6 @@ Server::Server():
 
         OpcodesMap.insert(OpcodeHashInserter(OpcodeTable[i].Opcode, OpcodeTable[i].Handler));
     }
-
-    // Reset all players online state
-    PreparedStatement* stmt = AuthDatabase.getPreparedStatement(QUERY_AUTH_UPDATE_ONLINE_ONSTART);
-    stmt->execute();
 }
 
 Server::~Server()
@@ -170,63 +153,19 @@ void Server::start(Poco::UInt16 port)
     // Close network acceptors
     reactor.stop();
     reactorThread.join();
+
+    // Nothing sends to the clients disconnected on the last tick anymore
+    collectClients();
 }
 
 #ifdef SERVER_FRAMEWORK_TEST_SUITE
-    class Spawner
-    {
-    public:
-        Spawner()
-        {
-            spawnLimit = count = 5000;
-            playerMax = 1000;
-            x = 0;
-            z = 0;
-        }
-
-        ~Spawner()
-        {}
-
-        // Spawn 5 entities per tick
-        // Avoid overload
-        void spawn()
-        {
-            for (int i = 0; i < 50 && count > 0; i++, count--)
-            {
-                if ((i % 3 != 0) && playerMax > 0)
-                {
-                    SharedPtr<Player> plr = sObjectManager.createPlayer("ASD", NULL);
-                    plr->Relocate(Vector2D(x, z));
-                    sGridLoader.addObject(plr);
-                    MotionMaster::StartSimpleMovement(plr, Vector2D(2800, 1000), SPEED_RUN);
-                    playerMax--;
-                }
-                else
-                {
-                    SharedPtr<Object> obj = sObjectManager.create(HIGH_GUID_CREATURE);
-                    obj->Relocate(Vector2D(x, z));
-                    sGridLoader.addObject(obj);
-                    MotionMaster::StartAngleMovement(obj, 0.5f, SPEED_WALK);
-                }
-                
-                x += ((MAP_MAX_X - MAP_MIN_X) / (float)spawnLimit);
-                z += ((MAP_MAX_Z - MAP_MIN_Z) / (float)spawnLimit);
-            }
-        }
-
-    private:
-        Poco::UInt32 spawnLimit;
-        Poco::UInt32 count;
-        Poco::UInt32 playerMax;
-        float x;
-        float z;
-    };
+    #include "Spawner.h"
 #endif
 
 void Server::run()
 {
     #ifdef SERVER_FRAMEWORK_TEST_SUITE
-        Spawner spawner;
+        Spawner spawner(1000, 4000);
     #endif
 
     Timestamp lastUpdate;
@@ -237,17 +176,45 @@ void Server::run()
         _diff = lastUpdate.elapsed() / 1000;
         lastUpdate.update();
 
-        //sLog.out(Message::PRIO_DEBUG, "Diff time: %d", _diff);
-        //if (_diff > 125)
-            //ASSERT(false);
-
-        // Update all grids now
-        sGridLoader.update(_diff);
-
-        // Spawn mobs
-        #ifdef SERVER_FRAMEWORK_TEST_SUITE
-            spawner.spawn();
-        #endif
+        {
+            TRACE_SCOPE("Server::run");
+
+            //sLog.out(Message::PRIO_DEBUG, "Diff time: %d", _diff);
+            //if (_diff > 125)
+                //ASSERT(false);
+
+            // Update all grids now
+            sGridLoader.update(_diff);
+
+            // Grids are done with the DataStores read on the previous ticks
+            DataStoreBase::update();
+
+            // Keep the last state of the characters which have logged out,
+            // and remove their players
+            sCharacterStore.collect();
+
+            // Destroy the objects removed during this tick, now that no grid
+            // nor pending packet can reference them
+            sObjectManager.collect();
+
+            // Their players are gone, and no packet can be sent to them
+            collectClients();
+
+            // Continue whatever was waiting for the database
+            TRACE_SCOPE("Server::completions");
+            AuthDatabase.processCompletions();
+            CharactersDatabase.processCompletions();
+            AuthDatabase.updateStats();
+            CharactersDatabase.updateStats();
+            sOnlineStatus.update();
+            sCharacterStore.update();
+            sendLoginQueuePositions();
+
+            // Spawn mobs
+            #ifdef SERVER_FRAMEWORK_TEST_SUITE
+                spawner.spawn();
+            #endif
+        }
 
         // Wait for a constant update time
         if (_diff <= WORLD_HEART_BEAT + prevSleepTime)
@@ -286,9 +253,16 @@ void Server::SendPlayerEHLO(Client* client)
     client->sendPacket(packet, false, false);
 }
 
-void Server::SendClientDisconnected(Client* client)
+/**
+ * Tells a client why it is being disconnected, right before closing it
+ *
+ * @param client Client being disconnected
+ * @param reason DISCONNECTED_TIME_OUT or DISCONNECTED_INCORRECT_DATA
+ */
+void Server::SendClientDisconnected(Client* client, Poco::UInt8 reason)
 {
-    Packet* packet = new Packet(OPCODE_SC_TIME_OUT);
+    Packet* packet = new Packet(OPCODE_SC_TIME_OUT, 1);
+    *packet << reason;
     client->sendPacket(packet);
 }
 
@@ -356,7 +330,7 @@ Packet* Server::buildDespawnPacket(Poco::UInt64 GUID)
     return packet;
 }
 
-void Server::sendPlayerStats(Client* client, SharedPtr<Object> object)
+void Server::sendPlayerStats(Client* client, Object* object)
 {
     // We should send the STR, INT, attack, defense, and private attributes here
     //@todo: All the params, right now we are only sending the player guid
@@ -369,7 +343,7 @@ void Server::sendPlayerStats(Client* client, SharedPtr<Object> object)
 
 bool Server::parsePacket(Client* client, Packet* packet, Poco::UInt8 securityByte)
 {
-    sLog.out(Message::PRIO_DEBUG, "[%d]\t[C->S] %.4X", client->GetId(), packet->opcode);
+    LOG_OUT(LOG_NET, Message::PRIO_DEBUG, "[%d]\t[C->S] %.4X", client->GetId(), packet->opcode);
 
     OPCODES opcode = (OPCODES)packet->opcode;
     if (OpcodesMap.find(opcode) == OpcodesMap.end())
@@ -444,6 +418,27 @@ bool Server::handlePlayerEHLO(Client* client, Packet* packet)
     return true;
 }
 
+/**
+ * Echoes a ping back, clients measure their round trip time with it
+ *
+ * @param client Client which sent it
+ * @param packet Whatever the client wants back, up to 16 bytes
+ * @return false if the packet is too long
+ */
+bool Server::handlePing(Client* client, Packet* packet)
+{
+    Poco::UInt16 length = packet->getLength();
+    if (length > 16)
+        return false;
+
+    Packet* resp = new Packet(OPCODE_SC_PONG, length);
+    if (length)
+        memcpy(resp->rawdata, packet->rawdata, length);
+
+    client->sendPacket(resp);
+    return true;
+}
+
 bool Server::handlePlayerLogin(Client* client, Packet* packet)
 {
     std::string username;
@@ -452,32 +447,80 @@ bool Server::handlePlayerLogin(Client* client, Packet* packet)
     *packet >> username;
     packet->readAsHex(pass, 16);
 
-    //  0       1
-    // u.id, u.online
-    PreparedStatement* stmt = AuthDatabase.getPreparedStatement(QUERY_AUTH_LOGIN);
-    stmt->bindString(0, username);
-    stmt->bindString(1, pass);
-    
-    RecordSet rs = stmt->execute();
-    
+    // Only a few logins query the database at once, the rest wait their turn
+    LoginQueue::Request request = {client->getConnectionId(), username, pass};
+    Poco::UInt32 position;
+    switch (_loginQueue.enter(request, position))
+    {
+        case LoginQueue::LOGIN_EXECUTE:
+            executeLogin(request);
+            break;
+
+        case LoginQueue::LOGIN_QUEUED:
+        {
+            Packet* resp = new Packet(OPCODE_SC_LOGIN_QUEUE, 8);
+            *resp << position;
+            *resp << _loginQueue.getETA(position);
+            client->sendPacket(resp);
+            break;
+        }
+
+        case LoginQueue::LOGIN_PENDING:
+            // Resent while the first one is queued or running, it is dropped
+            break;
+    }
+
+    return true;
+}
+
+void Server::executeLogin(const LoginQueue::Request& request)
+{
+    StatementJob<AuthLogin>* job = new StatementJob<AuthLogin>(request.username, request.password);
+    AuthDatabase.enqueue(job, std::bind(&Server::onPlayerLogin, this, request.connection, Poco::Timestamp(), std::placeholders::_1));
+}
+
+void Server::onPlayerLogin(Poco::UInt32 connection, Poco::Timestamp queued, StatementJob<AuthLogin>& job)
+{
+    // Make room for the queued logins, whether this client is still here or not
+    _loginQueue.leave(connection, queued.elapsed() / 1000);
+
+    LoginQueue::Request request;
+    while (_loginQueue.next(request))
+        executeLogin(request);
+
+    // The client may have disconnected while the query was running
+    Poco::FastMutex::ScopedLock lock(_clientsMutex);
+    Client* client = findClient(connection);
+    if (!client)
+        return;
+
     Packet* resp = new Packet(OPCODE_SC_LOGIN_RESULT, 1);
 
-    if (rs.moveFirst())
+    if (job.succeeded() && !job.getRows().empty())
     {
         client->setLogged(true);
 
-        if (rs[1].convert<Poco::UInt8>() == 1)
+        //  0       1
+        // u.id, u.online
+        const AuthLogin::Row& row = job.getRows().front();
+
+        // The database flag might be outdated, if there is a change yet to be written
+        Poco::UInt32 account = std::get<0>(row);
+        bool online = std::get<1>(row) == 1;
+        sOnlineStatus.getOnline(account, online);
+
+        if (online)
             *resp << Poco::UInt8(0x02); // Already logged in
         else
         {
             *resp << Poco::UInt8(0x01);
-            client->SetId(rs[0].convert<Poco::UInt32>());
+            client->SetId(account);
 
             // Set online status
-            stmt = AuthDatabase.getPreparedStatement(QUERY_AUTH_UPDATE_ONLINE);
-            stmt->bindUInt8(0, 0x01);
-            stmt->bindUInt32(1, client->GetId());
-            stmt->execute();
+            sOnlineStatus.setOnline(account, true);
+
+            // A session left behind can not be resumed anymore
+            _sessionTickets.revoke(account);
         }
     }
     else
@@ -485,7 +528,6 @@ bool Server::handlePlayerLogin(Client* client, Packet* packet)
 
     // Write back
     client->sendPacket(resp);
-    return true;
 }
 
 bool Server::handleRequestCharacters(Client* client, Packet* packet)
@@ -511,51 +553,63 @@ bool Server::handleRequestCharacters(Client* client, Packet* packet)
 
 bool Server::sendCharactersList(Client* client)
 {
+    StatementJob<CharactersSelectList>* job = new StatementJob<CharactersSelectList>(client->GetId());
+
+    CharactersDatabase.enqueue(job, std::bind(&Server::onCharactersList, this, client->getConnectionId(), std::placeholders::_1));
+    return true;
+}
+
+void Server::onCharactersList(Poco::UInt32 connection, StatementJob<CharactersSelectList>& job)
+{
+    Poco::FastMutex::ScopedLock lock(_clientsMutex);
+    Client* client = findClient(connection);
+    if (!client)
+        return;
+
     client->ClearCharacters();
 
     Packet* resp = new Packet(OPCODE_SC_SEND_CHARACTERS_LIST, 1024, true);
 
-    //  1       2       3
-    // c.id, c.model, c.name
-    PreparedStatement* stmt = CharactersDatabase.getPreparedStatement(QUERY_CHARACTERS_SELECT_BASIC_INFORMATION);
-    stmt->bindUInt32(0, client->GetId());
-    
-    RecordSet rs = stmt->execute();
+    //  0       1       2         3
+    // c.id, c.model, c.name, i.item_id
+    // One row per visible item, ordered by character. Characters without
+    // items come in a single row with item 0
+    typedef StatementJob<CharactersSelectList>::Rows Rows;
+    Rows& rows = job.getRows();
+    if (!job.succeeded())
+        rows.clear();
 
-    *resp << Poco::UInt8(rs.rowCount());
-    if (rs.moveFirst())
-    {
-        do
-        {
-            Characters character = {rs[0].convert<Poco::UInt32>(), rs[1].convert<Poco::UInt32>(), rs[2].convert<std::string>()};
-            client->AddCharacter(character);
+    Poco::UInt8 count = 0;
+    for (Rows::iterator itr = rows.begin(); itr != rows.end(); ++itr)
+        if (itr == rows.begin() || std::get<0>(*itr) != std::get<0>(*(itr - 1)))
+            ++count;
 
-            *resp << character.id;
-            *resp << character.model;
-            *resp << character.name;
+    *resp << count;
 
-            PreparedStatement* stmtItems = CharactersDatabase.getPreparedStatement(QUERY_CHARACTERS_SELECT_VISIBLE_EQUIPMENT);
-            stmtItems->bindUInt32(0, client->GetId());
+    Rows::iterator itr = rows.begin();
+    while (itr != rows.end())
+    {
+        Characters character = {std::get<0>(*itr), std::get<1>(*itr), std::get<2>(*itr)};
+        client->AddCharacter(character);
 
-            RecordSet rsItems = stmtItems->execute();
+        *resp << character.id;
+        *resp << character.model;
+        *resp << character.name;
 
-            if (rsItems.moveFirst())
+        // Visible equipment, until the next character
+        for (; itr != rows.end() && std::get<0>(*itr) == character.id; ++itr)
+        {
+            if (std::get<3>(*itr))
             {
-                do
-                {
-                    *resp << Poco::UInt8(0x01);
-                    *resp << rsItems[0].convert<Poco::UInt32>();
-                }
-                while (rsItems.moveNext());
+                *resp << Poco::UInt8(0x01);
+                *resp << std::get<3>(*itr);
             }
-            *resp << Poco::UInt8(0x00);
         }
-        while (rs.moveNext());
+
+        *resp << Poco::UInt8(0x00);
     }
 
     client->sendPacket(resp, true);
-
-    return true;
 }
 
 bool Server::handleCharacterSelect(Client* client, Packet* packet)
@@ -564,15 +618,16 @@ bool Server::handleCharacterSelect(Client* client, Packet* packet)
     *packet >> characterID;
 
     Packet* resp = new Packet(OPCODE_SC_SELECT_CHARACTER_RESULT, 1);
-    Characters* character = client->FindCharacter(characterID);
-    if (character)
+    Characters character;
+    bool found = client->FindCharacter(characterID, character);
+    if (found)
         *resp << Poco::UInt8(0x01);
     else
         *resp << Poco::UInt8(0x00);
 
     client->sendPacket(resp);
 
-    if (character)
+    if (found)
     {
         OnEnterToWorld(client, characterID);
         return true;
@@ -588,10 +643,43 @@ bool Server::sendCharacterCreateResult(Client* client, Packet* packet)
 }
 
 void Server::OnEnterToWorld(Client* client, Poco::UInt32 characterID)
+{
+    // Characters played recently are still cached, no query is needed
+    CharacterRecord record;
+    if (sCharacterStore.find(characterID, record))
+    {
+        enterWorld(client, record);
+        return;
+    }
+
+    // Load the character, the player is created once it is loaded
+    StatementJob<CharactersSelectInformation>* job = new StatementJob<CharactersSelectInformation>(characterID);
+
+    CharactersDatabase.enqueue(job, std::bind(&Server::onCharacterLoaded, this, client->getConnectionId(), characterID, std::placeholders::_1));
+}
+
+void Server::onCharacterLoaded(Poco::UInt32 connection, Poco::UInt32 characterID, StatementJob<CharactersSelectInformation>& job)
+{
+    Poco::FastMutex::ScopedLock lock(_clientsMutex);
+    Client* client = findClient(connection);
+    if (!client)
+        return;
+
+    if (!job.succeeded() || job.getRows().empty())
+    {
+        //@todo: Notify player that he can't connect
+        //@todo: time out client
+        return;
+    }
+
+    enterWorld(client, sCharacterStore.load(characterID, job.getRows().front()));
+}
+
+void Server::enterWorld(Client* client, const CharacterRecord& record)
 {
     // Create the player (Object) and add it to the object list
-    SharedPtr<Player> player = client->onEnterToWorld(characterID);
-    if (!player.isNull())
+    Player* player = client->onEnterToWorld(record);
+    if (player)
     {
         client->setInWorld(true);
 
@@ -603,6 +691,9 @@ void Server::OnEnterToWorld(Client* client, Poco::UInt32 characterID)
 
         // Send an spawn packet of itself
         sendPacketTo(buildSpawnPacket(player), player);
+
+        // Allow resuming the session after a disconnect
+        sendSessionTicket(client, record.id);
     }
     else
     {
@@ -611,3 +702,162 @@ void Server::OnEnterToWorld(Client* client, Poco::UInt32 characterID)
     }
 }
 
+/**
+ * Issues a ticket for the session of a client which has entered the world,
+ * and sends it encrypted
+ *
+ * @param client Client in world
+ * @param characterID Character being played
+ */
+void Server::sendSessionTicket(Client* client, Poco::UInt32 characterID)
+{
+    Characters character;
+    if (!client->FindCharacter(characterID, character))
+        return;
+
+    SessionTickets::Session session;
+    session.account = client->GetId();
+    session.character = characterID;
+    session.model = character.model;
+    session.name = character.name;
+    memcpy(session.HMACKey, client->GetHMACKey(), sizeof(session.HMACKey));
+    memcpy(session.AESKey, client->GetAESKey(), sizeof(session.AESKey));
+
+    Packet* packet = new Packet(OPCODE_SC_SESSION_TICKET, SESSION_TICKET_SIZE);
+    _sessionTickets.issue(session, packet->rawdata);
+    client->sendPacket(packet, true);
+}
+
+/**
+ * Resumes a session instead of answering the EHLO. The client sends the
+ * ticket and proves it owns it, then both sides derive the new keys from
+ * the previous ones, and the character enters the world again. If it is
+ * rejected, the client can still go on with the EHLO and login
+ *
+ * @param client Client which has just connected
+ * @param packet Ticket followed by the proof
+ * @return false if the packet is malformed
+ */
+bool Server::handleResumeSession(Client* client, Packet* packet)
+{
+    if (packet->getLength() < SESSION_TICKET_SIZE + SESSION_PROOF_SIZE || client->getHMACVerifier())
+        return false;
+
+    // The low part of the HMAC key sent on the EHLO is the challenge
+    SessionTickets::Session session;
+    bool resumed = _sessionTickets.resume(packet->rawdata, packet->rawdata + SESSION_TICKET_SIZE, client->GetHMACKey(), session);
+
+    Packet* resp = new Packet(OPCODE_SC_RESUME_SESSION_RESULT, 1);
+    if (!resumed)
+    {
+        *resp << Poco::UInt8(0x00);
+        client->sendPacket(resp);
+        return true;
+    }
+
+    memcpy(client->GetHMACKey(), session.HMACKey, sizeof(session.HMACKey));
+    memcpy(client->GetAESKey(), session.AESKey, sizeof(session.AESKey));
+    client->SetupSecurity();
+
+    client->SetId(session.account);
+    client->setLogged(true);
+    sOnlineStatus.setOnline(session.account, true);
+
+    Characters character = {session.character, session.model, session.name};
+    client->AddCharacter(character);
+
+    // Already signed with the new keys
+    *resp << Poco::UInt8(0x01);
+    client->sendPacket(resp);
+
+    OnEnterToWorld(client, session.character);
+    return true;
+}
+
+/**
+ * Sends their position to the clients waiting on the login queue, once
+ * per notify interval
+ */
+void Server::sendLoginQueuePositions()
+{
+    std::vector<LoginQueue::Position> positions;
+    if (!_loginQueue.getPositions(positions))
+        return;
+
+    Poco::FastMutex::ScopedLock lock(_clientsMutex);
+    for (std::vector<LoginQueue::Position>::iterator itr = positions.begin(); itr != positions.end(); ++itr)
+    {
+        if (Client* client = findClient(itr->connection))
+        {
+            Packet* resp = new Packet(OPCODE_SC_LOGIN_QUEUE, 8);
+            *resp << itr->position;
+            *resp << itr->eta;
+            client->sendPacket(resp);
+        }
+    }
+}
+
+/**
+ * Registers a connected client
+ *
+ * @param client Client which has connected
+ * @return Connection id, never reused
+ */
+Poco::UInt32 Server::registerClient(Client* client)
+{
+    Poco::FastMutex::ScopedLock lock(_clientsMutex);
+
+    Poco::UInt32 connection = _nextConnection++;
+    _clients.insert(rde::make_pair(connection, client));
+    return connection;
+}
+
+/**
+ * Unregisters a client. Once it returns, no database callback is using
+ * the client nor will find it
+ *
+ * @param connection Connection id of the client
+ */
+void Server::unregisterClient(Poco::UInt32 connection)
+{
+    Poco::FastMutex::ScopedLock lock(_clientsMutex);
+    _clients.erase(connection);
+}
+
+/**
+ * Deletes a disconnected client on the next collectClients, once no grid
+ * nor broadcast worker can be sending to it
+ *
+ * @param client Client already detached from the reactor
+ */
+void Server::destroyClient(Client* client)
+{
+    Poco::FastMutex::ScopedLock lock(_destroyedClientsMutex);
+    _destroyedClients.push_back(client);
+}
+
+/**
+ * Deletes the clients disconnected until now, called between ticks
+ */
+void Server::collectClients()
+{
+    std::vector<Client*> destroyed;
+    {
+        Poco::FastMutex::ScopedLock lock(_destroyedClientsMutex);
+        destroyed.swap(_destroyedClients);
+    }
+
+    for (std::vector<Client*>::iterator itr = destroyed.begin(); itr != destroyed.end(); ++itr)
+        delete *itr;
+}
+
+// Must be called with _clientsMutex held
+Client* Server::findClient(Poco::UInt32 connection)
+{
+    ClientsMap::iterator itr = _clients.find(connection);
+    if (itr != _clients.end())
+        return itr->second;
+
+    return NULL;
+}
+
@@ -4,16 +4,25 @@
 #include <map>
 #include <list>
 #include <unordered_map>
+#include <vector>
 
 //@ Basic Poco Types and Threading
 #include "Poco/Poco.h"
+#include "Poco/Mutex.h"
 #include "Poco/Thread.h"
 #include "Poco/Runnable.h"
+#include "Poco/Timestamp.h"
 
 //@ Shared Pointers to save objects
 #include "Poco/SharedPtr.h"
 
 #include "defines.h"
+#include "LoginQueue.h"
+#include "SessionTickets.h"
+
+//@ Hash maps
+#include "hash_map.h"
+#include "stack_allocator.h"
 
 using Poco::SharedPtr;
 using Poco::Thread;
@@ -22,6 +31,14 @@ class Object;
 class Client;
 class Packet;
 
+struct AuthLogin;
+struct CharacterRecord;
+struct CharactersSelectInformation;
+struct CharactersSelectList;
+
+template <class S>
+class StatementJob;
+
 struct OpcodeHandleType;
 
 class Server : public Poco::Runnable
@@ -50,7 +67,7 @@ public:
 
     // Server -> Client packets
     void SendPlayerEHLO(Client* client);
-    void SendClientDisconnected(Client* client);
+    void SendClientDisconnected(Client* client, Poco::UInt8 reason);
 
     Packet* buildSpawnPacket(Object* object, bool deleteOnSend = true);
     Packet* buildDespawnPacket(Poco::UInt64 GUID);
@@ -59,25 +76,64 @@ public:
     // Packet parsing function
     bool parsePacket(Client* client, Packet* packet, Poco::UInt8 securityByte);
 
+    // Connected clients, database results refer to them by connection
+    Poco::UInt32 registerClient(Client* client);
+    void unregisterClient(Poco::UInt32 connection);
+    void destroyClient(Client* client);
+    void collectClients();
+
+    inline void leaveLoginQueue(Poco::UInt32 connection)
+    {
+        _loginQueue.remove(connection);
+    }
+
+    inline void suspendSession(Poco::UInt32 account)
+    {
+        _sessionTickets.suspend(account);
+    }
+
 private:
+    Client* findClient(Poco::UInt32 connection);
+
     bool checkPacketHMAC(Client* client, Packet* packet);
     void decryptPacket(Client* client, Packet* packet);
 
     bool handlePlayerEHLO(Client* client, Packet* packet);
+    bool handlePing(Client* client, Packet* packet);
     bool handlePlayerLogin(Client* client, Packet* packet);
+    void executeLogin(const LoginQueue::Request& request);
+    void onPlayerLogin(Poco::UInt32 connection, Poco::Timestamp queued, StatementJob<AuthLogin>& job);
+    void sendLoginQueuePositions();
+    bool handleResumeSession(Client* client, Packet* packet);
 
     bool handleRequestCharacters(Client* client, Packet* packet);
     bool sendCharactersList(Client* client);
+    void onCharactersList(Poco::UInt32 connection, StatementJob<CharactersSelectList>& job);
     bool handleCharacterSelect(Client* client, Packet* packet);
     bool sendCharacterCreateResult(Client* client, Packet* packet);
 
-    void sendPlayerStats(Client* client, SharedPtr<Object> object);
+    void sendPlayerStats(Client* client, Object* object);
     void OnEnterToWorld(Client* client, Poco::UInt32 characterID);
+    void onCharacterLoaded(Poco::UInt32 connection, Poco::UInt32 characterID, StatementJob<CharactersSelectInformation>& job);
+    void enterWorld(Client* client, const CharacterRecord& record);
+    void sendSessionTicket(Client* client, Poco::UInt32 characterID);
 
 private:
+    typedef rde::hash_map<Poco::UInt32 /*connection*/, Client*> ClientsMap;
+
     bool _serverRunning;
     Poco::UInt64 _diff;
 
+    ClientsMap _clients;
+    Poco::UInt32 _nextConnection;
+    Poco::FastMutex _clientsMutex;
+
+    std::vector<Client*> _destroyedClients;
+    Poco::FastMutex _destroyedClientsMutex;
+
+    LoginQueue _loginQueue;
+    SessionTickets _sessionTickets;
+
     static const OpcodeHandleType OpcodeTable[];
 };
 
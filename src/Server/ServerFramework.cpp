@@ -2,17 +2,22 @@
 
 #include "AuthDatabase.h"
 #include "CharactersDatabase.h"
+#include "CharacterStore.h"
 #include "DataStore.h"
 #include "debugging.h"
 #include "defines.h"
 #include "GridLoader.h"
 #include "Log.h"
+#include "OnlineStatusBuffer.h"
 #include "Server.h"
 #include "ServerConfig.h"
+#include "StartupTasks.h"
+#include "Trace.h"
 
 //@ Basic server information
 // >> Server runs on multiple threads, grids are in a thread pool
 #include "Poco/ErrorHandler.h"
+#include "Poco/String.h"
 #include "Poco/ThreadPool.h"
 
 //@ Everything is stored in SharedPtrs
@@ -62,49 +67,143 @@ int main(int argc, char** argv)
     // Set log level
     sLog.out(Message::PRIO_INFORMATION, "\t[OK] Setting LogLevel to %d\n", sConfig.getDefaultInt("LogLevel", 4));
     sLog.setLogLevel(Message::Priority(sConfig.getDefaultInt("LogLevel", 4)));
+    sLog.setBufferSize(sConfig.getDefaultInt("LogBufferSize", 65536));
+    sTrace.setBufferSize(sConfig.getDefaultInt("TraceBufferSize", 65536));
 
-    // Initialize the Error Handler and MySQL
+    // Initialize the Error Handler and the database backend
     MyErrorHandler eh;
     Poco::ErrorHandler* oldErrorHandler = Poco::ErrorHandler::set(&eh);    
     
-    sLog.out(Message::PRIO_INFORMATION, "[*] Initializing MySQL");
-    MySQL::Connector::registerConnector();
-    
-    // Read database configuration
+    // Matched in any case, then replaced by the key of its connector
+    std::string backend = sConfig.getDefaultString("DatabaseBackend", MySQL::Connector::KEY);
+    bool sqlite = Poco::icompare(backend, SQLite::Connector::KEY) == 0;
+    if (!sqlite && Poco::icompare(backend, MySQL::Connector::KEY) != 0)
+        sLog.out(Message::PRIO_WARNING, "Unknown DatabaseBackend %s, using MySQL", backend.c_str());
+
+    backend = sqlite ? SQLite::Connector::KEY : MySQL::Connector::KEY;
+    sLog.out(Message::PRIO_INFORMATION, "[*] Initializing %s", backend.c_str());
+
+    // Read database configuration, local files for SQLite, where the bundled
+    // schema creates any missing table
     ServerConfig::StringConfigsMap connectionStrings = sConfig.getDatabaseInformation();
+    std::string authSchema;
+    std::string charactersSchema;
 
-    // Databases
-    AuthDatabase.Open(connectionStrings["auth"]);
-    CharactersDatabase.Open(connectionStrings["characters"]);
-    sLog.out(Message::PRIO_INFORMATION, "\t[OK] Done");
+    if (sqlite)
+    {
+        SQLite::Connector::registerConnector();
+
+        std::string path = sConfig.getDefaultString("SQLitePath", ".");
+        std::string schema = sConfig.getDefaultString("SQLiteSchemaPath", "sql/sqlite");
+        connectionStrings["auth"] = path + "/auth.db";
+        connectionStrings["characters"] = path + "/characters.db";
+        authSchema = schema + "/auth.sql";
+        charactersSchema = schema + "/characters.sql";
+    }
+    else
+        MySQL::Connector::registerConnector();
 
-    // Initialize the server
-    sLog.out(Message::PRIO_INFORMATION, "\n[*] Initializing server");
-    sServer = new Server();
-    sLog.out(Message::PRIO_INFORMATION, "\t[OK] Done");
-    
-    // --------------------- //
-    // Initialize GridLoader //
-    // --------------------- //
+    std::string authConnection = connectionStrings["auth"];
+    std::string charactersConnection = connectionStrings["characters"];
+
+    // ------------------------------------------------------------ //
+    // Startup steps, those not depending on each other run at once //
+    // ------------------------------------------------------------ //
+    sLog.out(Message::PRIO_INFORMATION, "\n[*] Starting up");
+
+    // Steps threads, and the sessions they took, are gone once it ends
+    bool started;
     {
-        sLog.out(Message::PRIO_INFORMATION, "\n[*] Initializing Grid System");
-        sGridLoader.instance();
-        sLog.out(Message::PRIO_INFORMATION, "\t[OK] Done");
+        StartupTasks startup;
+        startup.add("Auth database", [&]() -> bool
+        {
+            return AuthDatabase.Open(backend, authConnection, authSchema);
+        });
+
+        startup.add("Characters database", [&]() -> bool
+        {
+            return CharactersDatabase.Open(backend, charactersConnection, charactersSchema);
+        });
+
+        // Reset all players online state, before anyone can log in
+        startup.add("Online status reset", []() -> bool
+        {
+            AuthDatabase.getStatement<AuthUpdateOnlineOnStart>()->execute(AuthUpdateOnlineOnStart::Parameters());
+            AuthDatabase.releaseSession();
+            return true;
+        }, std::vector<std::string>(1, "Auth database"));
+
+        startup.add("Server", []() -> bool
+        {
+            sServer = new Server();
+            return true;
+        });
+
+        startup.add("Grid system", []() -> bool
+        {
+            sGridLoader.instance();
+            return true;
+        });
+
+        // A missing DataStore does not stop the server, as it is logged
+        startup.add("Items", []() -> bool
+        {
+            sItemStore.read();
+            return true;
+        });
+
+        startup.add("Creatures", []() -> bool
+        {
+            sCreatureStore.read();
+            return true;
+        });
+
+        startup.add("Spawns", []() -> bool
+        {
+            sSpawnStore.read();
+            return true;
+        });
+
+        started = startup.run();
     }
 
-    // ------------------- //
-    // Read all DataStores //
-    // ------------------- //
+    if (!started)
     {
-        sItemStore.read("Items.ds");
+        sLog.out(Message::PRIO_CRITICAL, "[FAILED] The server could not start");
+
+        // Stop the workers of the databases which did open, nothing was
+        // queued on them yet
+        AuthDatabase.Close();
+        CharactersDatabase.Close();
+
+        if (sqlite)
+            SQLite::Connector::unregisterConnector();
+        else
+            MySQL::Connector::unregisterConnector();
+        Poco::ErrorHandler::set(oldErrorHandler);
+
+        return 1;
     }
 
     // Will wait until the server stops
     sServer->start(sConfig.getDefaultInt("ServerPort", 1616));
+
+    // Take the last state of the players before they are gone
+    sCharacterStore.releaseAll();
     
     delete sServer;
 
-    MySQL::Connector::unregisterConnector();
+    // Finish any pending query, and write the online status and characters
+    // still buffered
+    AuthDatabase.Close();
+    CharactersDatabase.Close();
+    sOnlineStatus.flush(true);
+    sCharacterStore.flush(true);
+
+    if (sqlite)
+        SQLite::Connector::unregisterConnector();
+    else
+        MySQL::Connector::unregisterConnector();
     Poco::ErrorHandler::set(oldErrorHandler);
     
     return 0;
@@ -0,0 +1,189 @@
+#include "SessionTickets.h"
+#include "ServerConfig.h"
+
+#include <string.h>
+
+#include <osrng.h>
+#include <sha.h>
+#include <hmac.h>
+
+// Signed part of the ticket, the signature follows it
+#define SESSION_TICKET_SIGNED   16
+
+// Labels of the keys derived on resume
+#define SESSION_KEY_HMAC        0x01
+#define SESSION_KEY_AES         0x02
+
+SessionTickets::SessionTickets()
+{
+    _ttl = sConfig.getDefaultInt("SessionTicketTTL", 60000);
+
+    // Tickets of a previous run are never valid
+    CryptoPP::AutoSeededRandomPool rng;
+    rng.GenerateBlock(_secret, sizeof(_secret));
+}
+
+/**
+ * Creates the ticket of a session which has entered the world. Any
+ * previous ticket of the account is no longer valid
+ *
+ * @param session Account, character and current keys of the session
+ * @param ticket Output, SESSION_TICKET_SIZE bytes to be sent to the client
+ */
+void SessionTickets::issue(const Session& session, Poco::UInt8* ticket)
+{
+    CryptoPP::AutoSeededRandomPool rng;
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    if (_lastPurge.elapsed() / 1000 >= _ttl)
+    {
+        _lastPurge.update();
+        purge();
+    }
+
+    AccountsMap::iterator itr = _accounts.find(session.account);
+    if (itr != _accounts.end())
+        _entries.erase(itr->second);
+
+    Poco::UInt64 nonce;
+    do
+    {
+        rng.GenerateBlock((Poco::UInt8*)&nonce, sizeof(nonce));
+    }
+    while (_entries.find(nonce) != _entries.end());
+
+    memcpy(ticket, &session.account, 4);
+    memcpy(ticket + 4, &session.character, 4);
+    memcpy(ticket + 8, &nonce, 8);
+    sign(ticket);
+
+    Entry& entry = _entries[nonce];
+    entry.session = session;
+    entry.suspended = false;
+    _accounts[session.account] = nonce;
+}
+
+/**
+ * Starts the TTL of the ticket of an account which has disconnected
+ *
+ * @param account Account id
+ */
+void SessionTickets::suspend(Poco::UInt32 account)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    AccountsMap::iterator itr = _accounts.find(account);
+    if (itr == _accounts.end())
+        return;
+
+    Entry& entry = _entries[itr->second];
+    entry.suspended = true;
+    entry.suspendedAt.update();
+}
+
+/**
+ * Invalidates the ticket of an account, which has logged in again
+ *
+ * @param account Account id
+ */
+void SessionTickets::revoke(Poco::UInt32 account)
+{
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    AccountsMap::iterator itr = _accounts.find(account);
+    if (itr == _accounts.end())
+        return;
+
+    _entries.erase(itr->second);
+    _accounts.erase(itr);
+}
+
+/**
+ * Validates a ticket and consumes it
+ *
+ * @param ticket SESSION_TICKET_SIZE bytes, as issued
+ * @param proof HMAC of the ticket and the challenge with the session key
+ * @param challenge Low part of the HMAC key sent on the new EHLO
+ * @param session Output, account, character and derived keys
+ * @return true if the session can be resumed
+ */
+bool SessionTickets::resume(Poco::UInt8* ticket, Poco::UInt8* proof, Poco::UInt8* challenge, Session& session)
+{
+    // Forged tickets are discarded before looking anything up
+    CryptoPP::HMAC<CryptoPP::SHA1> signer(_secret, sizeof(_secret));
+    if (!signer.VerifyDigest(ticket + SESSION_TICKET_SIGNED, ticket, SESSION_TICKET_SIGNED))
+        return false;
+
+    Poco::UInt64 nonce;
+    memcpy(&nonce, ticket + 8, 8);
+
+    Poco::FastMutex::ScopedLock lock(_mutex);
+
+    EntriesMap::iterator itr = _entries.find(nonce);
+    if (itr == _entries.end())
+        return false;
+
+    // Still playing, or it has been too long
+    Entry& entry = itr->second;
+    if (!entry.suspended || entry.suspendedAt.elapsed() / 1000 >= _ttl)
+        return false;
+
+    // Only the previous owner knows the key
+    CryptoPP::HMAC<CryptoPP::SHA1> verifier(entry.session.HMACKey, sizeof(entry.session.HMACKey));
+    verifier.Update(ticket, SESSION_TICKET_SIZE);
+    verifier.Update(challenge, 10);
+    if (!verifier.Verify(proof))
+        return false;
+
+    session.account = entry.session.account;
+    session.character = entry.session.character;
+    session.model = entry.session.model;
+    session.name = entry.session.name;
+
+    // New keys, bound to this connection EHLO
+    Poco::UInt8 label = SESSION_KEY_HMAC;
+    verifier.Update(entry.session.AESKey, sizeof(entry.session.AESKey));
+    verifier.Update(challenge, 10);
+    verifier.Update(&label, 1);
+    verifier.Final(session.HMACKey);
+
+    Poco::UInt8 digest[20];
+    label = SESSION_KEY_AES;
+    verifier.Update(entry.session.AESKey, sizeof(entry.session.AESKey));
+    verifier.Update(challenge, 10);
+    verifier.Update(&label, 1);
+    verifier.Final(digest);
+    memcpy(session.AESKey, digest, sizeof(session.AESKey));
+
+    _accounts.erase(session.account);
+    _entries.erase(itr);
+    return true;
+}
+
+/**
+ * Appends the signature to a ticket
+ *
+ * @param ticket Ticket with its signed part filled
+ */
+void SessionTickets::sign(Poco::UInt8* ticket)
+{
+    CryptoPP::HMAC<CryptoPP::SHA1> signer(_secret, sizeof(_secret));
+    signer.CalculateDigest(ticket + SESSION_TICKET_SIGNED, ticket, SESSION_TICKET_SIGNED);
+}
+
+// Must be called with _mutex held
+void SessionTickets::purge()
+{
+    EntriesMap::iterator itr = _entries.begin();
+    while (itr != _entries.end())
+    {
+        if (itr->second.suspended && itr->second.suspendedAt.elapsed() / 1000 >= _ttl)
+        {
+            _accounts.erase(itr->second.session.account);
+            _entries.erase(itr++);
+        }
+        else
+            ++itr;
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef GAMESERVER_SESSION_TICKETS_H
+#define GAMESERVER_SESSION_TICKETS_H
+
+#include <map>
+#include <string>
+
+#include "Poco/Poco.h"
+#include "Poco/Mutex.h"
+#include "Poco/Timestamp.h"
+
+// Account, character, nonce and signature
+#define SESSION_TICKET_SIZE     36
+#define SESSION_PROOF_SIZE      20
+
+/**
+ * Tickets given to the clients in world, to resume their session after a
+ * short disconnect. A ticket is signed with a per-run server secret, and the
+ * keys of the session it belongs to are kept in memory, so validating it
+ * needs no query. It can be used once, only while its session is suspended
+ * and before the TTL expires. The resuming client proves it owned the
+ * session by signing the ticket and the new EHLO with the old HMAC key,
+ * which the new keys are then derived from
+ */
+class SessionTickets
+{
+public:
+    struct Session
+    {
+        Poco::UInt32 account;
+        Poco::UInt32 character;
+        Poco::UInt32 model;
+        std::string name;
+        Poco::UInt8 HMACKey[20];
+        Poco::UInt8 AESKey[16];
+    };
+
+    SessionTickets();
+
+    void issue(const Session& session, Poco::UInt8* ticket);
+    void suspend(Poco::UInt32 account);
+    void revoke(Poco::UInt32 account);
+    bool resume(Poco::UInt8* ticket, Poco::UInt8* proof, Poco::UInt8* challenge, Session& session);
+
+private:
+    struct Entry
+    {
+        Session session;
+        bool suspended;
+        Poco::Timestamp suspendedAt;
+    };
+
+    typedef std::map<Poco::UInt64 /*nonce*/, Entry> EntriesMap;
+    typedef std::map<Poco::UInt32 /*account*/, Poco::UInt64 /*nonce*/> AccountsMap;
+
+    void sign(Poco::UInt8* ticket);
+    void purge();
+
+private:
+    EntriesMap _entries;
+    AccountsMap _accounts;
+    Poco::UInt8 _secret[20];
+    Poco::UInt32 _ttl;
+    Poco::Timestamp _lastPurge;
+    Poco::FastMutex _mutex;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "Spawner.h"
+#include "GridLoader.h"
+#include "MotionMaster.h"
+#include "Object.h"
+#include "ObjectManager.h"
+#include "Player.h"
+
+#include <algorithm>
+
+#define SPAWNER_SPOTS 8
+#define SPAWNER_SPOT_RADIUS 60.0f
+#define SPAWNER_LINE_DESTINATION Vector2D(2800, 1000)
+#define SPAWNER_LINE_ANGLE 0.5f
+#define SPAWNER_PI 3.14159265f
+
+static const char* PatternNames[] =
+{
+    "line",
+    "random",
+    "cluster",
+    NULL,
+};
+
+/**
+ * @param players Players to spawn
+ * @param creatures Creatures to spawn
+ * @param pattern Where objects are spawned and how they move
+ * @param seed Seed of the positions and movements
+ * @param perTick Objects spawned on each call to spawn
+ */
+Spawner::Spawner(Poco::UInt32 players, Poco::UInt32 creatures, Pattern pattern, Poco::UInt32 seed, Poco::UInt32 perTick):
+    _players(players), _creatures(creatures),
+    _pattern(pattern),
+    _perTick(perTick),
+    _random(seed),
+    _x(0), _z(0)
+{
+    Poco::UInt32 total = std::max(players + creatures, 1u);
+    _stepX = (MAP_MAX_X - MAP_MIN_X) / (float)total;
+    _stepZ = (MAP_MAX_Z - MAP_MIN_Z) / (float)total;
+
+    if (_pattern == PATTERN_CLUSTER)
+        for (Poco::UInt32 i = 0; i < SPAWNER_SPOTS; ++i)
+            _spots.push_back(getRandomPoint(MAP_MIN_X + SPAWNER_SPOT_RADIUS, MAP_MAX_X - SPAWNER_SPOT_RADIUS, MAP_MIN_Z + SPAWNER_SPOT_RADIUS, MAP_MAX_Z - SPAWNER_SPOT_RADIUS));
+}
+
+/**
+ * Spawns the next objects, two players for each creature while there are
+ * both left
+ */
+void Spawner::spawn()
+{
+    for (Poco::UInt32 i = 0; i < _perTick && !isDone(); ++i)
+    {
+        if (_players && (i % 3 != 0 || !_creatures))
+        {
+            Player* player = sObjectManager.createPlayer("Spawned", NULL);
+            player->Relocate(getPosition());
+            sGridLoader.addObject(player);
+            MotionMaster::StartSimpleMovement(player, getDestination(), SPEED_RUN);
+            --_players;
+        }
+        else
+        {
+            Object* creature = sObjectManager.create(HIGH_GUID_CREATURE);
+            creature->Relocate(getPosition());
+            sGridLoader.addObject(creature);
+
+            float angle = _pattern == PATTERN_LINE ? SPAWNER_LINE_ANGLE : random(0, 2 * SPAWNER_PI);
+            MotionMaster::StartAngleMovement(creature, angle, SPEED_WALK);
+            --_creatures;
+        }
+    }
+}
+
+/**
+ * Finds a pattern by its name, as given on the command line
+ *
+ * @param name Pattern name
+ * @param pattern Pattern found
+ * @return true if there is one by that name
+ */
+bool Spawner::findPattern(const std::string& name, Pattern& pattern)
+{
+    for (Poco::UInt32 i = 0; PatternNames[i]; ++i)
+    {
+        if (name == PatternNames[i])
+        {
+            pattern = Pattern(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Vector2D Spawner::getPosition()
+{
+    switch (_pattern)
+    {
+        case PATTERN_RANDOM:
+            return getRandomPoint(MAP_MIN_X, MAP_MAX_X, MAP_MIN_Z, MAP_MAX_Z);
+
+        case PATTERN_CLUSTER:
+            return getPointNearSpot();
+
+        default:
+        {
+            Vector2D position(_x, _z);
+            _x += _stepX;
+            _z += _stepZ;
+            return position;
+        }
+    }
+}
+
+Vector2D Spawner::getDestination()
+{
+    switch (_pattern)
+    {
+        case PATTERN_RANDOM:
+            return getRandomPoint(MAP_MIN_X, MAP_MAX_X, MAP_MIN_Z, MAP_MAX_Z);
+
+        case PATTERN_CLUSTER:
+            return getPointNearSpot();
+
+        default:
+            return SPAWNER_LINE_DESTINATION;
+    }
+}
+
+Vector2D Spawner::getPointNearSpot()
+{
+    const Vector2D& spot = _spots[_random() % _spots.size()];
+    return getRandomPoint(spot.x - SPAWNER_SPOT_RADIUS, spot.x + SPAWNER_SPOT_RADIUS, spot.z - SPAWNER_SPOT_RADIUS, spot.z + SPAWNER_SPOT_RADIUS);
+}
+
+// Coordinates are drawn one after the other, as the order in which
+// arguments are evaluated is not defined
+Vector2D Spawner::getRandomPoint(float minX, float maxX, float minZ, float maxZ)
+{
+    float x = random(minX, maxX);
+    float z = random(minZ, maxZ);
+    return Vector2D(x, z);
+}
+
+/**
+ * Draws a number from the seeded generator. Its raw output is used, rather
+ * than a distribution, which is not the same on every standard library
+ */
+float Spawner::random(float min, float max)
+{
+    return min + (max - min) * (float)(_random() / 4294967296.0);
+}
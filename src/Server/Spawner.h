@@ -0,0 +1,63 @@
+#ifndef GAMESERVER_SPAWNER_H
+#define GAMESERVER_SPAWNER_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Poco/Poco.h"
+
+#include "Position.h"
+
+/**
+ * Fills the world with players, which have no client, and creatures, a few
+ * of them on each tick. Positions and movements are drawn from a seed, so
+ * that a seed always gives the same population
+ */
+class Spawner
+{
+public:
+    enum Pattern
+    {
+        // Along the map diagonal, players run to a single point and
+        // creatures walk at a fixed angle. The seed is not used
+        PATTERN_LINE,
+        // Anywhere on the map, players run to random points and creatures
+        // walk at random angles
+        PATTERN_RANDOM,
+        // Around a few spots, so that most objects see each other
+        PATTERN_CLUSTER,
+    };
+
+    Spawner(Poco::UInt32 players, Poco::UInt32 creatures, Pattern pattern = PATTERN_LINE, Poco::UInt32 seed = 0, Poco::UInt32 perTick = 50);
+
+    void spawn();
+
+    inline bool isDone()
+    {
+        return !_players && !_creatures;
+    }
+
+    static bool findPattern(const std::string& name, Pattern& pattern);
+
+private:
+    Vector2D getPosition();
+    Vector2D getDestination();
+    Vector2D getPointNearSpot();
+    Vector2D getRandomPoint(float minX, float maxX, float minZ, float maxZ);
+    float random(float min, float max);
+
+private:
+    Poco::UInt32 _players;
+    Poco::UInt32 _creatures;
+    Pattern _pattern;
+    Poco::UInt32 _perTick;
+    std::mt19937 _random;
+    std::vector<Vector2D> _spots;
+    float _stepX;
+    float _stepZ;
+    float _x;
+    float _z;
+};
+
+#endif
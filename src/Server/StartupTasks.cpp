@@ -0,0 +1,160 @@
+#include "StartupTasks.h"
+#include "Log.h"
+
+#include <exception>
+
+#include "Poco/Exception.h"
+
+StartupTasks::~StartupTasks()
+{
+    for (std::vector<Task*>::iterator itr = _tasks.begin(); itr != _tasks.end(); ++itr)
+        delete *itr;
+}
+
+/**
+ * Adds a step
+ *
+ * @param name Name of the step, as logged and referred by other steps
+ * @param function Step, returns false if the server can not start
+ * @param dependencies Steps which must have finished before this one starts
+ */
+void StartupTasks::add(std::string name, const Function& function, const std::vector<std::string>& dependencies /*= std::vector<std::string>()*/)
+{
+    _tasks.push_back(new Task(this, name, function));
+    _dependencies.push_back(dependencies);
+}
+
+/**
+ * Runs all the steps, and waits for them. Once a step fails no other one
+ * is started
+ *
+ * @return true if all the steps have succeeded
+ */
+bool StartupTasks::run()
+{
+    // Resolve the dependencies names
+    for (Poco::UInt32 i = 0; i < _tasks.size(); ++i)
+    {
+        for (std::vector<std::string>::iterator name = _dependencies[i].begin(); name != _dependencies[i].end(); ++name)
+        {
+            Poco::UInt32 index = 0;
+            while (index < _tasks.size() && _tasks[index]->name != *name)
+                ++index;
+
+            if (index == _tasks.size())
+            {
+                sLog.out(Message::PRIO_CRITICAL, "Startup step %s depends on the unknown step %s", _tasks[i]->name.c_str(), name->c_str());
+                return false;
+            }
+
+            _tasks[i]->dependencies.push_back(index);
+        }
+    }
+
+    Poco::Timestamp start;
+    Poco::Timestamp::TimeDiff work = 0;
+    Poco::UInt32 running = 0;
+    bool failed = false;
+
+    while (true)
+    {
+        {
+            Poco::FastMutex::ScopedLock lock(_mutex);
+
+            for (std::vector<Task*>::iterator itr = _tasks.begin(); itr != _tasks.end(); ++itr)
+            {
+                Task* task = *itr;
+                if (task->state == STATE_FINISHED)
+                {
+                    task->thread.join();
+                    task->state = STATE_DONE;
+                    --running;
+                    work += task->elapsed;
+
+                    if (task->success)
+                        sLog.out(Message::PRIO_INFORMATION, "\t[OK] %s (%d ms)", task->name.c_str(), (int)(task->elapsed / 1000));
+                    else
+                    {
+                        sLog.out(Message::PRIO_CRITICAL, "\t[FAILED] %s (%d ms)", task->name.c_str(), (int)(task->elapsed / 1000));
+                        failed = true;
+                    }
+                }
+            }
+
+            for (std::vector<Task*>::iterator itr = _tasks.begin(); itr != _tasks.end() && !failed; ++itr)
+            {
+                Task* task = *itr;
+                if (task->state == STATE_PENDING && isReady(task))
+                {
+                    task->state = STATE_RUNNING;
+                    ++running;
+                    task->thread.start(*task);
+                }
+            }
+        }
+
+        if (!running)
+            break;
+
+        _finished.wait();
+    }
+
+    if (failed)
+        return false;
+
+    for (std::vector<Task*>::iterator itr = _tasks.begin(); itr != _tasks.end(); ++itr)
+    {
+        if ((*itr)->state != STATE_DONE)
+        {
+            sLog.out(Message::PRIO_CRITICAL, "Startup step %s is part of a dependency cycle", (*itr)->name.c_str());
+            return false;
+        }
+    }
+
+    sLog.out(Message::PRIO_INFORMATION, "[OK] Started in %d ms, %d ms of steps", (int)(start.elapsed() / 1000), (int)(work / 1000));
+    return true;
+}
+
+// Must be called with _mutex held
+bool StartupTasks::isReady(Task* task)
+{
+    for (std::vector<Poco::UInt32>::iterator itr = task->dependencies.begin(); itr != task->dependencies.end(); ++itr)
+        if (_tasks[*itr]->state != STATE_DONE)
+            return false;
+
+    return true;
+}
+
+StartupTasks::Task::Task(StartupTasks* owner, std::string name, const Function& function):
+    name(name), function(function), state(STATE_PENDING), success(false), elapsed(0), _owner(owner)
+{
+}
+
+/**
+ * Runs the step on its own thread, and wakes up the starting thread
+ */
+void StartupTasks::Task::run()
+{
+    Poco::Timestamp start;
+
+    try
+    {
+        success = function();
+    }
+    catch (Poco::Exception& ex)
+    {
+        sLog.out(Message::PRIO_CRITICAL, "Startup step %s failed: %s", name.c_str(), ex.displayText().c_str());
+        success = false;
+    }
+    catch (std::exception& ex)
+    {
+        sLog.out(Message::PRIO_CRITICAL, "Startup step %s failed: %s", name.c_str(), ex.what());
+        success = false;
+    }
+
+    elapsed = start.elapsed();
+
+    Poco::FastMutex::ScopedLock lock(_owner->_mutex);
+    state = STATE_FINISHED;
+    _owner->_finished.set();
+}
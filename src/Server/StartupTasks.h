@@ -0,0 +1,67 @@
+#ifndef GAMESERVER_STARTUP_TASKS_H
+#define GAMESERVER_STARTUP_TASKS_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Poco/Poco.h"
+#include "Poco/Event.h"
+#include "Poco/Mutex.h"
+#include "Poco/Runnable.h"
+#include "Poco/Thread.h"
+#include "Poco/Timestamp.h"
+
+/**
+ * Startup steps and their dependencies. Each step runs on its own thread as
+ * soon as all its dependencies have finished, so independent steps overlap.
+ * The time of each step is logged, along with the total time
+ */
+class StartupTasks
+{
+public:
+    typedef std::function<bool ()> Function;
+
+    ~StartupTasks();
+
+    void add(std::string name, const Function& function, const std::vector<std::string>& dependencies = std::vector<std::string>());
+    bool run();
+
+private:
+    enum State
+    {
+        STATE_PENDING,
+        STATE_RUNNING,
+        STATE_FINISHED,
+        STATE_DONE,
+    };
+
+    class Task : public Poco::Runnable
+    {
+    public:
+        Task(StartupTasks* owner, std::string name, const Function& function);
+
+        void run();
+
+        std::string name;
+        Function function;
+        std::vector<Poco::UInt32> dependencies;
+        State state;
+        bool success;
+        Poco::Timestamp::TimeDiff elapsed;
+        Poco::Thread thread;
+
+    private:
+        StartupTasks* _owner;
+    };
+
+    bool isReady(Task* task);
+
+private:
+    std::vector<Task*> _tasks;
+    std::vector<std::vector<std::string> > _dependencies;
+    Poco::Event _finished;
+    Poco::FastMutex _mutex;
+};
+
+#endif
@@ -26,24 +26,26 @@ namespace Tools
 		return f;
 	}
 
-    Poco::UInt16 GetXCellFromPos(double x)
+    // All the cell and sector math is done in single precision floats, the
+    // grid movement tables rely on it to detect sector crossings
+    Poco::UInt16 GetXCellFromPos(float x)
     {
         return (int)((x - MAP_MIN_X) / UNITS_PER_CELL) + 1;
     }
 
-    Poco::UInt16 GetYCellFromPos(double z)
+    Poco::UInt16 GetYCellFromPos(float z)
     {
         return (int)((z - MAP_MIN_Z) / UNITS_PER_CELL) + 1;
     }
 
     Poco::UInt16 GetPositionInXCell(Poco::UInt16 cell, float x)
     {
-        return Poco::UInt16((((cell - 1) * UNITS_PER_CELL) - (x - MAP_MIN_X)));
+        return Poco::UInt16((x - MAP_MIN_X) - (float)((cell - 1) * UNITS_PER_CELL));
     }
 
     Poco::UInt16 GetPositionInYCell(Poco::UInt16 cell, float z)
     {
-        return Poco::UInt16((((cell - 1) * UNITS_PER_CELL) - (z - MAP_MIN_Z)));
+        return Poco::UInt16((z - MAP_MIN_Z) - (float)((cell - 1) * UNITS_PER_CELL));
     }
 
     // Hash code 0 is not valid
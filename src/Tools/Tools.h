@@ -11,8 +11,8 @@ namespace Tools
     Poco::UInt32 getU32(float value);
     float u32tof(Poco::UInt32 value);
 
-    Poco::UInt16 GetXCellFromPos(double x);
-    Poco::UInt16 GetYCellFromPos(double z);
+    Poco::UInt16 GetXCellFromPos(float x);
+    Poco::UInt16 GetYCellFromPos(float z);
 
     Poco::UInt16 GetPositionInXCell(Poco::UInt16 cell, float x);
     Poco::UInt16 GetPositionInYCell(Poco::UInt16 cell, float z);